@@ -0,0 +1,266 @@
+#include "Chip8/Emulator/Processor.hpp"
+#include "Chip8/Benchmark/BenchmarkTimer.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times individual OpCode handlers and the fetch + dispatch path of newCycle.
+// Usage: Chip8OpcodeBenchmark [--repetitions N] [--iterations N] [--output file.json]
+class Chip8ProcessorBenchmark
+{
+public:
+	Chip8ProcessorBenchmark(int repetitions, long iterations)
+		: m_repetitions(repetitions)
+		, m_iterations(iterations)
+	{
+		m_processor.initialize();
+		m_processor.traceFlag = 0;
+	}
+
+	void runAll()
+	{
+		Chip8Processor & p = m_processor;
+
+		// The handlers that depend on the quirk profile are timed with the default SUPER-CHIP behaviour unless noted otherwise
+
+		// 8124 - ADD V1, V2
+		measure("ADDvxvy", [&p]() { p.ADDvxvy(0x8124); });
+
+		// 00E0 - CLS
+		measure("CLS", [&p]() { p.CLS(0x00E0); });
+
+		// Cxkk - RND V0, 0xFF
+		measure("RNDvxbyte", [&p]() { p.RNDvxbyte(0xC0FF); });
+
+		// Dxyn - DRW V0, V1, n with the sprite data pointing at the fontset, drawing twice restores the framebuffer
+		for (word height : { 1, 2, 4, 8, 15 })
+		{
+			std::string name = "DRWvxvynibble/n=" + std::to_string(height);
+			word opCode = 0xD010 | height;
+			measure(name.c_str(), [&p, opCode]() { p.m_I = 0; p.m_V[0] = 0; p.m_V[1] = 0; p.DRWvxvynibble<SuperChipQuirks>(opCode); });
+		}
+
+		// 00Cn - SCD n, 00FB - SCR, and 00FC - SCL on the 64x32 and the SUPER-CHIP 128x64 display
+		for (DisplayMode mode : { DisplayMode::LORES, DisplayMode::SCHIP_HIRES })
+		{
+			std::string suffix = mode == DisplayMode::LORES ? "/64x32" : "/128x64";
+			p.setDisplayMode(mode);
+
+			measure(("SCDnibble" + suffix).c_str(), [&p]() { p.SCDnibble(0x00C4); });
+			measure(("SCR" + suffix).c_str(), [&p]() { p.SCR(0x00FB); });
+			measure(("SCL" + suffix).c_str(), [&p]() { p.SCL(0x00FC); });
+
+			// Dxy0 - DRW V0, V1, 0 draws a 16x16 sprite, at an X coordinate that straddles the words of a 128 pixel row
+			measure(("DRWvxvynibble/n=0" + suffix).c_str(), [&p]() { p.m_I = 0x50; p.m_V[0] = 60; p.m_V[1] = 0; p.DRWvxvynibble<SuperChipQuirks>(0xD010); });
+		}
+
+		p.setDisplayMode(DisplayMode::LORES);
+
+		// Dxyn - DRW V0, V1, 8 across the bottom right corner, where the profiles either clip or wrap the sprite
+		measure("DRWvxvynibble/n=8/vip", [&p]() { p.m_I = 0; p.m_V[0] = 60; p.m_V[1] = 28; p.DRWvxvynibble<CosmacVipQuirks>(0xD018); });
+		measure("DRWvxvynibble/n=8/chip48", [&p]() { p.m_I = 0; p.m_V[0] = 60; p.m_V[1] = 28; p.DRWvxvynibble<Chip48Quirks>(0xD018); });
+		measure("DRWvxvynibble/n=8/schip", [&p]() { p.m_I = 0; p.m_V[0] = 60; p.m_V[1] = 28; p.DRWvxvynibble<SuperChipQuirks>(0xD018); });
+		measure("DRWvxvynibble/n=8/xochip", [&p]() { p.m_I = 0; p.m_V[0] = 60; p.m_V[1] = 28; p.DRWvxvynibble<XoChipQuirks>(0xD018); });
+
+		// XO-CHIP draws on every selected plane, so the cost of DRW grows with the number of planes
+		for (byte planeMask : { 1, 2, 3 })
+		{
+			std::string name = "DRWvxvynibble/n=8/plane_mask=" + std::to_string(planeMask);
+			p.m_planeCount = 2;
+			p.m_planeMask = planeMask;
+			measure(name.c_str(), [&p]() { p.m_I = 0; p.m_V[0] = 0; p.m_V[1] = 0; p.DRWvxvynibble<XoChipQuirks>(0xD018); });
+		}
+
+		p.m_planeCount = 1;
+		p.m_planeMask = 1;
+
+		// Fx55 - LD [I], Vx and Fx65 - LD Vx, [I]
+		for (word x = 0; x < 16; ++x)
+		{
+			std::string storeName = "LDivx/x=" + std::to_string(x);
+			std::string loadName = "LDvxi/x=" + std::to_string(x);
+			word storeOpCode = 0xF055 | (x << 8);
+			word loadOpCode = 0xF065 | (x << 8);
+
+			measure(storeName.c_str(), [&p, storeOpCode]() { p.m_I = 0x300; p.LDivx<SuperChipQuirks>(storeOpCode); });
+			measure(loadName.c_str(), [&p, loadOpCode]() { p.m_I = 0x300; p.LDvxi<SuperChipQuirks>(loadOpCode); });
+		}
+
+		// Baseline for the dispatch measurement: the handler that the newCycle loop below executes
+		measure("LDvxbyte", [&p]() { p.LDvxbyte(0x6000); });
+
+		// Fill the 4 KB program space with "6000 - LD V0, 0x00" followed by "1200 - JP 0x200" to loop forever
+		const word PROGRAM_END = 0x1000;
+		for (word address = 0x200; address < PROGRAM_END - 2; address += 2)
+		{
+			p.m_memory[address + 0] = 0x60;
+			p.m_memory[address + 1] = 0x00;
+		}
+
+		p.m_memory[PROGRAM_END - 2] = 0x12;
+		p.m_memory[PROGRAM_END - 1] = 0x00;
+		p.m_PC = 0x200;
+
+		measure("newCycle/LDvxbyte", [&p]() { p.newCycle(); });
+
+		// Fetch + decode + dispatch overhead is the full cycle minus the handler itself
+		Result dispatch = findResult("newCycle/LDvxbyte");
+		Result handler = findResult("LDvxbyte");
+		dispatch.name = "newCycle/dispatch_overhead";
+		dispatch.nsPerOp -= handler.nsPerOp;
+		dispatch.nsPerOpMin -= handler.nsPerOpMin;
+		dispatch.ticksPerOp -= handler.ticksPerOp;
+		m_results.push_back(dispatch);
+	}
+
+	void writeJson(FILE *file) const
+	{
+		fprintf(file, "{\n");
+		fprintf(file, "  \"benchmark\": \"opcode\",\n");
+		fprintf(file, "  \"repetitions\": %i,\n", m_repetitions);
+		fprintf(file, "  \"iterations\": %li,\n", m_iterations);
+		fprintf(file, "  \"has_rdtsc\": %s,\n", BenchmarkTimer::hasTicks() ? "true" : "false");
+		fprintf(file, "  \"results\": [\n");
+
+		for (size_t i = 0; i < m_results.size(); ++i)
+		{
+			const Result & result = m_results[i];
+			fprintf(file, "    { \"name\": \"%s\", \"ns_per_op\": %.4f, \"ns_per_op_min\": %.4f, \"ns_per_op_mad\": %.4f, \"ticks_per_op\": %.4f }%s\n",
+				result.name.c_str(), result.nsPerOp, result.nsPerOpMin, result.nsPerOpMad, result.ticksPerOp,
+				i + 1 < m_results.size() ? "," : "");
+		}
+
+		fprintf(file, "  ]\n");
+		fprintf(file, "}\n");
+	}
+
+	void printSummary(FILE *file) const
+	{
+		fprintf(file, "%-28s %12s %12s %12s\n", "Benchmark", "ns/op", "min ns/op", "ticks/op");
+
+		for (const Result & result : m_results)
+			fprintf(file, "%-28s %12.3f %12.3f %12.3f\n", result.name.c_str(), result.nsPerOp, result.nsPerOpMin, result.ticksPerOp);
+	}
+
+private:
+	struct Result
+	{
+		std::string name;
+		double nsPerOp;		// Median over all repetitions
+		double nsPerOpMin;	// Fastest repetition
+		double nsPerOpMad;	// Median absolute deviation, a measure of how stable the result is
+		double ticksPerOp;	// Median time stamp counter ticks (zero when rdtsc is unavailable)
+	};
+
+	template <typename Operation>
+	void measure(const char *name, Operation operation)
+	{
+		// Warm up the caches and the branch predictor before taking any measurements
+		for (long i = 0; i < m_iterations; ++i)
+			operation();
+
+		std::vector<double> nanoseconds;
+		std::vector<double> ticks;
+
+		BenchmarkTimer timer;
+		for (int repetition = 0; repetition < m_repetitions; ++repetition)
+		{
+			timer.start();
+			for (long i = 0; i < m_iterations; ++i)
+				operation();
+			timer.stop();
+
+			nanoseconds.push_back(timer.elapsedNanoseconds() / m_iterations);
+			ticks.push_back(static_cast<double>(timer.elapsedTicks()) / m_iterations);
+		}
+
+		Result result;
+		result.name = name;
+		result.nsPerOp = median(nanoseconds);
+		result.nsPerOpMin = *std::min_element(nanoseconds.begin(), nanoseconds.end());
+		result.ticksPerOp = median(ticks);
+
+		for (double & value : nanoseconds)
+			value = std::fabs(value - result.nsPerOp);
+
+		result.nsPerOpMad = median(nanoseconds);
+
+		m_results.push_back(result);
+	}
+
+	Result findResult(const char *name) const
+	{
+		for (const Result & result : m_results)
+		{
+			if (result.name == name)
+				return result;
+		}
+
+		return Result();
+	}
+
+	static double median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+
+private:
+	Chip8Processor m_processor;
+	std::vector<Result> m_results;
+
+	int m_repetitions;
+	long m_iterations;
+};
+
+int main(int argc, char const *argv[])
+{
+	int repetitions = 15;
+	long iterations = 100000;
+	const char *outputPath = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+			repetitions = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			iterations = std::max(1L, atol(argv[++i]));
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			outputPath = argv[++i];
+		else
+		{
+			printf("Usage: %s [--repetitions N] [--iterations N] [--output file.json]\n", argv[0]);
+			return -1;
+		}
+	}
+
+	Chip8ProcessorBenchmark benchmark(repetitions, iterations);
+	benchmark.runAll();
+
+	// The human readable summary goes to stderr so stdout only contains JSON
+	benchmark.printSummary(stderr);
+
+	if (outputPath == nullptr)
+	{
+		benchmark.writeJson(stdout);
+		return 0;
+	}
+
+	FILE *outputFile = fopen(outputPath, "w");
+	if (outputFile == nullptr)
+	{
+		printf("Failed to open %s.\n", outputPath);
+		return -1;
+	}
+
+	benchmark.writeJson(outputFile);
+	fclose(outputFile);
+
+	return 0;
+}
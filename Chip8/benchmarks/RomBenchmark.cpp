@@ -0,0 +1,430 @@
+#include "Chip8/Emulator/HeadlessRunner.hpp"
+#include "Chip8/Emulator/Quirks.hpp"
+#include "Chip8/Benchmark/BenchmarkTimer.hpp"
+#include "Chip8/Benchmark/PerfCounters.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/RomLibrary.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Runs every ROM in the given directories headless for a fixed number of frames and records throughput and state hashes.
+// Usage: Chip8RomBenchmark [directories...] [--frames N] [--cycles-per-frame N] [--repeats N] [--seed N] [--input script.txt]
+//                          [--quirks auto|vip|chip48|schip|xochip] [--rom-database path] [--output results.json]
+//                          [--save baseline.tsv] [--compare baseline.tsv] [--threshold percent] [--perf]
+// With automatic quirks every ROM runs with the profile of its database entry or of the heuristics, at the fixed speed.
+// The whole set of ROMs runs several times and every ROM reports its run with the median throughput. Interleaving the
+// repeats spreads a disturbance of the machine over the runs of many ROMs instead of all runs of a few.
+struct RomResult
+{
+	std::string name;
+	QuirkProfile quirkProfile;
+	double instructionsPerSecond;
+	double frameTimeP50;	// Nanoseconds
+	double frameTimeP90;	// Nanoseconds
+	double frameTimeP99;	// Nanoseconds
+	unsigned long long stateHash;
+
+	// Hardware / software performance counters, summed over all frames and the worst single frame
+	unsigned long long perfTotal[PerfCounters::COUNTER_COUNT];
+	unsigned long long perfMaxFrame[PerfCounters::COUNTER_COUNT];
+};
+
+struct BenchmarkSettings
+{
+	std::vector<std::string> directories;
+	long frames = 6000;
+	int cyclesPerFrame = 10;
+	int repeats = 5;
+	unsigned int seed = 1;
+	QuirkProfile quirkProfile = QuirkProfile::SUPER_CHIP;
+	bool detectQuirks = true;
+	const char *romDatabasePath = "roms/RomDatabase.tsv";
+	const char *inputScript = nullptr;
+	const char *outputPath = nullptr;
+	const char *savePath = nullptr;
+	const char *comparePath = nullptr;
+	double threshold = 10.0;
+	bool perf = false;
+};
+
+static double percentile(std::vector<double> & sortedValues, double fraction)
+{
+	size_t index = static_cast<size_t>(fraction * (sortedValues.size() - 1) + 0.5);
+	return sortedValues[index];
+}
+
+static bool runRom(const std::string & path, const BenchmarkSettings & settings, const Chip8RomDatabase & database, PerfCounters & counters,
+	RomResult & result)
+{
+	HeadlessRunner runner;
+	runner.setCyclesPerFrame(settings.cyclesPerFrame);
+	runner.setSeed(settings.seed);
+
+	if (!runner.loadGame(path.c_str()))
+		return false;
+
+	result.quirkProfile = settings.detectQuirks ? runner.analyzeGame(&database).quirkProfile : settings.quirkProfile;
+	runner.setQuirkProfile(result.quirkProfile);
+
+	if (settings.inputScript != nullptr)
+	{
+		if (!runner.loadInputScript(settings.inputScript))
+			return false;
+	}
+	else
+	{
+		runner.setRandomInput(true);
+	}
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(settings.frames);
+
+	BenchmarkTimer frameTimer;
+	double totalNanoseconds = 0.0;
+
+	for (int i = 0; i < PerfCounters::COUNTER_COUNT; ++i)
+	{
+		result.perfTotal[i] = 0;
+		result.perfMaxFrame[i] = 0;
+	}
+
+	for (long frame = 0; frame < settings.frames; ++frame)
+	{
+		// The counters are read outside of the timed region so the system calls do not show up in the frame times
+		if (settings.perf)
+			counters.start();
+
+		frameTimer.start();
+		runner.runFrame();
+		frameTimer.stop();
+
+		if (settings.perf)
+		{
+			counters.stop();
+
+			for (int i = 0; i < PerfCounters::COUNTER_COUNT; ++i)
+			{
+				unsigned long long value = counters.getValue(static_cast<PerfCounters::Counter>(i));
+				result.perfTotal[i] += value;
+				result.perfMaxFrame[i] = std::max(result.perfMaxFrame[i], value);
+			}
+		}
+
+		frameTimes.push_back(frameTimer.elapsedNanoseconds());
+		totalNanoseconds += frameTimes.back();
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	result.name = path;
+	result.instructionsPerSecond = totalNanoseconds > 0.0 ? runner.getInstructionCount() / (totalNanoseconds * 1.0e-9) : 0.0;
+	result.frameTimeP50 = percentile(frameTimes, 0.50);
+	result.frameTimeP90 = percentile(frameTimes, 0.90);
+	result.frameTimeP99 = percentile(frameTimes, 0.99);
+	result.stateHash = runner.hashState();
+
+	return true;
+}
+
+// The runs are deterministic, so they only differ in their timings
+static RomResult getMedianRun(std::vector<RomResult> runs)
+{
+	std::sort(runs.begin(), runs.end(), [](const RomResult & left, const RomResult & right)
+	{
+		return left.instructionsPerSecond < right.instructionsPerSecond;
+	});
+
+	return runs[runs.size() / 2];
+}
+
+static void writePerfJson(FILE *file, const BenchmarkSettings & settings, const PerfCounters & counters, const RomResult & result)
+{
+	fprintf(file, ", \"perf\": {");
+
+	bool first = true;
+	for (int i = 0; i < PerfCounters::COUNTER_COUNT; ++i)
+	{
+		PerfCounters::Counter counter = static_cast<PerfCounters::Counter>(i);
+		if (!counters.isAvailable(counter))
+			continue;
+
+		fprintf(file, "%s \"%s\": { \"total\": %llu, \"per_frame\": %.1f, \"max_frame\": %llu }",
+			first ? "" : ",", PerfCounters::getName(counter), result.perfTotal[i],
+			static_cast<double>(result.perfTotal[i]) / settings.frames, result.perfMaxFrame[i]);
+
+		first = false;
+	}
+
+	fprintf(file, " }");
+}
+
+static void writeJson(FILE *file, const BenchmarkSettings & settings, const PerfCounters & counters, const std::vector<RomResult> & results)
+{
+	fprintf(file, "{\n");
+	fprintf(file, "  \"benchmark\": \"rom\",\n");
+	fprintf(file, "  \"frames\": %li,\n", settings.frames);
+	fprintf(file, "  \"cycles_per_frame\": %i,\n", settings.cyclesPerFrame);
+	fprintf(file, "  \"repeats\": %i,\n", settings.repeats);
+	fprintf(file, "  \"seed\": %u,\n", settings.seed);
+	fprintf(file, "  \"quirks\": \"%s\",\n", settings.detectQuirks ? "auto" : getQuirkProfileName(settings.quirkProfile));
+	fprintf(file, "  \"results\": [\n");
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const RomResult & result = results[i];
+
+		// ROM names contain no quotes or backslashes apart from Windows path separators, which generic_string() already converted
+		fprintf(file, "    { \"rom\": \"%s\", \"quirks\": \"%s\", \"instructions_per_second\": %.1f, \"frame_ns_p50\": %.1f, \"frame_ns_p90\": %.1f, \"frame_ns_p99\": %.1f, \"state_hash\": \"%016llX\"",
+			result.name.c_str(), getQuirkProfileName(result.quirkProfile), result.instructionsPerSecond, result.frameTimeP50, result.frameTimeP90, result.frameTimeP99, result.stateHash);
+
+		if (settings.perf)
+			writePerfJson(file, settings, counters, result);
+
+		fprintf(file, " }%s\n", i + 1 < results.size() ? "," : "");
+	}
+
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+// Baselines are tab separated: ROM path, instructions per second, state hash
+static bool saveBaseline(const char *path, const std::vector<RomResult> & results)
+{
+	FILE *filePtr = fopen(path, "w");
+
+	if (filePtr == nullptr)
+		return false;
+
+	for (const RomResult & result : results)
+		fprintf(filePtr, "%s\t%.1f\t%016llX\n", result.name.c_str(), result.instructionsPerSecond, result.stateHash);
+
+	fclose(filePtr);
+	return true;
+}
+
+static bool loadBaseline(const char *path, std::map<std::string, RomResult> & baseline)
+{
+	FILE *filePtr = fopen(path, "r");
+
+	if (filePtr == nullptr)
+		return false;
+
+	char line[1024];
+	while (fgets(line, sizeof(line), filePtr) != nullptr)
+	{
+		char *firstTab = strchr(line, '\t');
+		if (firstTab == nullptr)
+			continue;
+
+		*firstTab = '\0';
+
+		RomResult result = {};
+		result.name = line;
+		if (sscanf(firstTab + 1, "%lf %llX", &result.instructionsPerSecond, &result.stateHash) == 2)
+			baseline[result.name] = result;
+	}
+
+	fclose(filePtr);
+	return true;
+}
+
+// Returns the number of regressions, ROMs of the baseline that did not run count as regressions as well
+static int compareWithBaseline(const std::map<std::string, RomResult> & baseline, const std::vector<RomResult> & results, double threshold)
+{
+	int regressions = 0;
+	std::set<std::string> names;
+
+	for (const RomResult & result : results)
+	{
+		names.insert(result.name);
+
+		auto found = baseline.find(result.name);
+		if (found == baseline.end())
+		{
+			printf("NEW        %s\n", result.name.c_str());
+			continue;
+		}
+
+		const RomResult & previous = found->second;
+		double change = previous.instructionsPerSecond > 0.0 ? 100.0 * (result.instructionsPerSecond / previous.instructionsPerSecond - 1.0) : 0.0;
+
+		if (result.stateHash != previous.stateHash)
+		{
+			printf("HASH       %s (%016llX -> %016llX)\n", result.name.c_str(), previous.stateHash, result.stateHash);
+			++regressions;
+		}
+
+		if (change < -threshold)
+		{
+			printf("SLOWER     %s (%+.1f%%)\n", result.name.c_str(), change);
+			++regressions;
+		}
+	}
+
+	for (const auto & entry : baseline)
+	{
+		if (names.count(entry.first) == 0)
+		{
+			printf("MISSING    %s\n", entry.first.c_str());
+			++regressions;
+		}
+	}
+
+	printf("%i regression(s) against %zu baseline entries.\n", regressions, baseline.size());
+	return regressions;
+}
+
+int main(int argc, char const *argv[])
+{
+	BenchmarkSettings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			settings.frames = std::max(1L, atol(argv[++i]));
+		else if (strcmp(argv[i], "--cycles-per-frame") == 0 && i + 1 < argc)
+			settings.cyclesPerFrame = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc)
+			settings.repeats = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			settings.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+			settings.inputScript = argv[++i];
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			settings.outputPath = argv[++i];
+		else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+			settings.savePath = argv[++i];
+		else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+			settings.comparePath = argv[++i];
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+			settings.threshold = atof(argv[++i]);
+		else if (strcmp(argv[i], "--perf") == 0)
+			settings.perf = true;
+		else if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc && strcmp(argv[i + 1], "auto") == 0)
+		{
+			settings.detectQuirks = true;
+			++i;
+		}
+		else if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc && parseQuirkProfile(argv[i + 1], settings.quirkProfile))
+		{
+			settings.detectQuirks = false;
+			++i;
+		}
+		else if (strcmp(argv[i], "--rom-database") == 0 && i + 1 < argc)
+			settings.romDatabasePath = argv[++i];
+		else if (argv[i][0] == '-')
+		{
+			printf("Usage: %s [directories...] [--frames N] [--cycles-per-frame N] [--repeats N] [--seed N] [--input script.txt]\n", argv[0]);
+			printf("       [--quirks auto|vip|chip48|schip|xochip] [--rom-database path] [--output results.json] [--save baseline.tsv]\n");
+			printf("       [--compare baseline.tsv] [--threshold percent] [--perf]\n");
+			return -1;
+		}
+		else
+			settings.directories.push_back(argv[i]);
+	}
+
+	// The ROM folders are copied next to the executable by the build
+	if (settings.directories.empty())
+		settings.directories = { "roms/games", "roms/demos", "roms/programs" };
+
+	PerfCounters counters;
+	if (settings.perf && !counters.open())
+	{
+		printf("Failed to open any performance counters, continuing without them.\n");
+		settings.perf = false;
+	}
+
+	// Without the database every ROM is analyzed
+	Chip8RomDatabase database;
+	if (settings.detectQuirks && !database.load(settings.romDatabasePath))
+		printf("Failed to load the ROM database %s, picking quirks with the heuristics only.\n", settings.romDatabasePath);
+
+	std::vector<std::string> roms = Chip8RomLibrary::findRoms(settings.directories);
+	std::vector<std::vector<RomResult>> runs(roms.size());
+	std::vector<bool> failed(roms.size(), false);
+
+	for (int repeat = 0; repeat < settings.repeats; ++repeat)
+	{
+		for (size_t i = 0; i < roms.size(); ++i)
+		{
+			RomResult run;
+			if (failed[i] || !runRom(roms[i], settings, database, counters, run))
+			{
+				failed[i] = true;
+				continue;
+			}
+
+			runs[i].push_back(run);
+		}
+	}
+
+	std::vector<RomResult> results;
+	for (size_t romIndex = 0; romIndex < roms.size(); ++romIndex)
+	{
+		const std::string & path = roms[romIndex];
+		if (failed[romIndex])
+		{
+			fprintf(stderr, "Failed to run %s.\n", path.c_str());
+			continue;
+		}
+
+		RomResult result = getMedianRun(runs[romIndex]);
+
+		fprintf(stderr, "%-70s %-7s %12.0f instr/s  p50 %9.0f ns  p99 %9.0f ns  %016llX\n",
+			path.c_str(), getQuirkProfileName(result.quirkProfile), result.instructionsPerSecond, result.frameTimeP50, result.frameTimeP99, result.stateHash);
+
+		if (settings.perf)
+		{
+			for (int i = 0; i < PerfCounters::COUNTER_COUNT; ++i)
+			{
+				PerfCounters::Counter counter = static_cast<PerfCounters::Counter>(i);
+				if (counters.isAvailable(counter))
+					fprintf(stderr, "    %-20s %14.1f per frame\n", PerfCounters::getName(counter), static_cast<double>(result.perfTotal[i]) / settings.frames);
+			}
+		}
+
+		results.push_back(result);
+	}
+
+	if (settings.outputPath != nullptr)
+	{
+		FILE *outputFile = fopen(settings.outputPath, "w");
+		if (outputFile == nullptr)
+		{
+			printf("Failed to open %s.\n", settings.outputPath);
+			return -1;
+		}
+
+		writeJson(outputFile, settings, counters, results);
+		fclose(outputFile);
+	}
+
+	if (settings.savePath != nullptr && !saveBaseline(settings.savePath, results))
+	{
+		printf("Failed to save the baseline to %s.\n", settings.savePath);
+		return -1;
+	}
+
+	if (settings.comparePath != nullptr)
+	{
+		std::map<std::string, RomResult> baseline;
+		if (!loadBaseline(settings.comparePath, baseline))
+		{
+			printf("Failed to load the baseline from %s.\n", settings.comparePath);
+			return -1;
+		}
+
+		// A non-zero exit code makes the comparison usable as a gate
+		if (compareWithBaseline(baseline, results, settings.threshold) > 0)
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// Measures the time from launching the emulator process to its first presented frame, once without the shader cache
+// (every launch compiles) and once with a warm cache. The emulator is started through the shell, so the numbers include
+// the cost of spawning a shell. Run it from the folder that contains the emulator, under Xvfb on a machine without a
+// display (LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./Chip8StartupBenchmark).
+// Usage: Chip8StartupBenchmark [ROM path] [--runs N] [--emulator path] [--cache path]
+struct StartupSettings
+{
+	const char *romPath = "roms/games/Breakout [Carmelo Cortez, 1979].ch8";
+	const char *emulatorPath = "./Chip8";
+	const char *cachePath = "Chip8StartupBenchmark.shadercache";
+	int runs = 10;
+};
+
+// Returns the startup time in milliseconds as reported by the emulator, or a negative value when the launch failed
+static double launch(const StartupSettings & settings, const char *cachePath)
+{
+	long long launchTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	std::string command = std::string("\"") + settings.emulatorPath + "\" \"" + settings.romPath + "\"" +
+		" --shader-cache \"" + cachePath + "\"" +
+		" --launch-time " + std::to_string(launchTime) +
+		" --exit-after-first-frame";
+
+	FILE *pipe = popen(command.c_str(), "r");
+	if (pipe == nullptr)
+		return -1.0;
+
+	double startupTime = -1.0;
+
+	char line[512];
+	while (fgets(line, sizeof(line), pipe) != nullptr)
+	{
+		double value = 0.0;
+		if (sscanf(line, "First frame presented after %lf ms.", &value) == 1)
+			startupTime = value;
+	}
+
+	pclose(pipe);
+	return startupTime;
+}
+
+static bool measure(const StartupSettings & settings, const char *name, const char *cachePath, bool clearCache)
+{
+	std::vector<double> times;
+
+	for (int i = 0; i < settings.runs; ++i)
+	{
+		if (clearCache)
+			remove(cachePath);
+
+		double startupTime = launch(settings, cachePath);
+		if (startupTime < 0.0)
+		{
+			printf("Failed to launch %s.\n", settings.emulatorPath);
+			return false;
+		}
+
+		times.push_back(startupTime);
+	}
+
+	std::sort(times.begin(), times.end());
+	printf("%-8s %3i runs  min %8.2f ms  median %8.2f ms  max %8.2f ms\n", name, settings.runs, times.front(), times[times.size() / 2], times.back());
+
+	return true;
+}
+
+int main(int argc, char const *argv[])
+{
+	StartupSettings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+			settings.runs = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--emulator") == 0 && i + 1 < argc)
+			settings.emulatorPath = argv[++i];
+		else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+			settings.cachePath = argv[++i];
+		else if (argv[i][0] == '-')
+		{
+			printf("Usage: %s [ROM path] [--runs N] [--emulator path] [--cache path]\n", argv[0]);
+			return -1;
+		}
+		else
+			settings.romPath = argv[i];
+	}
+
+	// Cold: the cache is deleted before every launch, warm: the first launch fills the cache for the ones that follow
+	if (!measure(settings, "cold", settings.cachePath, true))
+		return -1;
+
+	launch(settings, settings.cachePath);
+
+	if (!measure(settings, "warm", settings.cachePath, false))
+		return -1;
+
+	remove(settings.cachePath);
+
+	return 0;
+}
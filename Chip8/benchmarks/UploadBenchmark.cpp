@@ -0,0 +1,172 @@
+#include "Chip8/Emulator/HeadlessRunner.hpp"
+#include "Chip8/Emulator/Renderer.hpp"
+#include "Chip8/Emulator/Window.hpp"
+#include "Chip8/Benchmark/BenchmarkTimer.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Compares the synchronous and the streaming texture upload paths by running a ROM and presenting every emulated frame.
+// Needs a window, on a machine without a display run it under Xvfb with Mesa's software rasterizer:
+//     LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./Chip8UploadBenchmark
+// Usage: Chip8UploadBenchmark [ROM path] [--frames N] [--cycles-per-frame N] [--seed N] [--finish]
+struct UploadSettings
+{
+	const char *romPath = "roms/demos/Particle Demo [zeroZshadow, 2008].ch8";
+	long frames = 3000;
+	int cyclesPerFrame = 10;
+	unsigned int seed = 1;
+
+	// Wait for the GPU after every frame, which hides the stalls the streaming path avoids
+	bool finish = false;
+};
+
+struct UploadResult
+{
+	double uploadP50;	// Nanoseconds spent in updatePixels()
+	double uploadP99;
+	double frameP50;	// Nanoseconds for upload, draw, and swap
+	double frameP99;
+	long presentedFrames;
+	UploadStatistics statistics;
+};
+
+static double percentile(std::vector<double> & sortedValues, double fraction)
+{
+	if (sortedValues.empty())
+		return 0.0;
+
+	size_t index = static_cast<size_t>(fraction * (sortedValues.size() - 1) + 0.5);
+	return sortedValues[index];
+}
+
+static bool runPath(const UploadSettings & settings, const Window & window, Renderer & renderer, UploadResult & result)
+{
+	HeadlessRunner runner;
+	runner.setCyclesPerFrame(settings.cyclesPerFrame);
+	runner.setSeed(settings.seed);
+	runner.setRandomInput(true);
+
+	if (!runner.loadGame(settings.romPath))
+		return false;
+
+	Chip8Processor & processor = runner.getProcessor();
+
+	std::vector<double> uploadTimes;
+	std::vector<double> frameTimes;
+	uploadTimes.reserve(settings.frames);
+	frameTimes.reserve(settings.frames);
+
+	BenchmarkTimer uploadTimer;
+	BenchmarkTimer frameTimer;
+
+	renderer.resetUploadStatistics();
+
+	for (long frame = 0; frame < settings.frames; ++frame)
+	{
+		runner.runFrame();
+
+		// Frames without clear / draw instructions are not presented, just like in the emulator
+		if (processor.getDirtyRegion().isEmpty())
+			continue;
+
+		frameTimer.start();
+
+		uploadTimer.start();
+		renderer.updatePixels(processor.getGraphicsMemory(), processor.getDirtyRegion());
+		uploadTimer.stop();
+
+		processor.clearDirtyRegion();
+
+		renderer.draw();
+		window.display();
+
+		if (settings.finish)
+			glFinish();
+
+		frameTimer.stop();
+
+		uploadTimes.push_back(uploadTimer.elapsedNanoseconds());
+		frameTimes.push_back(frameTimer.elapsedNanoseconds());
+	}
+
+	std::sort(uploadTimes.begin(), uploadTimes.end());
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	result.uploadP50 = percentile(uploadTimes, 0.50);
+	result.uploadP99 = percentile(uploadTimes, 0.99);
+	result.frameP50 = percentile(frameTimes, 0.50);
+	result.frameP99 = percentile(frameTimes, 0.99);
+	result.presentedFrames = static_cast<long>(frameTimes.size());
+	result.statistics = renderer.getUploadStatistics();
+
+	return true;
+}
+
+static void printResult(const char *name, const UploadResult & result)
+{
+	printf("%-24s %8li frames  upload p50 %9.0f ns  p99 %9.0f ns  frame p50 %9.0f ns  p99 %9.0f ns  %li fence waits (%.3f ms)\n",
+		name, result.presentedFrames, result.uploadP50, result.uploadP99, result.frameP50, result.frameP99,
+		result.statistics.fenceWaitCount, result.statistics.fenceWaitTime * 1e3);
+}
+
+int main(int argc, char const *argv[])
+{
+	UploadSettings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			settings.frames = std::max(1L, atol(argv[++i]));
+		else if (strcmp(argv[i], "--cycles-per-frame") == 0 && i + 1 < argc)
+			settings.cyclesPerFrame = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			settings.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "--finish") == 0)
+			settings.finish = true;
+		else if (argv[i][0] == '-')
+		{
+			printf("Usage: %s [ROM path] [--frames N] [--cycles-per-frame N] [--seed N] [--finish]\n", argv[0]);
+			return -1;
+		}
+		else
+			settings.romPath = argv[i];
+	}
+
+	Window window;
+	Renderer renderer;
+
+	if (!window.create("Chip8 upload benchmark", 640, 320, 3, 3))
+		return -1;
+
+	if (!renderer.initialize(window))
+		return -1;
+
+	// Measure the uploads, not the monitor refresh rate
+	window.setVerticalSync(false);
+
+	UploadResult synchronous = {};
+	if (!runPath(settings, window, renderer, synchronous))
+	{
+		printf("Failed to load %s.\n", settings.romPath);
+		return -1;
+	}
+
+	printResult("synchronous", synchronous);
+
+	if (!renderer.setUploadPath(UploadPath::STREAMING))
+	{
+		printf("Pixel buffers are not available, the streaming path cannot be measured.\n");
+		return -1;
+	}
+
+	UploadResult streaming = {};
+	runPath(settings, window, renderer, streaming);
+
+	printResult(renderer.isPersistentlyMapped() ? "streaming (persistent)" : "streaming (orphaning)", streaming);
+
+	return 0;
+}
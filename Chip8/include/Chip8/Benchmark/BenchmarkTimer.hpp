@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CHIP8_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CHIP8_HAS_RDTSC 1
+#else
+#define CHIP8_HAS_RDTSC 0
+#endif
+
+// Measures a block of code with both the steady clock and the time stamp counter (when available)
+class BenchmarkTimer
+{
+public:
+	inline void start()
+	{
+		m_startTime = std::chrono::steady_clock::now();
+		m_startTicks = readTicks();
+	}
+
+	inline void stop()
+	{
+		m_stopTicks = readTicks();
+		m_stopTime = std::chrono::steady_clock::now();
+	}
+
+	inline double elapsedNanoseconds() const
+	{
+		return std::chrono::duration<double, std::nano>(m_stopTime - m_startTime).count();
+	}
+
+	inline unsigned long long elapsedTicks() const
+	{
+		return m_stopTicks - m_startTicks;
+	}
+
+	static inline bool hasTicks()
+	{
+		return CHIP8_HAS_RDTSC == 1;
+	}
+
+	static inline unsigned long long readTicks()
+	{
+#if CHIP8_HAS_RDTSC
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+
+private:
+	std::chrono::steady_clock::time_point m_startTime;
+	std::chrono::steady_clock::time_point m_stopTime;
+
+	unsigned long long m_startTicks = 0;
+	unsigned long long m_stopTicks = 0;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+// Linux perf_event counters for the calling thread. Hardware counters are preferred, software counters are opened
+// instead when none of the hardware counters are available (virtual machines, containers, perf_event_paranoid).
+// On other platforms open() always fails and every counter reads zero.
+class PerfCounters
+{
+public:
+	enum Counter
+	{
+		CYCLES,
+		INSTRUCTIONS,
+		BRANCH_MISSES,
+		L1D_READ_MISSES,
+		TASK_CLOCK,
+		CONTEXT_SWITCHES,
+		PAGE_FAULTS,
+		COUNTER_COUNT
+	};
+
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	// Returns true when at least one counter could be opened
+	bool open();
+	void close();
+
+	bool isAvailable(Counter counter) const;
+	static const char *getName(Counter counter);
+
+	// Measure the interval between start() and stop(), getValue() returns the result of the last interval. The counters
+	// form one group that only runs in between, stop() reads all of them at once.
+	void start();
+	void stop();
+
+	unsigned long long getValue(Counter counter) const;
+
+private:
+	void openCounter(Counter counter, unsigned int type, unsigned long long config);
+
+private:
+	int m_fileDescriptors[COUNTER_COUNT];
+	unsigned long long m_values[COUNTER_COUNT];
+
+	// The first counter that could be opened leads the group, the others are read in the order they were added
+	int m_groupLeader;
+	int m_groupPositions[COUNTER_COUNT];
+	int m_groupSize;
+
+	// Times the group was enabled and running at the end of the last interval, resetting the group only clears the values
+	unsigned long long m_timeEnabled;
+	unsigned long long m_timeRunning;
+
+	// Task clock of an empty interval, the kernel part of the calls that enable and disable the group
+	unsigned long long m_taskClockOverhead;
+};
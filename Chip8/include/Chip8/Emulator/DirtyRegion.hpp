@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Chip8/Utility/DataTypes.hpp"
+
+struct DirtyRect
+{
+	byte x;
+	byte y;
+	byte width;
+	byte height;
+};
+
+// Set of rectangles on the display that changed since the last present. Overlapping and touching rectangles are
+// merged, and once the set is full new rectangles are merged into the one that grows the least.
+class DirtyRegion
+{
+public:
+	DirtyRegion();
+	~DirtyRegion();
+
+	void add(byte x, byte y, byte width, byte height);
+	void addAll(byte displayWidth, byte displayHeight);
+	void clear();
+
+	bool isEmpty() const;
+	int getRectCount() const;
+	const DirtyRect & getRect(int index) const;
+
+	// Total number of pixels covered by the rectangles
+	long getArea() const;
+
+public:
+	static const int MAX_RECTS = 8;
+
+private:
+	static DirtyRect merge(const DirtyRect & a, const DirtyRect & b);
+	static bool touches(const DirtyRect & a, const DirtyRect & b);
+	static long area(const DirtyRect & rect);
+
+private:
+	DirtyRect m_rects[MAX_RECTS];
+	int m_rectCount;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <cstddef>
+
+// Forward declarations
+class DirtyRegion;
+
+// Something that can show the display of the processor and collect the hex keypad input, the presenter only talks to this
+class DisplayBackend
+{
+public:
+	virtual ~DisplayBackend() {}
+
+	// Resolution of the display in pixels, called when the processor switches its display mode. The framebuffer has
+	// width / 64 words per row and planeCount planes one after the other, the next updatePixels() covers the complete
+	// display.
+	virtual void setDisplaySize(int width, int height, int planeCount) = 0;
+
+	// Take over the dirty rectangles of the bit-packed framebuffer, returns the number of bytes copied or uploaded
+	virtual size_t updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion) = 0;
+
+	// Show the last updated pixels on the screen
+	virtual void present() = 0;
+
+	virtual void pollEvents() = 0;
+	virtual bool shouldClose() const = 0;
+
+	// 16 entries, one per key, 1 while the key is held down
+	virtual const byte *getHexKeyPad() const = 0;
+
+	virtual int getRefreshRate() const = 0;
+	virtual void setVerticalSync(bool enabled) = 0;
+
+	// Colors (RGB, 0 to 1) of pixels that are switched on and off
+	virtual void setPalette(const float *onColor, const float *offColor) = 0;
+
+	virtual const char *getName() const = 0;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Chip8/Utility/DataTypes.hpp"
+
+// Resolutions of the display. Every mode uses the same bit-packed framebuffer: rows of 64-bit words, the most
+// significant bit of a word is its leftmost pixel.
+enum class DisplayMode
+{
+	LORES,		// 64x32, the original CHIP-8 display
+	VIP_HIRES,	// 64x64, the two-page hires mode of the COSMAC VIP
+	SCHIP_HIRES	// 128x64, the extended mode of the SUPER-CHIP, two words per row
+};
+
+// Largest display of all modes, framebuffers are allocated for it so switching modes never reallocates
+static const int MAX_DISPLAY_WIDTH = 128;
+static const int MAX_DISPLAY_HEIGHT = 64;
+static const int MAX_DISPLAY_WORDS = MAX_DISPLAY_WIDTH / 64 * MAX_DISPLAY_HEIGHT;
+
+// XO-CHIP draws on up to two bitplanes, every plane is a complete display of its own
+static const int MAX_DISPLAY_PLANES = 2;
+
+inline int getDisplayModeWidth(DisplayMode mode)
+{
+	return mode == DisplayMode::SCHIP_HIRES ? 128 : 64;
+}
+
+inline int getDisplayModeHeight(DisplayMode mode)
+{
+	return mode == DisplayMode::LORES ? 32 : 64;
+}
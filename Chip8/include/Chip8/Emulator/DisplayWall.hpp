@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include "GL/gl3w.h"
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Forward declarations
+class Window;
+class Chip8Processor;
+
+// Shows the displays of many processors in a grid. All framebuffers live in the layers of one array texture and every
+// tile is drawn by a single instanced draw call.
+class DisplayWall
+{
+public:
+	DisplayWall();
+	~DisplayWall();
+
+	// Columns are chosen automatically to make the grid roughly match the aspect ratio of the window when zero
+	bool initialize(const Window & window, int instanceCount, int columns = 0, const char *shaderCachePath = nullptr);
+
+	// Copy the display of a processor into its tile when it changed since the last publish, may be called from the thread
+	// that runs the processor
+	void publish(int instance, Chip8Processor & processor);
+
+	// Upload the tiles that were published since the last update, returns the number of bytes uploaded
+	size_t update();
+	void draw() const;
+
+	// Colors (RGB, 0 to 1) of pixels that are switched on and off
+	void setPalette(const float *onColor, const float *offColor) const;
+
+	int getInstanceCount() const;
+	int getColumns() const;
+	int getRows() const;
+
+	long getUploadedTileCount() const;
+
+private:
+	bool setupShaders(const char *cachePath);
+	void setupTexture();
+
+private:
+	GLuint m_quadVAO;
+	GLuint m_quadVBO;
+	GLuint m_shader;
+	GLuint m_textureArray;
+
+	int m_instanceCount;
+	int m_columns;
+	int m_rows;
+
+	// Published frames of all instances back to back, and whether a tile changed since the last update
+	std::vector<qword> m_frames;
+	std::vector<byte> m_dirtyTiles;
+	std::mutex m_frameMutex;
+
+	long m_uploadedTileCount;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Chip8/Emulator/DisplayMode.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat
+{
+	PNG_SEQUENCE,	// Numbered PNG files in a folder
+	Y4M				// One uncompressed YUV4MPEG2 video file
+};
+
+enum class CaptureBackpressure
+{
+	DROP,	// Frames submitted while every slot is in use are thrown away, the emulation never waits
+	BLOCK	// The emulation waits for a free slot, no frame is ever lost
+};
+
+struct CaptureSettings
+{
+	CaptureFormat format = CaptureFormat::Y4M;
+	CaptureBackpressure backpressure = CaptureBackpressure::BLOCK;
+
+	// Folder for PNG sequences, file for Y4M videos
+	std::string outputPath;
+
+	// Display resolution of the first frame in pixels. Every frame of a Y4M video has this size, PNG sequences follow
+	// the display mode of each frame.
+	int displayWidth = 64;
+	int displayHeight = 32;
+
+	int scale = 4;
+	int encoderThreads = 2;
+
+	// Frames that can wait for an encoder
+	int queueCapacity = 64;
+
+	unsigned int onColor = 0xFFFFFF;
+	unsigned int offColor = 0x000000;
+};
+
+// Writes completed frames to disk on a pool of background threads. Handing a frame over only copies the (at most 1 KB)
+// bit-packed display into a preallocated slot, all scaling, encoding, and file I/O happens on the encoder threads.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	bool start(const CaptureSettings & settings);
+
+	// Returns false when the frame was dropped or has a display size the capture cannot store
+	bool submit(const qword *graphicsMemory, int width, int height);
+
+	// A Y4M video cannot change its frame size, a ROM that switches the display mode has to be captured as PNG files
+	bool acceptsDisplaySize(int width, int height) const;
+
+	// Waits until every submitted frame was written and stops the encoder threads
+	void finish();
+
+	long getSubmittedFrameCount() const;
+	long getDroppedFrameCount() const;
+	long getWrittenFrameCount() const;
+
+private:
+	struct Slot
+	{
+		qword rows[MAX_DISPLAY_WORDS];
+		int width;
+		int height;
+		long sequence;
+	};
+
+	void encoderLoop();
+	bool writeFrame(const Slot & slot, std::vector<byte> & encoded);
+
+private:
+	CaptureSettings m_settings;
+	bool m_running;
+
+	std::vector<Slot> m_slots;
+	std::vector<int> m_freeSlots;
+	std::deque<int> m_pendingSlots;
+
+	std::vector<std::thread> m_encoders;
+	mutable std::mutex m_queueMutex;
+	std::condition_variable m_frameAvailable;
+	std::condition_variable m_slotAvailable;
+	bool m_stopping;
+
+	// Video frames have to be written in order, the encoder that finishes first may have to wait for its turn
+	FILE *m_videoFile;
+	std::mutex m_writeMutex;
+	std::condition_variable m_writeTurn;
+	long m_nextWrite;
+
+	long m_nextSequence;
+	long m_droppedFrameCount;
+	long m_writtenFrameCount;
+	bool m_writeFailed;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Chip8/Emulator/DisplayBackend.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+// Forward declarations
+class Window;
+class Renderer;
+
+// Shows the display through the GLFW window and the OpenGL renderer
+class GLDisplayBackend : public DisplayBackend
+{
+public:
+	GLDisplayBackend(const Window & window, Renderer & renderer);
+	~GLDisplayBackend();
+
+	void setDisplaySize(int width, int height, int planeCount) override;
+
+	size_t updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion) override;
+	void present() override;
+
+	void pollEvents() override;
+	bool shouldClose() const override;
+	const byte *getHexKeyPad() const override;
+
+	int getRefreshRate() const override;
+	void setVerticalSync(bool enabled) override;
+	void setPalette(const float *onColor, const float *offColor) override;
+
+	const char *getName() const override;
+
+private:
+	const Window & m_window;
+	Renderer & m_renderer;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Chip8/Emulator/Processor.hpp"
+#include "Chip8/Emulator/Quirks.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/RomAnalyzer.hpp"
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+// Runs a ROM without a window, one emulated 60Hz frame at a time
+class HeadlessRunner
+{
+public:
+	HeadlessRunner();
+	~HeadlessRunner();
+
+	bool loadGame(const char *path);
+	bool loadGame(const byte *rom, size_t size);
+
+	// Fingerprint the loaded ROM to find its quirk profile and speed, the database is optional
+	Chip8RomAnalysis analyzeGame(const Chip8RomDatabase *database) const;
+
+	// Input scripts are text files with one "frame key state" triple per line (key in hexadecimal, state 0 or 1)
+	bool loadInputScript(const char *path);
+
+	// Without an input script a random key is pressed or released every few frames
+	void setRandomInput(bool enabled);
+	void setSeed(unsigned int seed);
+	unsigned int getSeed() const;
+	void setCyclesPerFrame(int cyclesPerFrame);
+	void setQuirkProfile(QuirkProfile profile);
+
+	// Apply the input for this frame, execute one frame worth of instructions, and tick the timers
+	void runFrame();
+
+	// Runs frames until one checks the keys (Ex9E, ExA1, Fx0A) and rewinds to the start of that frame, so no input has
+	// been read yet. Returns false when no frame before maxFrames checks them.
+	bool runUntilKeyPoll(long maxFrames);
+
+	// The processor state with the frame and instruction counters. Loading replays the input of the frames before the
+	// saved one, so the keys and the random input continue as if the runner had played those frames itself.
+	void saveState(std::string & state) const;
+	bool loadState(const std::string & state);
+
+	long getFrameCount() const;
+	long long getInstructionCount() const;
+	int getCyclesPerFrame() const;
+
+	// Hash of the framebuffer and the complete memory, used to detect behavioural changes
+	unsigned long long hashState() const;
+
+	Chip8Processor & getProcessor();
+	const Chip8Processor & getProcessor() const;
+
+private:
+	struct InputEvent
+	{
+		long frame;
+		byte key;
+		byte state;
+	};
+
+	void applyInput();
+	void replayInputBefore(long frame);
+
+private:
+	Chip8Processor m_processor;
+
+	std::vector<InputEvent> m_inputScript;
+	size_t m_nextInputEvent;
+
+	std::default_random_engine m_inputEngine;
+	bool m_randomInput;
+	unsigned int m_seed;
+
+	int m_cyclesPerFrame;
+	long m_frameCount;
+	long long m_instructionCount;
+};
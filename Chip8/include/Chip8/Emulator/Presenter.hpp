@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Forward declarations
+class DisplayBackend;
+class Chip8Processor;
+
+enum class PresentPolicy
+{
+	IMMEDIATE,		// Present after every clear / draw instruction (the original behavior)
+	HOST_REFRESH,	// Present at most once per refresh of the monitor
+	EMULATED_FRAME	// Present at most once per emulated 60Hz frame
+};
+
+// Decides when a changed framebuffer is actually uploaded, drawn, and swapped
+class Presenter
+{
+public:
+	Presenter(DisplayBackend & backend, PresentPolicy policy);
+	~Presenter();
+
+	// Call whenever the processor raised its draw flag
+	void markDirty();
+
+	// Call once per main loop iteration, frameBoundary is true when an emulated 60Hz frame has just ended
+	void update(Chip8Processor & processor, bool frameBoundary);
+
+	long getPresentedFrameCount() const;
+	long getSkippedFrameCount() const;
+
+	// Upload statistics (bytes the display backend copied or uploaded)
+	size_t getLastUploadBytes() const;
+	size_t getTotalUploadBytes() const;
+
+private:
+	void present(Chip8Processor & processor);
+
+private:
+	DisplayBackend & m_backend;
+
+	// Display size the backend was last set to, zero before the first present
+	int m_displayWidth;
+	int m_displayHeight;
+	int m_planeCount;
+
+	PresentPolicy m_policy;
+	std::chrono::duration<float> m_refreshInterval;
+	std::chrono::high_resolution_clock::time_point m_lastPresentTime;
+
+	// Copy of the last presented framebuffer, presents are skipped when nothing changed
+	std::vector<qword> m_presentedFrame;
+	bool m_dirty;
+
+	long m_presentedFrameCount;
+	long m_skippedFrameCount;
+
+	size_t m_lastUploadBytes;
+	size_t m_totalUploadBytes;
+};
@@ -1,38 +1,114 @@
 #pragma once
 
+#include "Chip8/Emulator/DirtyRegion.hpp"
+#include "Chip8/Emulator/DisplayMode.hpp"
+#include "Chip8/Emulator/Quirks.hpp"
 #include "Chip8/Utility/DataTypes.hpp"
 
+#include <cstddef>
+#include <random>
+#include <string>
+
 // Forward declarations
 class Window;
-class Renderer;
+class Chip8Coverage;
+class Chip8ProcessorBenchmark;
 
 class Chip8Processor
 {
+	// The micro-benchmarks time the OpCode handlers in isolation
+	friend class Chip8ProcessorBenchmark;
+
 public:
 	Chip8Processor();
 	~Chip8Processor();
 
 	void initialize();
 	bool loadGame(const char *name);
+
+	// Copies a ROM that is already in memory, e.g. mapped by the ROM library, to 0x200. Fails when it does not fit.
+	bool loadGame(const byte *rom, size_t size);
+
 	void newCycle();
-	void updateDisplay(const Window & window, const Renderer & renderer);
+
+	// Execute a number of cycles with the interpreter loop of the current quirk profile
+	void runCycles(int count);
+
+	// Behaviour that differs between implementations, the default is SUPER-CHIP
+	void setQuirkProfile(QuirkProfile profile);
+	QuirkProfile getQuirkProfile() const;
+
 	void updateKeys(const Window & window);
 	void updateTimers();
 	void finalize();
 
+	// Headless input and deterministic random numbers (used by the benchmarks)
+	void setKey(byte key, byte state);
+	void setRandomSeed(unsigned int seed);
+
+	// Record every instruction fetch in the coverage bitmap (pass nullptr to disable)
+	void setCoverage(Chip8Coverage *coverage);
+
+	// Everything a program can observe: memory, registers, timers, keys, display, quirk profile, and the state of the
+	// random number generator. The coverage bitmap and the trace flag are not part of it.
+	void saveState(std::string & state) const;
+
+	// Fails without changing anything when the state was saved by another CORE_VERSION or is damaged
+	bool loadState(const std::string & state);
+
+	// Key checks executed so far (Ex9E, ExA1, and every cycle Fx0A waits), used to find the first one
+	long long getKeyPollCount() const;
+
 	const word getPC() const;
 	const long getApplicationSize() const;
 
 	byte *getMemoryStart() const;
 
+	// The display is stored as rows of 64-bit words (two per row in the SUPER-CHIP hires mode), the most significant bit
+	// is the leftmost pixel. Only the rows of the current display mode are part of the graphics memory. Once an XO-CHIP
+	// program selects the second plane, its rows follow the rows of the first plane.
+	const qword *getGraphicsMemory() const;
+	const long getGraphicsMemorySize() const;
+
+	// Color of a pixel, bit n is set when the pixel is switched on in plane n
+	byte getPixel(byte x, byte y) const;
+
+	DisplayMode getDisplayMode() const;
+	int getDisplayWidth() const;
+	int getDisplayHeight() const;
+	int getDisplayPlaneCount() const;
+
+	// XO-CHIP sound: a 128 sample 1-bit pattern (most significant bit first) played while the sound timer is not zero
+	const byte *getAudioPattern() const;
+	double getAudioPlaybackRate() const;
+
+	// Area of the display touched by clear / draw instructions since the last call to clearDirtyRegion()
+	const DirtyRegion & getDirtyRegion() const;
+	void clearDirtyRegion();
+
 public:
 	byte drawFlag;
 	byte quitFlag;
 
-	const word MEMORY_SIZE_BYTES = 4096;
+	// Print every decoded OpCode to the console
+	byte traceFlag;
+
+	// 64 KB of XO-CHIP memory, the original 4 KB programs only use the start of it
+	const long MEMORY_SIZE_BYTES = 65536;
+
+	// Increase it whenever a change to the interpreter can change the state a program reaches, or the layout of the saved
+	// state changes, so states and snapshots of older versions are no longer used
+	static constexpr unsigned int CORE_VERSION = 2;
 
 private:
-	// Functions for the OpCodes in the switch statement
+	// Fetch, decode, and execute one OpCode, compiled once per quirk profile
+	template <typename Quirks>
+	void executeCycle();
+
+	template <typename Quirks>
+	void runCyclesWith(int count);
+
+	// Functions for the OpCodes in the switch statement, the templates depend on the quirk profile
 	void CLS(word opCode);
 	void RET(word opCode);
 	void SYSaddr(word opCode);
@@ -49,13 +125,17 @@ private:
 	void XORvxvy(word opCode);
 	void ADDvxvy(word opCode);
 	void SUBvxvy(word opCode);
+	template <typename Quirks>
 	void SHRvxvy(word opCode);
 	void SUBNvxvy(word opCode);
+	template <typename Quirks>
 	void SHLvxvy(word opCode);
 	void SNEvxvy(word opCode);
 	void LDiaddr(word opCode);
+	template <typename Quirks>
 	void JPv0addr(word opCode);
 	void RNDvxbyte(word opCode);
+	template <typename Quirks>
 	void DRWvxvynibble(word opCode);
 	void SKPvx(word opCode);
 	void SKNPvx(word opCode);
@@ -66,22 +146,79 @@ private:
 	void ADDivx(word opCode);
 	void LDfvx(word opCode);
 	void LDbvx(word opCode);
+	template <typename Quirks>
 	void LDivx(word opCode);
+	template <typename Quirks>
 	void LDvxi(word opCode);
 
+	// SUPER-CHIP OpCodes
+	void SCDnibble(word opCode);
+	void SCR(word opCode);
+	void SCL(word opCode);
+	void EXIT(word opCode);
+	void LOW(word opCode);
+	void HIGH(word opCode);
+	void LDhfvx(word opCode);
+	void LDrvx(word opCode);
+	void LDvxr(word opCode);
+
+	// XO-CHIP OpCodes
+	void SCUnibble(word opCode);
+	void SAVEvxvy(word opCode);
+	void LOADvxvy(word opCode);
+	void LDilong(word opCode);
+	void PLANEn(word opCode);
+	void AUDIO(word opCode);
+	void PITCHvx(word opCode);
+
+	// Move I past the registers stored / loaded by Fx55 / Fx65, as far as the quirk profile does
+	template <typename Quirks>
+	void advanceIndex(byte x);
+
+	// Distance to the instruction after the next one, F000 nnnn is four bytes long
+	word getSkipDistance() const;
+
+	// First row of a plane in the current display mode
+	qword *getPlane(byte plane) const;
+
+	// XOR a sprite onto one plane, returns true when a pixel was erased
+	template <typename Quirks>
+	bool drawSprite(qword *plane, word address, byte left, byte top, byte spriteWidth, byte spriteHeight);
+
+	// Switch the resolution, the display is cleared
+	void setDisplayMode(DisplayMode mode);
+
 private:
+	QuirkProfile m_quirkProfile;
+
 	// Flag that indicates whether the memory has already been deallocated
 	byte m_finalizeCalled;
 
-	// The processor has 4096 bytes of memory
+	// The processor has 65536 bytes of memory
 	byte *m_memory;
 
-	// The display has a resolution of 64x32 pixels
-	byte *m_graphicsMemory;
+	// The display has a resolution of 64x32, 64x64, or 128x64 pixels, packed as one bit per pixel
+	qword *m_graphicsMemory;
+
+	DisplayMode m_displayMode;
+	byte m_displayWidth;
+	byte m_displayHeight;
+	byte m_rowWords;
+
+	// Bitmask of the planes that clear / draw / scroll instructions work on, and the number of planes in use
+	byte m_planeMask;
+	byte m_planeCount;
 
 	// 16 Registers (8-bit) in total
 	byte *m_V;
 
+	// SUPER-CHIP flag registers (the HP48 RPL user flags), saved and restored by Fx75 / Fx85
+	byte m_flags[16];
+
+	// XO-CHIP sound pattern and pitch register
+	byte m_audioPattern[16];
+	byte m_audioPitch;
+
 	// Timers
 	byte m_delayTimer;
 	byte m_soundTimer;
@@ -106,4 +243,15 @@ private:
 
 	// Size of the loaded application or game
 	long m_applicationSize;
+
+	// Display area changed since the last present
+	DirtyRegion m_dirtyRegion;
+
+	// Random number generator used by the RND instruction
+	std::default_random_engine m_randomEngine;
+
+	// Optional coverage bitmap that is updated on every instruction fetch
+	Chip8Coverage *m_coverage;
+
+	long long m_keyPollCount;
 };
\ No newline at end of file
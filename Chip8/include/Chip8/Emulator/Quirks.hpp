@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstring>
+#include <initializer_list>
+
+// Behaviour that differs between CHIP-8 implementations. Every profile is a policy type of compile-time constants, the
+// processor compiles its interpreter loop once per profile, so compatibility choices never branch while running.
+enum class QuirkProfile
+{
+	COSMAC_VIP,	// The original interpreter of the RCA COSMAC VIP
+	CHIP48,		// CHIP-48 on the HP48 calculators
+	SUPER_CHIP,	// SUPER-CHIP 1.1 on the HP48 calculators
+	XO_CHIP		// The XO-CHIP extension of Octo
+};
+
+// Distance that Fx55 / Fx65 move I after copying V0 through Vx
+enum class IndexIncrement
+{
+	NONE,
+	X,
+	X_PLUS_ONE
+};
+
+// SHIFT_READS_VY:	8xy6 / 8xyE shift Vy and store the result in Vx, instead of shifting Vx in place
+// INDEX_INCREMENT:	How far Fx55 / Fx65 advance I
+// JUMP_ADDS_VX:	Bxnn jumps to xnn + Vx, instead of Bnnn jumping to nnn + V0
+// SPRITES_WRAP:	Sprite pixels past the edges of the display wrap around to the opposite side, instead of being clipped
+// VIP_HIRES_ENTRY:	A jump to 0x260 at 0x200 starts the two-page hires interpreter of the VIP, see executeCycle()
+struct CosmacVipQuirks
+{
+	static constexpr bool SHIFT_READS_VY = true;
+	static constexpr IndexIncrement INDEX_INCREMENT = IndexIncrement::X_PLUS_ONE;
+	static constexpr bool JUMP_ADDS_VX = false;
+	static constexpr bool SPRITES_WRAP = false;
+	static constexpr bool VIP_HIRES_ENTRY = true;
+};
+
+struct Chip48Quirks
+{
+	static constexpr bool SHIFT_READS_VY = false;
+	static constexpr IndexIncrement INDEX_INCREMENT = IndexIncrement::X;
+	static constexpr bool JUMP_ADDS_VX = true;
+	static constexpr bool SPRITES_WRAP = false;
+	static constexpr bool VIP_HIRES_ENTRY = false;
+};
+
+struct SuperChipQuirks
+{
+	static constexpr bool SHIFT_READS_VY = false;
+	static constexpr IndexIncrement INDEX_INCREMENT = IndexIncrement::NONE;
+	static constexpr bool JUMP_ADDS_VX = true;
+	static constexpr bool SPRITES_WRAP = false;
+	static constexpr bool VIP_HIRES_ENTRY = false;
+};
+
+struct XoChipQuirks
+{
+	static constexpr bool SHIFT_READS_VY = true;
+	static constexpr IndexIncrement INDEX_INCREMENT = IndexIncrement::X_PLUS_ONE;
+	static constexpr bool JUMP_ADDS_VX = false;
+	static constexpr bool SPRITES_WRAP = true;
+	static constexpr bool VIP_HIRES_ENTRY = false;
+};
+
+inline const char *getQuirkProfileName(QuirkProfile profile)
+{
+	switch (profile)
+	{
+	case QuirkProfile::COSMAC_VIP:
+		return "vip";
+
+	case QuirkProfile::CHIP48:
+		return "chip48";
+
+	case QuirkProfile::SUPER_CHIP:
+		return "schip";
+
+	case QuirkProfile::XO_CHIP:
+		return "xochip";
+
+	default:
+		return "unknown";
+	}
+}
+
+// Command line names are the ones returned by getQuirkProfileName()
+inline bool parseQuirkProfile(const char *name, QuirkProfile & profile)
+{
+	for (QuirkProfile candidate : { QuirkProfile::COSMAC_VIP, QuirkProfile::CHIP48, QuirkProfile::SUPER_CHIP, QuirkProfile::XO_CHIP })
+	{
+		if (strcmp(name, getQuirkProfileName(candidate)) == 0)
+		{
+			profile = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -4,8 +4,25 @@
 
 #include "GL/gl3w.h"
 
+#include <cstddef>
+
 // Forward declarations
 class Window;
+class DirtyRegion;
+
+enum class UploadPath
+{
+	SYNCHRONOUS,	// glTexSubImage2D straight from client memory (the original behavior)
+	STREAMING		// Copy into a ring of pixel buffer objects, the texture is updated from there without stalling
+};
+
+struct UploadStatistics
+{
+	long uploadCount;
+	double cpuTime;			// Seconds spent in updatePixels()
+	long fenceWaitCount;	// Number of uploads that found their ring segment still in use by the GPU
+	double fenceWaitTime;	// Seconds spent waiting for ring segments to be released
+};
 
 class Renderer
 {
@@ -13,18 +30,61 @@ public:
 	Renderer();
 	~Renderer();
 
-	bool initialize(const Window & window);
+	// The linked shader program is cached in shaderCachePath when it is not nullptr, which skips compiling on later launches
+	bool initialize(const Window & window, const char *shaderCachePath = nullptr);
 	void draw() const;
-	void updatePixels(byte *graphicsMemory) const;
+
+	// Resize the texture for a new display mode, its contents are undefined until the next complete upload
+	void setDisplaySize(int width, int height, int planeCount);
+
+	// Upload the dirty rectangles of the bit-packed framebuffer (width / 64 words per row, planes one after the other),
+	// returns the number of bytes uploaded
+	size_t updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion);
+
+	// Returns false when the pixel buffer objects could not be created, the synchronous path is used in that case
+	bool setUploadPath(UploadPath path);
+	UploadPath getUploadPath() const;
+
+	// True when the streaming path writes into a persistently mapped buffer (GL 4.4 / ARB_buffer_storage), false when
+	// it orphans the buffer on every upload instead
+	bool isPersistentlyMapped() const;
+
+	const UploadStatistics & getUploadStatistics() const;
+	void resetUploadStatistics();
+
+	// Colors (RGB, 0 to 1) of pixels that are switched on and off
+	void setPalette(const float *onColor, const float *offColor) const;
 
 private:
-	bool setupShaders();
+	bool setupShaders(const char *cachePath);
 	void setupTexture();
-	void setupQuad();
+	bool setupPixelBuffers();
+	void deletePixelBuffers();
+
+	// Copies the framebuffer into the next ring segment and returns its offset into the pixel buffer
+	size_t streamFrame(const qword *graphicsMemory);
+	void uploadRects(const void *source, const DirtyRegion & dirtyRegion, size_t & uploadedBytes) const;
 
 private:
+	// Three segments, so the CPU can fill one while the GPU may still read the previous two
+	static const int PIXEL_BUFFER_SEGMENTS = 3;
+
 	GLuint m_quadVAO;
 	GLuint m_quadVBO;
 	GLuint m_shader;
 	GLuint m_texture;
+
+	int m_displayWidth;
+	int m_displayHeight;
+	int m_planeCount;
+
+	UploadPath m_uploadPath;
+	UploadStatistics m_uploadStatistics;
+
+	// Streaming uploads
+	GLuint m_pixelBuffer;
+	bool m_persistentMapping;
+	byte *m_mappedPixels;
+	GLsync m_segmentFences[PIXEL_BUFFER_SEGMENTS];
+	int m_segmentIndex;
 };
\ No newline at end of file
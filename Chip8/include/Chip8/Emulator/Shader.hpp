@@ -0,0 +1,18 @@
+#pragma once
+
+#include "GL/gl3w.h"
+
+// Compile and link a vertex / fragment shader pair, errors are printed to the console. When a cache path is given the
+// linked program binary is stored there and reused by later launches on the same driver.
+bool createShaderProgram(const GLchar *vertexSourceCode, const GLchar *fragmentSourceCode, GLuint & programStorage,
+	const char *cachePath = nullptr);
+
+bool isExtensionSupported(const char *name);
+
+// A quad of six vertices that covers the viewport as two triangles, the position is vertex attribute 0 and the
+// texture coordinate attribute 1
+void createScreenQuad(GLuint & vertexArrayStorage, GLuint & vertexBufferStorage);
+void deleteScreenQuad(GLuint & vertexArray, GLuint & vertexBuffer);
+
+// Sets the onColor / offColor uniforms of a display shader, the colors are RGB in 0..1
+void setPaletteUniforms(GLuint program, const float *onColor, const float *offColor);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <string>
+
+// Forward declarations
+class HeadlessRunner;
+
+// Where the snapshot of a ROM is taken
+enum class SnapshotCheckpoint
+{
+	FIRST_KEY_POLL,		// Start of the first frame that checks the keys, or the frame limit for ROMs that never do
+	FRAME				// A fixed frame, reached without any input
+};
+
+// Saved states of ROMs past their boot and intro sequences. Snapshots are keyed by the ROM hash, quirk profile, speed,
+// seed, checkpoint, and Chip8Processor::CORE_VERSION, so a new core version never loads the states of an old one.
+// Until the first key check a program cannot observe the input, so a FIRST_KEY_POLL snapshot continues exactly like
+// a run from the start.
+class SnapshotCache
+{
+public:
+	SnapshotCache();
+	~SnapshotCache();
+
+	// Creates the directory and removes the snapshots of other core versions
+	bool open(const char *directory);
+
+	// Moves a runner that has loaded a ROM and not run any frames yet to the checkpoint. Missing snapshots are built
+	// by running the ROM in a runner of their own with the same profile, speed, and seed, then stored.
+	bool warmStart(HeadlessRunner & runner, SnapshotCheckpoint checkpoint, long frames);
+
+	long getHitCount() const;
+	long getBuildCount() const;
+
+private:
+	std::string getSnapshotPath(const HeadlessRunner & runner, SnapshotCheckpoint checkpoint, long frames) const;
+	bool buildSnapshot(const HeadlessRunner & runner, SnapshotCheckpoint checkpoint, long frames, std::string & state) const;
+
+private:
+	std::string m_directory;
+	long m_hitCount;
+	long m_buildCount;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Chip8/Emulator/DisplayBackend.hpp"
+#include "Chip8/Emulator/DisplayMode.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <chrono>
+#include <string>
+
+enum class TerminalCells
+{
+	HALF_BLOCKS,	// One cell per 1x2 pixels (64x16 cells for a 64x32 display), works in most fonts
+	BRAILLE			// One cell per 2x4 pixels (32x8 cells for a 64x32 display)
+};
+
+// Draws the display in the terminal with ANSI escape sequences, for watching an emulator over ssh. Only the cells that
+// changed since the previous frame are written, and every frame is a single write to the terminal.
+class TerminalDisplayBackend : public DisplayBackend
+{
+public:
+	TerminalDisplayBackend();
+	~TerminalDisplayBackend();
+
+	bool create(TerminalCells cells);
+	void destroy();
+
+	void setDisplaySize(int width, int height, int planeCount) override;
+
+	// Builds the escape sequences for the changed cells, returns their size in bytes
+	size_t updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion) override;
+	void present() override;
+
+	void pollEvents() override;
+	bool shouldClose() const override;
+	const byte *getHexKeyPad() const override;
+
+	int getRefreshRate() const override;
+	void setVerticalSync(bool enabled) override;
+	void setPalette(const float *onColor, const float *offColor) override;
+
+	const char *getName() const override;
+
+	size_t getTotalBytesWritten() const;
+
+private:
+	word getCell(int column, int row) const;
+	void appendCell(word cell);
+	void writeOutput();
+
+	// Allocate the cells for the current display size, all of them are drawn on the next update
+	void resetCells();
+
+private:
+	TerminalCells m_cellType;
+	int m_displayWidth;
+	int m_displayHeight;
+	int m_planeCount;
+	int m_columns;
+	int m_rows;
+	int m_cellWidth;
+	int m_cellHeight;
+
+	bool m_created;
+	bool m_closeRequested;
+
+	// Cells show one color for switched on pixels, a pixel is on when it is on in any plane
+	qword m_frame[MAX_DISPLAY_WORDS];
+
+	// Cells as they are currently shown in the terminal, invalid cells are always redrawn
+	word *m_cells;
+
+	// Escape sequences for the next present
+	std::string m_output;
+	size_t m_totalBytesWritten;
+
+	// Terminals only report key presses, a key counts as held for a short while after it was typed
+	byte m_hexKeyPad[16];
+	std::chrono::steady_clock::time_point m_keyReleaseTimes[16];
+};
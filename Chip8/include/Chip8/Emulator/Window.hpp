@@ -14,11 +14,15 @@ public:
 	bool create(const char * title, int width, int height, int glVersionMajor = 3, int glVersionMinor = 3);
 	
 	void quit() const;
+	bool shouldClose() const;
 	void pollKeyboard() const;
 	void display() const;
 
+	void setVerticalSync(bool enabled) const;
+
 	int getWidth() const;
 	int getHeight() const;
+	int getRefreshRate() const;
 
 	void getFramebufferDimensions(int & widthStorage, int & heightStorage) const;
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Chip8/Emulator/DisplayBackend.hpp"
+#include "Chip8/Emulator/DisplayMode.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+// Shows the display in a plain X11 window without OpenGL. The framebuffer is scaled on the CPU into an image in shared
+// memory (MIT-SHM), which the X server reads directly. Displays without the extension get a regular XPutImage.
+class X11DisplayBackend : public DisplayBackend
+{
+public:
+	X11DisplayBackend();
+	~X11DisplayBackend();
+
+	// The window size is rounded down to a whole multiple of the 64x32 display resolution, other display modes are scaled
+	// to fit into the same window
+	bool create(const char *title, int width, int height);
+	void destroy();
+
+	void setDisplaySize(int width, int height, int planeCount) override;
+
+	size_t updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion) override;
+	void present() override;
+
+	void pollEvents() override;
+	bool shouldClose() const override;
+	const byte *getHexKeyPad() const override;
+
+	int getRefreshRate() const override;
+	void setVerticalSync(bool enabled) override;
+	void setPalette(const float *onColor, const float *offColor) override;
+
+	const char *getName() const override;
+
+	bool isUsingSharedMemory() const;
+
+private:
+	// Keeps the Xlib types (and macros) out of this header
+	struct X11State;
+
+	void waitForCompletion();
+
+	// Scale the complete frame into the image again, the area around the display is filled with the "off" color
+	void redraw();
+	unsigned int toPixel(const float *color) const;
+
+private:
+	X11State *m_state;
+
+	byte m_hexKeyPad[16];
+	bool m_closeRequested;
+
+	int m_displayWidth;
+	int m_displayHeight;
+	int m_planeCount;
+
+	// Size of a display pixel in the image, and the top left corner of the display
+	int m_scale;
+	int m_originX;
+	int m_originY;
+	unsigned int m_onPixel;
+	unsigned int m_offPixel;
+
+	// Scaled rows that changed since the last present
+	int m_dirtyTop;
+	int m_dirtyBottom;
+
+	// The last frame is kept to redraw the image after a palette change, a pixel is on when it is on in any plane
+	qword m_frame[MAX_DISPLAY_WORDS];
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <vector>
+
+// Minimal CHIP-8 assembler that emits OpCodes in order, used to generate synthetic ROMs
+class Chip8Assembler
+{
+public:
+	Chip8Assembler(word origin = 0x200);
+	~Chip8Assembler();
+
+	// Address of the next emitted byte
+	word here() const;
+
+	void emit(word opCode);
+	void emitByte(byte value);
+
+	// Overwrite a previously emitted OpCode (used to resolve forward jumps and calls)
+	void patch(word address, word opCode);
+
+	// Mnemonics follow Cowgod's reference, "x" and "y" are register indices
+	void CLS()							{ emit(0x00E0); }
+	void RET()							{ emit(0x00EE); }
+	void JP(word address)				{ emit(0x1000 | (address & 0x0FFF)); }
+	void CALL(word address)				{ emit(0x2000 | (address & 0x0FFF)); }
+	void SE(byte x, byte kk)			{ emit(0x3000 | (x << 8) | kk); }
+	void SNE(byte x, byte kk)			{ emit(0x4000 | (x << 8) | kk); }
+	void LD(byte x, byte kk)			{ emit(0x6000 | (x << 8) | kk); }
+	void ADD(byte x, byte kk)			{ emit(0x7000 | (x << 8) | kk); }
+	void ALU(byte x, byte y, byte op)	{ emit(0x8000 | (x << 8) | (y << 4) | (op & 0xF)); }
+	void LDI(word address)				{ emit(0xA000 | (address & 0x0FFF)); }
+	void DRW(byte x, byte y, byte n)	{ emit(0xD000 | (x << 8) | (y << 4) | (n & 0xF)); }
+	void STORE(byte x)					{ emit(0xF055 | (x << 8)); }
+	void LOAD(byte x)					{ emit(0xF065 | (x << 8)); }
+
+	// SUPER-CHIP
+	void SCD(byte n)					{ emit(0x00C0 | (n & 0xF)); }
+	void SCR()							{ emit(0x00FB); }
+	void SCL()							{ emit(0x00FC); }
+	void EXIT()							{ emit(0x00FD); }
+	void LOW()							{ emit(0x00FE); }
+	void HIGH()							{ emit(0x00FF); }
+
+	// XO-CHIP
+	void SCU(byte n)					{ emit(0x00D0 | (n & 0xF)); }
+	void SAVE(byte x, byte y)			{ emit(0x5002 | (x << 8) | (y << 4)); }
+	void LOAD(byte x, byte y)			{ emit(0x5003 | (x << 8) | (y << 4)); }
+	void LDILONG(word address)			{ emit(0xF000); emit(address); }
+	void PLANE(byte n)					{ emit(0xF001 | ((n & 0x3) << 8)); }
+	void AUDIO()						{ emit(0xF002); }
+	void PITCH(byte x)					{ emit(0xF03A | (x << 8)); }
+
+	const std::vector<byte> & getBytes() const;
+	bool save(const char *path) const;
+
+private:
+	std::vector<byte> m_bytes;
+	word m_origin;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Helpers for the binary caches (ROM index, saved states). Values are stored in the byte order of the machine, the
+// files are rebuilt when they cannot be read.
+template <typename T>
+inline void appendBinary(std::string & buffer, const T & value)
+{
+	buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+inline void appendBinary(std::string & buffer, const void *data, size_t size)
+{
+	buffer.append(static_cast<const char *>(data), size);
+}
+
+// Strings are prefixed with their length and cut off after 65535 bytes
+inline void appendBinaryString(std::string & buffer, const std::string & text)
+{
+	size_t length = std::min<size_t>(text.size(), 0xFFFF);
+	appendBinary(buffer, static_cast<unsigned short>(length));
+	buffer.append(text, 0, length);
+}
+
+// Reads the values back in the order they were appended, every read fails once the end was passed
+class BinaryReader
+{
+public:
+	BinaryReader(const std::string & buffer)
+		: m_position(buffer.data())
+		, m_end(buffer.data() + buffer.size())
+	{
+	}
+
+	template <typename T>
+	bool read(T & value)
+	{
+		return read(&value, sizeof(value));
+	}
+
+	bool read(void *data, size_t size)
+	{
+		if (static_cast<size_t>(m_end - m_position) < size)
+			return false;
+
+		memcpy(data, m_position, size);
+		m_position += size;
+		return true;
+	}
+
+	bool readString(std::string & text)
+	{
+		unsigned short length;
+		if (!read(length) || static_cast<size_t>(m_end - m_position) < length)
+			return false;
+
+		text.assign(m_position, length);
+		m_position += length;
+		return true;
+	}
+
+	bool isAtEnd() const
+	{
+		return m_position == m_end;
+	}
+
+private:
+	const char *m_position;
+	const char *m_end;
+};
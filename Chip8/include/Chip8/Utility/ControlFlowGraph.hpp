@@ -0,0 +1,118 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// What the bytes of a program were classified as
+enum class ByteClass : byte
+{
+	DATA,			// Not reached by any path from the entry point: sprites, tables, text, or padding
+	INSTRUCTION,	// First byte of an instruction
+	OPERAND			// Remaining bytes of an instruction (the low byte, and the address of F000 nnnn)
+};
+
+enum class EdgeKind : byte
+{
+	FALLTHROUGH,	// The next instruction, also the return site of a call and the not-taken side of a skip
+	JUMP,			// 1nnn
+	CALL,			// 2nnn
+	SKIP,			// The taken side of 3xkk, 4xkk, 5xy0, 9xy0, Ex9E, ExA1
+	INDIRECT		// Bnnn, a target derived from the values the offset register can hold
+};
+
+// Why a basic block ends
+enum class BlockEnd : byte
+{
+	FALLTHROUGH,	// The next instruction is the target of another edge
+	JUMP,
+	CALL,
+	SKIP,
+	INDIRECT,
+	RETURN,			// 00EE
+	EXIT,			// 00FD
+	END_OF_PROGRAM	// The last instruction runs past the end of the program
+};
+
+struct Chip8CfgEdge
+{
+	word target;
+	EdgeKind kind;
+};
+
+struct Chip8BasicBlock
+{
+	word start;
+	word end;				// Address after the last instruction
+	word lastInstruction;
+	BlockEnd blockEnd;
+
+	// Bnnn whose offset could not be bounded, so not every target is known
+	bool unresolved;
+
+	std::vector<Chip8CfgEdge> successors;
+	std::vector<word> predecessors;	// Start addresses of the blocks with an edge to this one
+};
+
+// Separates the code of a program from its data by recursive traversal: starting at the entry point, it follows jumps,
+// calls, both sides of skips, and the targets of Bnnn it can bound, then splits the instructions it found into basic
+// blocks. Bytes that are never reached are data.
+class Chip8ControlFlowGraph
+{
+public:
+	Chip8ControlFlowGraph();
+	~Chip8ControlFlowGraph();
+
+	// program[0] is loaded at loadAddress, tracing starts there. A program that starts with the jump over the VIP two-page
+	// hires interpreter (1260) continues at 0x2C0, the 1802 machine code in between is data.
+	void build(const byte *program, size_t size, word loadAddress = 0x200);
+
+	ByteClass getByteClass(word address) const;
+	bool isInstruction(word address) const;
+
+	// Sorted by start address
+	const std::vector<Chip8BasicBlock> & getBlocks() const;
+
+	// The block that contains the address, or nullptr if it is data
+	const Chip8BasicBlock *findBlock(word address) const;
+
+	// Bytes classified as instructions or operands
+	long getCodeByteCount() const;
+
+	bool hasUnresolvedJumps() const;
+
+	// One line per block with its successors
+	void print(FILE *file) const;
+
+	// Graphviz dot format
+	void printDot(FILE *file) const;
+
+private:
+	word fetchOpCode(word address) const;
+	bool isInProgram(word address, word length = 1) const;
+	word getInstructionLength(word address) const;
+
+	void trace(word start);
+	bool addIndirectTargets(word runStart, word address, std::vector<Chip8CfgEdge> & edges) const;
+	void splitIntoBlocks();
+
+private:
+	const byte *m_program;
+	size_t m_size;
+	word m_loadAddress;
+	bool m_usesVipHires;
+
+	// One entry per byte of the program
+	std::vector<ByteClass> m_classes;
+	std::vector<bool> m_leaders;
+
+	// Edges of the instructions that end a block, indexed by their offset in the program
+	std::vector<std::vector<Chip8CfgEdge>> m_edges;
+	std::vector<bool> m_unresolved;
+
+	std::vector<word> m_pending;
+	std::vector<Chip8BasicBlock> m_blocks;
+	long m_codeByteCount;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+class Chip8Coverage
+{
+public:
+	Chip8Coverage();
+	~Chip8Coverage();
+
+	// Mark an instruction fetch (an instruction occupies two bytes)
+	inline void markFetch(word address)
+	{
+		m_bitmap[address >> 6] |= 1ull << (address & 63);
+
+		// The second byte wraps around like the fetch does
+		address = static_cast<word>(address + 1);
+		m_bitmap[address >> 6] |= 1ull << (address & 63);
+	}
+
+	bool isExecuted(word address) const;
+	void reset();
+	void merge(const Chip8Coverage & other);
+
+	// Coverage files are raw bitmaps, loading a file merges it into the current bitmap
+	bool mergeFromFile(const char *path);
+	bool saveToFile(const char *path) const;
+
+	long countExecuted(word startAddress, long size) const;
+
+	// Print executed and never-executed address ranges within [startAddress, startAddress + size)
+	void printReport(word startAddress, long size) const;
+
+public:
+	// The whole 64 KB address space of XO-CHIP, programs for the other profiles only use the first 4 KB
+	static const long ADDRESS_COUNT = 65536;
+	static const long BITMAP_WORDS = ADDRESS_COUNT / 64;
+
+private:
+	// One bit per byte of the address space
+	unsigned long long m_bitmap[BITMAP_WORDS];
+};
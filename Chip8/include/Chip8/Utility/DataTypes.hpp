@@ -1,4 +1,5 @@
 #pragma once
 
 using byte = unsigned char;
-using word = unsigned short;
\ No newline at end of file
+using word = unsigned short;
+using qword = unsigned long long;
\ No newline at end of file
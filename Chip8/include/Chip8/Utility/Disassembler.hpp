@@ -2,15 +2,28 @@
 
 #include "DataTypes.hpp"
 
+#include <cstddef>
+#include <string>
+
+// Forward declarations
+class Chip8Coverage;
+
 class Chip8Disassembler
 {
 public:
 	Chip8Disassembler();
 	~Chip8Disassembler();
 
-	void disassemble(word startLocationOfPC, word memorySize, byte * memory);
+	// Instructions are found by following the control flow from startLocationOfPC, unreachable bytes are listed as data
+	void disassemble(word startLocationOfPC, word memorySize, byte * memory, const Chip8Coverage * coverage = nullptr);
+
+	// Appends the listing that disassemble prints, so it can be written with a single call or cached
+	void formatListing(word startLocationOfPC, word memorySize, const byte * memory, const Chip8Coverage * coverage, std::string & listing);
 	static void printOpCode(word opCode);
 
+	// Writes the assembly of an OpCode without a line break and returns its length, like snprintf
+	static int formatOpCode(word opCode, char *buffer, size_t size);
+
 private:
 	word m_PC;
 	word m_opCode;
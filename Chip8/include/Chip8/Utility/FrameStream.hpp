@@ -0,0 +1,116 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <cstdio>
+#include <vector>
+
+// Recording of display frames. Every frame is stored as the XOR difference with the previous frame: a bitmap of the
+// 64-bit display words that changed, followed by a byte mask and the non-zero bytes of every changed word. Unchanged
+// frames take one byte. A complete keyframe is stored at a fixed interval and whenever the display size changes, and an
+// index of all keyframes at the end of the file makes seeking to any frame cheap.
+//
+// File layout:
+//     header    "C8FS", version, display width, display height, keyframe interval
+//     records   type (keyframe / delta / repeat / mode) followed by its payload, a mode record carries the new display
+//               size and is always followed by a keyframe
+//     index     frame number, display size and file offset of every keyframe
+//     footer    index offset, keyframe count, frame count, "C8FI"
+
+struct FrameStreamKeyframe
+{
+	long frame;
+	long long offset;	// Of the mode record in front of the keyframe, if there is one
+	int width;
+	int height;
+};
+
+class FrameStreamWriter
+{
+public:
+	FrameStreamWriter();
+	~FrameStreamWriter();
+
+	bool open(const char *path, int width = 64, int height = 32, int keyframeInterval = 600);
+
+	// A frame of another size than the previous one starts with a mode record and a keyframe
+	bool writeFrame(const qword *graphicsMemory, int width, int height);
+
+	// Writes the index, a stream that was not closed can still be read but has to be scanned once
+	bool close();
+
+	long getFrameCount() const;
+	long long getBytesWritten() const;
+
+private:
+	FILE *m_file;
+	int m_keyframeInterval;
+	int m_width;
+	int m_height;
+	int m_wordCount;
+
+	std::vector<qword> m_previousFrame;
+	std::vector<byte> m_record;
+	std::vector<FrameStreamKeyframe> m_keyframes;
+
+	long m_frameCount;
+	long m_framesSinceKeyframe;
+	long long m_bytesWritten;
+	bool m_writeFailed;
+};
+
+class FrameStreamReader
+{
+public:
+	FrameStreamReader();
+	~FrameStreamReader();
+
+	bool open(const char *path);
+	void close();
+
+	// Reconstruct a frame, sequential reads continue from the previous frame instead of going back to a keyframe. The
+	// buffer has to hold getMaxWordCount() words, getWidth() and getHeight() tell the size of the frame.
+	bool readFrame(long frame, qword *graphicsMemory);
+
+	long getFrameCount() const;
+	int getKeyframeInterval() const;
+
+	// Display size of the frame that was read last, or of the first frame before any frame was read
+	int getWidth() const;
+	int getHeight() const;
+
+	// Words of the largest frame in the stream
+	int getMaxWordCount() const;
+
+	// Every display size change starts a keyframe, so the keyframes also tell where the size changes
+	const std::vector<FrameStreamKeyframe> & getKeyframes() const;
+
+	// True when the index was missing and had to be rebuilt by scanning the file
+	bool wasIndexRebuilt() const;
+
+private:
+	bool readHeader();
+	bool readIndex();
+	bool rebuildIndex();
+	bool readRecord(bool & isKeyframe);
+	void setDisplaySize(int width, int height);
+
+private:
+	FILE *m_file;
+	unsigned int m_version;
+	int m_headerWidth;
+	int m_headerHeight;
+	int m_width;
+	int m_height;
+	int m_keyframeInterval;
+	int m_wordCount;
+	long long m_dataStart;
+
+	std::vector<FrameStreamKeyframe> m_keyframes;
+	long m_frameCount;
+	bool m_indexRebuilt;
+
+	// The last decoded frame and its number, the file position is right behind its record
+	std::vector<qword> m_currentFrame;
+	long m_currentFrameNumber;
+};
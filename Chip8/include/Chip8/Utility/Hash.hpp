@@ -0,0 +1,20 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <cstddef>
+
+// 64-bit FNV-1a, pass the result of a previous call as the seed to hash multiple buffers as one
+inline unsigned long long hashBytes(const void *data, size_t size, unsigned long long seed = 0xCBF29CE484222325ull)
+{
+	const byte *bytes = static_cast<const byte *>(data);
+	unsigned long long hash = seed;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
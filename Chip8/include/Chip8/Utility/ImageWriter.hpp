@@ -0,0 +1,17 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <vector>
+
+// Encoders for the bit-packed display (width / 64 words per row, most significant bit is the leftmost pixel). Every
+// display pixel becomes a scale x scale block, colors are 0xRRGGBB.
+
+// Two color palette PNG with one bit per pixel, stored without compression so encoding costs next to nothing
+void encodePng(const qword *rows, int width, int height, int scale, unsigned int onColor, unsigned int offColor, std::vector<byte> & output);
+
+// Stream header of a Y4M (YUV4MPEG2) video with full resolution chroma (C444) at 60 frames per second
+void encodeY4mHeader(int width, int height, int scale, std::vector<byte> & output);
+
+// One "FRAME" of a Y4M stream, BT.601 limited range
+void encodeY4mFrame(const qword *rows, int width, int height, int scale, unsigned int onColor, unsigned int offColor, std::vector<byte> & output);
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <cstddef>
+
+// Every instruction the interpreter knows, the names follow the handlers of Chip8Processor
+enum class Instruction : byte
+{
+	SCDnibble,
+	SCUnibble,
+	SCR,
+	SCL,
+	EXIT,
+	LOW,
+	HIGH,
+	CLS,
+	RET,
+	SYSaddr,
+	JPaddr,
+	CALLaddr,
+	SEvxbyte,
+	SNEvxbyte,
+	SAVEvxvy,
+	LOADvxvy,
+	SEvxvy,
+	LDvxbyte,
+	ADDvxbyte,
+	LDvxvy,
+	ORvxvy,
+	ANDvxvy,
+	XORvxvy,
+	ADDvxvy,
+	SUBvxvy,
+	SHRvxvy,
+	SUBNvxvy,
+	SHLvxvy,
+	SNEvxvy,
+	LDiaddr,
+	JPv0addr,
+	RNDvxbyte,
+	DRWvxvynibble,
+	SKPvx,
+	SKNPvx,
+	LDilong,
+	PLANEn,
+	AUDIO,
+	LDvxdt,
+	LDvxk,
+	LDdtvx,
+	LDstvx,
+	ADDivx,
+	LDfvx,
+	LDhfvx,
+	LDbvx,
+	PITCHvx,
+	LDivx,
+	LDvxi,
+	LDrvx,
+	LDvxr,
+	INVALID		// Does nothing
+};
+
+// Properties that engines and analyses specialise on
+struct InstructionFlags
+{
+	// Control flow, everything except these continues with the next instruction
+	static constexpr unsigned int JUMP = 1 << 0;			// 1nnn
+	static constexpr unsigned int CALL = 1 << 1;			// 2nnn
+	static constexpr unsigned int SKIP = 1 << 2;			// Conditionally skips the next instruction
+	static constexpr unsigned int INDIRECT_JUMP = 1 << 3;	// Bnnn, the target depends on a register
+	static constexpr unsigned int RETURN = 1 << 4;			// 00EE
+	static constexpr unsigned int EXIT = 1 << 5;			// 00FD
+	static constexpr unsigned int ENDS_BLOCK = JUMP | CALL | SKIP | INDIRECT_JUMP | RETURN | EXIT;
+
+	static constexpr unsigned int SETS_INDEX = 1 << 6;		// Loads or changes I
+	static constexpr unsigned int READS_MEMORY = 1 << 7;	// Reads the memory at I
+	static constexpr unsigned int WRITES_MEMORY = 1 << 8;	// Writes the memory at I
+	static constexpr unsigned int WRITES_VF = 1 << 9;		// Always stores a flag in VF
+	static constexpr unsigned int DRAWS = 1 << 10;			// Changes the display
+	static constexpr unsigned int READS_KEYS = 1 << 11;
+	static constexpr unsigned int WAITS = 1 << 12;			// Blocks until a key is pressed
+	static constexpr unsigned int QUIRKS = 1 << 13;			// Behaves differently between quirk profiles
+
+	static constexpr unsigned int SUPER_CHIP = 1 << 14;
+	static constexpr unsigned int XO_CHIP = 1 << 15;
+};
+
+// One encoding of an instruction. The operands are printed from a template where {x} and {y} are register indices,
+// {n} is the low nibble, {kk} the low byte, and {nnn} the address.
+struct InstructionDescriptor
+{
+	Instruction instruction;
+	word mask;
+	word pattern;
+	const char *mnemonic;
+	const char *operands;
+	byte length;			// In bytes, F000 nnnn is followed by its address
+	unsigned int flags;
+};
+
+// The first encoding that matches an OpCode decodes it, so special cases come before general ones. No mask includes
+// the x nibble, the interpreter ignores it for 00Cn, 00E0 and the other instructions that start with 0.
+static constexpr InstructionDescriptor INSTRUCTION_DESCRIPTORS[] =
+{
+	{ Instruction::SCDnibble, 0xF0F0, 0x00C0, "SCD", "{n}", 2, InstructionFlags::DRAWS | InstructionFlags::SUPER_CHIP },
+	{ Instruction::SCUnibble, 0xF0F0, 0x00D0, "SCU", "{n}", 2, InstructionFlags::DRAWS | InstructionFlags::XO_CHIP },
+	{ Instruction::SCR, 0xF0FF, 0x00FB, "SCR", "", 2, InstructionFlags::DRAWS | InstructionFlags::SUPER_CHIP },
+	{ Instruction::SCL, 0xF0FF, 0x00FC, "SCL", "", 2, InstructionFlags::DRAWS | InstructionFlags::SUPER_CHIP },
+	{ Instruction::EXIT, 0xF0FF, 0x00FD, "EXIT", "", 2, InstructionFlags::EXIT | InstructionFlags::SUPER_CHIP },
+	{ Instruction::LOW, 0xF0FF, 0x00FE, "LOW", "", 2, InstructionFlags::DRAWS | InstructionFlags::SUPER_CHIP },
+	{ Instruction::HIGH, 0xF0FF, 0x00FF, "HIGH", "", 2, InstructionFlags::DRAWS | InstructionFlags::SUPER_CHIP },
+	{ Instruction::SYSaddr, 0xF0F0, 0x00F0, "SYS", "{nnn}", 2, 0 },
+
+	// 0230 is the CLS of the VIP two-page hires interpreter, which clears all 64 rows
+	{ Instruction::CLS, 0xF00F, 0x0000, "CLS", "", 2, InstructionFlags::DRAWS },
+	{ Instruction::RET, 0xF00F, 0x000E, "RET", "", 2, InstructionFlags::RETURN },
+	{ Instruction::SYSaddr, 0xF000, 0x0000, "SYS", "{nnn}", 2, 0 },
+
+	{ Instruction::JPaddr, 0xF000, 0x1000, "JP", "{nnn}", 2, InstructionFlags::JUMP },
+	{ Instruction::CALLaddr, 0xF000, 0x2000, "CALL", "{nnn}", 2, InstructionFlags::CALL },
+	{ Instruction::SEvxbyte, 0xF000, 0x3000, "SE", "V{x}, {kk}", 2, InstructionFlags::SKIP },
+	{ Instruction::SNEvxbyte, 0xF000, 0x4000, "SNE", "V{x}, {kk}", 2, InstructionFlags::SKIP },
+	{ Instruction::SAVEvxvy, 0xF00F, 0x5002, "SAVE", "V{x} - V{y}", 2, InstructionFlags::WRITES_MEMORY | InstructionFlags::XO_CHIP },
+	{ Instruction::LOADvxvy, 0xF00F, 0x5003, "LOAD", "V{x} - V{y}", 2, InstructionFlags::READS_MEMORY | InstructionFlags::XO_CHIP },
+	{ Instruction::SEvxvy, 0xF000, 0x5000, "SE", "V{x}, V{y}", 2, InstructionFlags::SKIP },
+	{ Instruction::LDvxbyte, 0xF000, 0x6000, "LD", "V{x}, {kk}", 2, 0 },
+	{ Instruction::ADDvxbyte, 0xF000, 0x7000, "ADD", "V{x}, {kk}", 2, 0 },
+	{ Instruction::LDvxvy, 0xF00F, 0x8000, "LD", "V{x}, V{y}", 2, 0 },
+	{ Instruction::ORvxvy, 0xF00F, 0x8001, "OR", "V{x}, V{y}", 2, 0 },
+	{ Instruction::ANDvxvy, 0xF00F, 0x8002, "AND", "V{x}, V{y}", 2, 0 },
+	{ Instruction::XORvxvy, 0xF00F, 0x8003, "XOR", "V{x}, V{y}", 2, 0 },
+	{ Instruction::ADDvxvy, 0xF00F, 0x8004, "ADD", "V{x}, V{y}", 2, InstructionFlags::WRITES_VF },
+	{ Instruction::SUBvxvy, 0xF00F, 0x8005, "SUB", "V{x}, V{y}", 2, InstructionFlags::WRITES_VF },
+	{ Instruction::SHRvxvy, 0xF00F, 0x8006, "SHR", "V{x} {, V{y}}", 2, InstructionFlags::WRITES_VF | InstructionFlags::QUIRKS },
+	{ Instruction::SUBNvxvy, 0xF00F, 0x8007, "SUBN", "V{x}, V{y}", 2, InstructionFlags::WRITES_VF },
+	{ Instruction::SHLvxvy, 0xF00F, 0x800E, "SHL", "V{x} {, V{y}}", 2, InstructionFlags::WRITES_VF | InstructionFlags::QUIRKS },
+	{ Instruction::SNEvxvy, 0xF000, 0x9000, "SNE", "V{x}, V{y}", 2, InstructionFlags::SKIP },
+	{ Instruction::LDiaddr, 0xF000, 0xA000, "LD", "I, {nnn}", 2, InstructionFlags::SETS_INDEX },
+	{ Instruction::JPv0addr, 0xF000, 0xB000, "JP", "V0, {nnn}", 2, InstructionFlags::INDIRECT_JUMP | InstructionFlags::QUIRKS },
+	{ Instruction::RNDvxbyte, 0xF000, 0xC000, "RND", "V{x}, {kk}", 2, 0 },
+	{ Instruction::DRWvxvynibble, 0xF000, 0xD000, "DRW", "V{x}, V{y}, {n}", 2,
+		InstructionFlags::READS_MEMORY | InstructionFlags::WRITES_VF | InstructionFlags::DRAWS | InstructionFlags::QUIRKS },
+	{ Instruction::SKPvx, 0xF0FF, 0xE09E, "SKP", "V{x}", 2, InstructionFlags::SKIP | InstructionFlags::READS_KEYS },
+	{ Instruction::SKNPvx, 0xF0FF, 0xE0A1, "SKNP", "V{x}", 2, InstructionFlags::SKIP | InstructionFlags::READS_KEYS },
+	{ Instruction::LDilong, 0xF0FF, 0xF000, "LD", "I, long", 4, InstructionFlags::SETS_INDEX | InstructionFlags::XO_CHIP },
+	{ Instruction::PLANEn, 0xF0FF, 0xF001, "PLANE", "{x}", 2, InstructionFlags::XO_CHIP },
+	{ Instruction::AUDIO, 0xF0FF, 0xF002, "AUDIO", "", 2, InstructionFlags::READS_MEMORY | InstructionFlags::XO_CHIP },
+	{ Instruction::LDvxdt, 0xF0FF, 0xF007, "LD", "V{x}, DT", 2, 0 },
+	{ Instruction::LDvxk, 0xF0FF, 0xF00A, "LD", "V{x}, K", 2, InstructionFlags::READS_KEYS | InstructionFlags::WAITS },
+	{ Instruction::LDdtvx, 0xF0FF, 0xF015, "LD", "DT, V{x}", 2, 0 },
+	{ Instruction::LDstvx, 0xF0FF, 0xF018, "LD", "ST, V{x}", 2, 0 },
+	{ Instruction::ADDivx, 0xF0FF, 0xF01E, "ADD", "I, V{x}", 2, InstructionFlags::SETS_INDEX },
+	{ Instruction::LDfvx, 0xF0FF, 0xF029, "LD", "F, V{x}", 2, InstructionFlags::SETS_INDEX },
+	{ Instruction::LDhfvx, 0xF0FF, 0xF030, "LD", "HF, V{x}", 2, InstructionFlags::SETS_INDEX | InstructionFlags::SUPER_CHIP },
+	{ Instruction::LDbvx, 0xF0FF, 0xF033, "LD", "B, V{x}", 2, InstructionFlags::WRITES_MEMORY },
+	{ Instruction::PITCHvx, 0xF0FF, 0xF03A, "PITCH", "V{x}", 2, InstructionFlags::XO_CHIP },
+	{ Instruction::LDivx, 0xF0FF, 0xF055, "LD", "[I], V{x}", 2, InstructionFlags::WRITES_MEMORY | InstructionFlags::QUIRKS },
+	{ Instruction::LDvxi, 0xF0FF, 0xF065, "LD", "V{x}, [I]", 2, InstructionFlags::READS_MEMORY | InstructionFlags::QUIRKS },
+	{ Instruction::LDrvx, 0xF0FF, 0xF075, "LD", "R, V{x}", 2, InstructionFlags::SUPER_CHIP },
+	{ Instruction::LDvxr, 0xF0FF, 0xF085, "LD", "V{x}, R", 2, InstructionFlags::SUPER_CHIP },
+
+	// Unknown 8xyn, Exkk and Fxkk OpCodes
+	{ Instruction::INVALID, 0x0000, 0x0000, "", "", 2, 0 },
+};
+
+static constexpr size_t INSTRUCTION_DESCRIPTOR_COUNT = sizeof(INSTRUCTION_DESCRIPTORS) / sizeof(INSTRUCTION_DESCRIPTORS[0]);
+
+// Maps the first nibble and the low byte of every OpCode to its descriptor, which is enough because no mask includes the
+// x nibble. Generated at compile time from the descriptors above. The instruction is stored as well, so the dispatch of
+// an engine needs a single load.
+struct InstructionDecodeTable
+{
+	byte descriptorIndex[16 * 256];
+	Instruction instruction[16 * 256];
+};
+
+constexpr InstructionDecodeTable makeInstructionDecodeTable()
+{
+	InstructionDecodeTable table = {};
+
+	for (int key = 0; key < 16 * 256; ++key)
+	{
+		word opCode = static_cast<word>((key & 0xF00) << 4 | (key & 0xFF));
+
+		size_t index = 0;
+		while ((opCode & INSTRUCTION_DESCRIPTORS[index].mask) != INSTRUCTION_DESCRIPTORS[index].pattern)
+			++index;
+
+		table.descriptorIndex[key] = static_cast<byte>(index);
+		table.instruction[key] = INSTRUCTION_DESCRIPTORS[index].instruction;
+	}
+
+	return table;
+}
+
+constexpr bool masksIgnoreX()
+{
+	for (const InstructionDescriptor & descriptor : INSTRUCTION_DESCRIPTORS)
+	{
+		if ((descriptor.mask & 0x0F00) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+static_assert(masksIgnoreX(), "The decode table has no room for the x nibble");
+static_assert(INSTRUCTION_DESCRIPTORS[INSTRUCTION_DESCRIPTOR_COUNT - 1].mask == 0, "The last descriptor must match every OpCode");
+
+static constexpr InstructionDecodeTable INSTRUCTION_DECODE_TABLE = makeInstructionDecodeTable();
+
+constexpr int getInstructionDecodeKey(word opCode)
+{
+	return (opCode >> 4 & 0xF00) | (opCode & 0xFF);
+}
+
+constexpr const InstructionDescriptor & decodeInstruction(word opCode)
+{
+	return INSTRUCTION_DESCRIPTORS[INSTRUCTION_DECODE_TABLE.descriptorIndex[getInstructionDecodeKey(opCode)]];
+}
+
+// Whether the first nibble alone decides the instruction, as it does for 1nnn - 4xkk, 6xkk, 7xkk, and 9xy0 - Dxyn
+constexpr bool isDecodedByFirstNibble(int group)
+{
+	for (int key = group << 8; key < (group + 1) << 8; ++key)
+	{
+		if (INSTRUCTION_DECODE_TABLE.instruction[key] != INSTRUCTION_DECODE_TABLE.instruction[group << 8])
+			return false;
+	}
+
+	return true;
+}
+
+template <int GROUP>
+constexpr Instruction decodeInstructionInGroup(word opCode)
+{
+	if constexpr (isDecodedByFirstNibble(GROUP))
+		return INSTRUCTION_DECODE_TABLE.instruction[GROUP << 8];
+	else
+		return INSTRUCTION_DECODE_TABLE.instruction[getInstructionDecodeKey(opCode)];
+}
+
+// Groups that the first nibble decides return a constant, so an engine that switches on the result gets a direct jump
+// for them once this is inlined. The other groups look the instruction up.
+constexpr Instruction decodeInstructionId(word opCode)
+{
+	switch (opCode >> 12)
+	{
+	case 0x0: return decodeInstructionInGroup<0x0>(opCode);
+	case 0x1: return decodeInstructionInGroup<0x1>(opCode);
+	case 0x2: return decodeInstructionInGroup<0x2>(opCode);
+	case 0x3: return decodeInstructionInGroup<0x3>(opCode);
+	case 0x4: return decodeInstructionInGroup<0x4>(opCode);
+	case 0x5: return decodeInstructionInGroup<0x5>(opCode);
+	case 0x6: return decodeInstructionInGroup<0x6>(opCode);
+	case 0x7: return decodeInstructionInGroup<0x7>(opCode);
+	case 0x8: return decodeInstructionInGroup<0x8>(opCode);
+	case 0x9: return decodeInstructionInGroup<0x9>(opCode);
+	case 0xA: return decodeInstructionInGroup<0xA>(opCode);
+	case 0xB: return decodeInstructionInGroup<0xB>(opCode);
+	case 0xC: return decodeInstructionInGroup<0xC>(opCode);
+	case 0xD: return decodeInstructionInGroup<0xD>(opCode);
+	case 0xE: return decodeInstructionInGroup<0xE>(opCode);
+	default: return decodeInstructionInGroup<0xF>(opCode);
+	}
+}
+
+static_assert(decodeInstructionId(0x0230) == Instruction::CLS, "0230 is the CLS of the VIP hires interpreter");
+static_assert(decodeInstructionId(0x00F0) == Instruction::SYSaddr, "00F0 is not a SUPER-CHIP instruction");
+static_assert(decodeInstructionId(0x5121) == Instruction::SEvxvy, "5xyn is 5xy0 unless n is 2 or 3");
+static_assert(decodeInstructionId(0x8128) == Instruction::INVALID, "8xy8 does not exist");
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Chip8/Emulator/Quirks.hpp"
+#include "DataTypes.hpp"
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+// Known ROMs, keyed by the hash of their content
+struct Chip8RomDatabaseEntry
+{
+	unsigned long long hash;
+	QuirkProfile quirkProfile;
+	int cyclesPerFrame;
+	std::string source;		// What the profile was derived from: metadata, directory, year, analysis, or manual
+	std::string name;
+};
+
+// Databases are tab separated text files, one ROM per line: hash, quirk profile, cycles per frame, source, name.
+// Lines starting with # are comments.
+class Chip8RomDatabase
+{
+public:
+	Chip8RomDatabase();
+	~Chip8RomDatabase();
+
+	bool load(const char *path);
+	bool save(const char *path) const;
+
+	void add(const Chip8RomDatabaseEntry & entry);
+	const Chip8RomDatabaseEntry *find(unsigned long long hash) const;
+	size_t getEntryCount() const;
+
+private:
+	std::map<unsigned long long, Chip8RomDatabaseEntry> m_entries;
+};
+
+struct Chip8RomAnalysis
+{
+	unsigned long long hash;
+
+	// Settings to run the ROM with
+	QuirkProfile quirkProfile;
+	int cyclesPerFrame;
+
+	// The settings come from a database entry, otherwise they are guessed from the instructions below
+	bool fromDatabase;
+
+	// Instructions found on the paths reachable from the entry point
+	bool usesVipHires;			// Starts with the jump over the VIP two-page hires interpreter
+	bool usesSuperChip;			// 00Cn, 00FB - 00FF, Fx30, Fx75, Fx85
+	bool usesXoChip;			// 00Dn, 5xy2, 5xy3, F000 nnnn, Fn01, F002, Fx3A
+	bool shiftsVy;				// 8xy6 / 8xyE with x != y and y != 0
+	bool reliesOnIndexIncrement;	// Fx55 / Fx65 followed by another one of the same kind without reloading I
+	bool reliesOnUnchangedIndex;	// Fx55 / Fx65 followed by a different access to the same memory without reloading I
+	bool jumpsWithOffset;		// Bnnn, its quirk cannot be decided statically
+	long reachableBytes;		// Bytes of the ROM that were classified as code
+};
+
+// Fingerprints ROMs and picks a quirk profile and speed for them. ROMs that are not in the database are judged by the
+// instructions in their control flow graph.
+class Chip8RomAnalyzer
+{
+public:
+	static unsigned long long hashRom(const byte *rom, size_t size);
+
+	// The database is optional, without it (or without an entry for the ROM) only the heuristics are used
+	static Chip8RomAnalysis analyze(const byte *rom, size_t size, const Chip8RomDatabase *database = nullptr);
+
+	// Typical speed of the interpreters the profiles model
+	static int getRecommendedCyclesPerFrame(QuirkProfile profile);
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A read-only view of a file, memory mapped where the platform allows it
+class Chip8RomMapping
+{
+public:
+	Chip8RomMapping();
+	~Chip8RomMapping();
+
+	Chip8RomMapping(const Chip8RomMapping &) = delete;
+	Chip8RomMapping & operator=(const Chip8RomMapping &) = delete;
+
+	bool open(const char *path);
+	void close();
+
+	// Empty files are valid and have no data
+	const byte *getData() const;
+	size_t getSize() const;
+
+private:
+	const byte *m_data;
+	size_t m_size;
+
+	// Fallback for platforms without mmap
+	std::vector<byte> m_buffer;
+};
+
+struct Chip8RomLibraryEntry
+{
+	unsigned long long hash;
+	std::string path;			// Relative to the library directory
+	long long size;
+	long long modifiedTime;		// Detects files that changed after the index was written
+
+	// Taken from file names like "Astro Dodge [Revival Studios, 2008].ch8", the author and year may be missing
+	std::string title;
+	std::string author;
+	int year;
+
+	// First line of the .txt file next to the ROM, empty when there is none
+	std::string description;
+};
+
+// Every ROM below a directory with its hash and metadata. Scanning maps and hashes each file, so the result is kept in
+// a binary index file that later runs load instead.
+class Chip8RomLibrary
+{
+public:
+	Chip8RomLibrary();
+	~Chip8RomLibrary();
+
+	// Loads the index when it belongs to the directory, otherwise scans the directory and writes a new index
+	bool open(const char *directory, const char *indexPath);
+
+	bool scan(const char *directory);
+	bool loadIndex(const char *indexPath);
+	bool saveIndex(const char *indexPath) const;
+
+	const std::vector<Chip8RomLibraryEntry> & getEntries() const;
+	const Chip8RomLibraryEntry *find(unsigned long long hash) const;
+	std::string getFullPath(const Chip8RomLibraryEntry & entry) const;
+
+	// Fails when the file is gone or differs in size or modification time from the index, scan again in that case
+	bool map(const Chip8RomLibraryEntry & entry, Chip8RomMapping & mapping) const;
+
+	// Every .ch8 file below the directories, sorted so the order does not depend on the file system. Directories that
+	// cannot be read are reported and skipped.
+	static std::vector<std::string> findRoms(const std::vector<std::string> & directories);
+
+private:
+	void addEntry(const Chip8RomLibraryEntry & entry);
+
+private:
+	std::string m_directory;
+	std::vector<Chip8RomLibraryEntry> m_entries;
+
+	// Index into m_entries, identical ROMs under different names resolve to the first one
+	std::unordered_map<unsigned long long, size_t> m_entriesByHash;
+};
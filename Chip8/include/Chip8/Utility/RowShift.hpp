@@ -0,0 +1,8 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+// Shift every row of a bit-packed display (most significant bit is the leftmost pixel) horizontally by 1 to 63 pixels.
+// Rows are rowWords 64-bit words wide, pixels shifted out of a row are lost and blank pixels are shifted in.
+void shiftBitPackedRowsLeft(qword *rows, int rowWords, int rowCount, int pixels);
+void shiftBitPackedRowsRight(qword *rows, int rowWords, int rowCount, int pixels);
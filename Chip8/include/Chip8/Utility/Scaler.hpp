@@ -0,0 +1,10 @@
+#pragma once
+
+#include "DataTypes.hpp"
+
+#include <cstddef>
+
+// Expand rows of a bit-packed display (most significant bit is the leftmost pixel) into 32-bit pixels. Every display pixel
+// becomes a scale x scale block, rows are rowWords 64-bit words wide and the pitch of the output is given in pixels.
+void scaleBitPackedRows(const qword *rows, int rowWords, int firstRow, int rowCount, int scale,
+	unsigned int onColor, unsigned int offColor, unsigned int *pixels, size_t pitch);
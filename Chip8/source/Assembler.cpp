@@ -0,0 +1,59 @@
+#include "Chip8/Utility/Assembler.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <iostream>
+
+Chip8Assembler::Chip8Assembler(word origin)
+	: m_origin(origin)
+{
+}
+
+Chip8Assembler::~Chip8Assembler()
+{
+}
+
+word Chip8Assembler::here() const
+{
+	return static_cast<word>(m_origin + m_bytes.size());
+}
+
+void Chip8Assembler::emit(word opCode)
+{
+	// OpCodes are stored big-endian
+	m_bytes.push_back(static_cast<byte>(opCode >> 8));
+	m_bytes.push_back(static_cast<byte>(opCode & 0xFF));
+}
+
+void Chip8Assembler::emitByte(byte value)
+{
+	m_bytes.push_back(value);
+}
+
+void Chip8Assembler::patch(word address, word opCode)
+{
+	size_t offset = address - m_origin;
+
+	if (offset + 1 >= m_bytes.size())
+		return;
+
+	m_bytes[offset + 0] = static_cast<byte>(opCode >> 8);
+	m_bytes[offset + 1] = static_cast<byte>(opCode & 0xFF);
+}
+
+const std::vector<byte> & Chip8Assembler::getBytes() const
+{
+	return m_bytes;
+}
+
+bool Chip8Assembler::save(const char *path) const
+{
+	FILE *filePtr = fopen(path, "wb");
+
+	if (filePtr == nullptr)
+		return false;
+
+	size_t bytesWritten = fwrite(m_bytes.data(), sizeof(byte), m_bytes.size(), filePtr);
+	fclose(filePtr);
+
+	return bytesWritten == m_bytes.size();
+}
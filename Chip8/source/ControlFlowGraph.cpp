@@ -0,0 +1,596 @@
+#include "Chip8/Utility/ControlFlowGraph.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/InstructionSet.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <iostream>
+
+// A Bnnn offset register that can hold more values than this is treated as unbounded
+static const size_t MAX_INDIRECT_TARGETS = 32;
+
+// The values a register can hold at a point of the program, all bits set when nothing is known
+typedef std::bitset<256> ValueSet;
+
+static ValueSet makeValue(int value)
+{
+	ValueSet values;
+	values.set(value & 0xFF);
+	return values;
+}
+
+template <typename Operation>
+static ValueSet mapValues(const ValueSet & values, Operation operation)
+{
+	ValueSet result;
+	for (int value = 0; value < 256; ++value)
+	{
+		if (values[value])
+			result.set(operation(value) & 0xFF);
+	}
+
+	return result;
+}
+
+// Both operands of 8xyn come from the same register when x == y, so only equal values are combined
+template <typename Operation>
+static ValueSet combineValues(const ValueSet & a, const ValueSet & b, bool sameRegister, Operation operation)
+{
+	if (sameRegister)
+		return mapValues(a, [operation](int value) { return operation(value, value); });
+
+	if (a.all() && b.all())
+		return ValueSet().set();
+
+	ValueSet result;
+	for (int first = 0; first < 256; ++first)
+	{
+		if (!a[first])
+			continue;
+
+		for (int second = 0; second < 256; ++second)
+		{
+			if (b[second])
+				result.set(operation(first, second) & 0xFF);
+		}
+	}
+
+	return result;
+}
+
+// Updates the value sets of the registers an instruction writes
+static void applyInstruction(word opCode, ValueSet *registers)
+{
+	byte x = (opCode & 0x0F00) >> 8;
+	byte y = (opCode & 0x00F0) >> 4;
+	byte kk = opCode & 0x00FF;
+
+	const ValueSet FLAG = makeValue(0) | makeValue(1);
+
+	switch (decodeInstructionId(opCode))
+	{
+	case Instruction::LDvxbyte:
+		registers[x] = makeValue(kk);
+		break;
+
+	case Instruction::ADDvxbyte:
+		registers[x] = mapValues(registers[x], [kk](int value) { return value + kk; });
+		break;
+
+	case Instruction::LDvxvy:
+		registers[x] = registers[y];
+		break;
+
+	case Instruction::ORvxvy:
+		registers[x] = combineValues(registers[x], registers[y], x == y, [](int a, int b) { return a | b; });
+		break;
+
+	case Instruction::ANDvxvy:
+		registers[x] = combineValues(registers[x], registers[y], x == y, [](int a, int b) { return a & b; });
+		break;
+
+	case Instruction::XORvxvy:
+		registers[x] = combineValues(registers[x], registers[y], x == y, [](int a, int b) { return a ^ b; });
+		break;
+
+	case Instruction::ADDvxvy:
+		registers[x] = combineValues(registers[x], registers[y], x == y, [](int a, int b) { return a + b; });
+		registers[0xF] = FLAG;
+		break;
+
+	case Instruction::SUBvxvy:
+		registers[x] = combineValues(registers[x], registers[y], x == y, [](int a, int b) { return a - b; });
+		registers[0xF] = FLAG;
+		break;
+
+	case Instruction::SUBNvxvy:
+		registers[x] = combineValues(registers[x], registers[y], x == y, [](int a, int b) { return b - a; });
+		registers[0xF] = FLAG;
+		break;
+
+	// The profile is not known, so the shifts take the values of both Vx and Vy into account
+	case Instruction::SHRvxvy:
+		registers[x] = mapValues(x == y ? registers[x] : registers[x] | registers[y], [](int value) { return value >> 1; });
+		registers[0xF] = FLAG;
+		break;
+
+	case Instruction::SHLvxvy:
+		registers[x] = mapValues(x == y ? registers[x] : registers[x] | registers[y], [](int value) { return value << 1; });
+		registers[0xF] = FLAG;
+		break;
+
+	case Instruction::RNDvxbyte:
+		registers[x] = mapValues(ValueSet().set(), [kk](int value) { return value & kk; });
+		break;
+
+	// The delay timer and key reads
+	case Instruction::LDvxdt:
+	case Instruction::LDvxk:
+		registers[x].set();
+		break;
+
+	// Loads of V0 through Vx from memory or the flag registers
+	case Instruction::LDvxi:
+	case Instruction::LDvxr:
+		for (byte i = 0; i <= x; ++i)
+			registers[i].set();
+		break;
+
+	// Loads of Vx through Vy from memory
+	case Instruction::LOADvxvy:
+		for (byte i = std::min(x, y); i <= std::max(x, y); ++i)
+			registers[i].set();
+		break;
+
+	default:
+		break;
+	}
+}
+
+// Returns false for instructions that continue with the next one
+static bool findBlockEnd(word opCode, BlockEnd & blockEnd)
+{
+	unsigned flags = decodeInstruction(opCode).flags;
+
+	if ((flags & InstructionFlags::ENDS_BLOCK) == 0)
+		return false;
+
+	if (flags & InstructionFlags::RETURN)
+		blockEnd = BlockEnd::RETURN;
+	else if (flags & InstructionFlags::EXIT)
+		blockEnd = BlockEnd::EXIT;
+	else if (flags & InstructionFlags::JUMP)
+		blockEnd = BlockEnd::JUMP;
+	else if (flags & InstructionFlags::CALL)
+		blockEnd = BlockEnd::CALL;
+	else if (flags & InstructionFlags::SKIP)
+		blockEnd = BlockEnd::SKIP;
+	else
+		blockEnd = BlockEnd::INDIRECT;
+
+	return true;
+}
+
+static const char *getBlockEndName(BlockEnd blockEnd)
+{
+	switch (blockEnd)
+	{
+	case BlockEnd::FALLTHROUGH:
+		return "fallthrough";
+
+	case BlockEnd::JUMP:
+		return "jump";
+
+	case BlockEnd::CALL:
+		return "call";
+
+	case BlockEnd::SKIP:
+		return "skip";
+
+	case BlockEnd::INDIRECT:
+		return "indirect";
+
+	case BlockEnd::RETURN:
+		return "return";
+
+	case BlockEnd::EXIT:
+		return "exit";
+
+	case BlockEnd::END_OF_PROGRAM:
+		return "end of program";
+
+	default:
+		return "unknown";
+	}
+}
+
+static const char *getEdgeKindName(EdgeKind kind)
+{
+	switch (kind)
+	{
+	case EdgeKind::FALLTHROUGH:
+		return "fallthrough";
+
+	case EdgeKind::JUMP:
+		return "jump";
+
+	case EdgeKind::CALL:
+		return "call";
+
+	case EdgeKind::SKIP:
+		return "skip";
+
+	case EdgeKind::INDIRECT:
+		return "indirect";
+
+	default:
+		return "unknown";
+	}
+}
+
+Chip8ControlFlowGraph::Chip8ControlFlowGraph()
+	: m_program(nullptr)
+	, m_size(0)
+	, m_loadAddress(0x200)
+	, m_usesVipHires(false)
+	, m_codeByteCount(0)
+{
+}
+
+Chip8ControlFlowGraph::~Chip8ControlFlowGraph()
+{
+}
+
+void Chip8ControlFlowGraph::build(const byte *program, size_t size, word loadAddress)
+{
+	m_program = program;
+	m_size = size;
+	m_loadAddress = loadAddress;
+
+	m_classes.assign(size, ByteClass::DATA);
+	m_leaders.assign(size, false);
+	m_edges.assign(size, std::vector<Chip8CfgEdge>());
+	m_unresolved.assign(size, false);
+	m_blocks.clear();
+
+	m_usesVipHires = loadAddress == 0x200 && fetchOpCode(0x200) == 0x1260;
+
+	trace(loadAddress);
+	splitIntoBlocks();
+
+	m_codeByteCount = static_cast<long>(std::count_if(m_classes.begin(), m_classes.end(), [](ByteClass byteClass) { return byteClass != ByteClass::DATA; }));
+
+	// The program is only borrowed while building
+	m_program = nullptr;
+}
+
+ByteClass Chip8ControlFlowGraph::getByteClass(word address) const
+{
+	return isInProgram(address) ? m_classes[address - m_loadAddress] : ByteClass::DATA;
+}
+
+bool Chip8ControlFlowGraph::isInstruction(word address) const
+{
+	return getByteClass(address) == ByteClass::INSTRUCTION;
+}
+
+const std::vector<Chip8BasicBlock> & Chip8ControlFlowGraph::getBlocks() const
+{
+	return m_blocks;
+}
+
+const Chip8BasicBlock *Chip8ControlFlowGraph::findBlock(word address) const
+{
+	// The last block that starts at or before the address
+	auto block = std::upper_bound(m_blocks.begin(), m_blocks.end(), address, [](word value, const Chip8BasicBlock & item) { return value < item.start; });
+
+	if (block == m_blocks.begin())
+		return nullptr;
+
+	--block;
+	return address < block->end ? &*block : nullptr;
+}
+
+long Chip8ControlFlowGraph::getCodeByteCount() const
+{
+	return m_codeByteCount;
+}
+
+bool Chip8ControlFlowGraph::hasUnresolvedJumps() const
+{
+	return std::any_of(m_blocks.begin(), m_blocks.end(), [](const Chip8BasicBlock & block) { return block.unresolved; });
+}
+
+void Chip8ControlFlowGraph::print(FILE *file) const
+{
+	fprintf(file, "%zu blocks, %li of %zu bytes are code%s\n", m_blocks.size(), m_codeByteCount, m_classes.size(),
+		hasUnresolvedJumps() ? ", some indirect jumps are unresolved" : "");
+
+	for (const Chip8BasicBlock & block : m_blocks)
+	{
+		fprintf(file, "0x%04X - 0x%04X  %-14s", block.start, block.end - 1, getBlockEndName(block.blockEnd));
+
+		for (const Chip8CfgEdge & edge : block.successors)
+			fprintf(file, " %s 0x%04X", getEdgeKindName(edge.kind), edge.target);
+
+		fprintf(file, "%s\n", block.unresolved ? " (unresolved)" : "");
+	}
+}
+
+void Chip8ControlFlowGraph::printDot(FILE *file) const
+{
+	fprintf(file, "digraph cfg {\n");
+	fprintf(file, "  node [shape=box, fontname=monospace];\n");
+
+	for (const Chip8BasicBlock & block : m_blocks)
+	{
+		fprintf(file, "  b%04X [label=\"0x%04X - 0x%04X\\n%s\"%s];\n", block.start, block.start, block.end - 1, getBlockEndName(block.blockEnd),
+			block.unresolved ? ", color=red" : "");
+
+		for (const Chip8CfgEdge & edge : block.successors)
+		{
+			fprintf(file, "  b%04X -> b%04X [label=\"%s\"%s];\n", block.start, edge.target, getEdgeKindName(edge.kind),
+				edge.kind == EdgeKind::CALL || edge.kind == EdgeKind::INDIRECT ? ", style=dashed" : "");
+		}
+	}
+
+	fprintf(file, "}\n");
+}
+
+word Chip8ControlFlowGraph::fetchOpCode(word address) const
+{
+	if (!isInProgram(address, 2))
+		return 0x0000;
+
+	size_t offset = address - m_loadAddress;
+	return static_cast<word>(m_program[offset] << 8 | m_program[offset + 1]);
+}
+
+bool Chip8ControlFlowGraph::isInProgram(word address, word length) const
+{
+	return address >= m_loadAddress && static_cast<size_t>(address - m_loadAddress) + length <= m_size;
+}
+
+word Chip8ControlFlowGraph::getInstructionLength(word address) const
+{
+	// F000 nnnn (XO-CHIP) is the only four byte instruction
+	return decodeInstruction(fetchOpCode(address)).length;
+}
+
+void Chip8ControlFlowGraph::trace(word start)
+{
+	m_pending.push_back(m_usesVipHires ? 0x2C0 : start);
+
+	if (m_usesVipHires)
+	{
+		// The jump at 0x200 runs the hires interpreter, which continues with the CHIP-8 program at 0x2C0
+		m_classes[0] = ByteClass::INSTRUCTION;
+		m_classes[1] = ByteClass::OPERAND;
+		m_leaders[0] = true;
+		m_edges[0].push_back({ 0x2C0, EdgeKind::JUMP });
+	}
+
+	while (!m_pending.empty())
+	{
+		word runStart = m_pending.back();
+		m_pending.pop_back();
+
+		if (!isInProgram(runStart, 2))
+			continue;
+
+		m_leaders[runStart - m_loadAddress] = true;
+
+		// Decode straight ahead until the path leaves or reaches code that was already traced
+		for (word address = runStart; isInProgram(address, 2); )
+		{
+			size_t offset = address - m_loadAddress;
+			if (m_classes[offset] == ByteClass::INSTRUCTION)
+				break;
+
+			word opCode = fetchOpCode(address);
+			word length = getInstructionLength(address);
+			word next = address + length;
+
+			// F000 in the last two bytes of the program has no address after it, the bytes stay data
+			if (!isInProgram(address, length))
+				break;
+
+			// Instructions win over operands where paths decode the same bytes differently
+			m_classes[offset] = ByteClass::INSTRUCTION;
+			for (size_t i = offset + 1; i < offset + length && i < m_size; ++i)
+			{
+				if (m_classes[i] == ByteClass::DATA)
+					m_classes[i] = ByteClass::OPERAND;
+			}
+
+			BlockEnd blockEnd;
+			if (!findBlockEnd(opCode, blockEnd))
+			{
+				address = next;
+				continue;
+			}
+
+			std::vector<Chip8CfgEdge> & edges = m_edges[offset];
+
+			switch (blockEnd)
+			{
+			case BlockEnd::JUMP:
+				edges.push_back({ static_cast<word>(opCode & 0x0FFF), EdgeKind::JUMP });
+				break;
+
+			case BlockEnd::CALL:
+				edges.push_back({ static_cast<word>(opCode & 0x0FFF), EdgeKind::CALL });
+				edges.push_back({ next, EdgeKind::FALLTHROUGH });
+				break;
+
+			case BlockEnd::SKIP:
+				edges.push_back({ next, EdgeKind::FALLTHROUGH });
+				edges.push_back({ static_cast<word>(next + getInstructionLength(next)), EdgeKind::SKIP });
+				break;
+
+			case BlockEnd::INDIRECT:
+				m_unresolved[offset] = !addIndirectTargets(runStart, address, edges);
+				break;
+
+			default:
+				break;
+			}
+
+			for (const Chip8CfgEdge & edge : edges)
+				m_pending.push_back(edge.target);
+
+			break;
+		}
+	}
+}
+
+bool Chip8ControlFlowGraph::addIndirectTargets(word runStart, word address, std::vector<Chip8CfgEdge> & edges) const
+{
+	// Nothing is known about the registers where the run starts
+	ValueSet registers[16];
+	for (ValueSet & values : registers)
+		values.set();
+
+	bool conditional = false;
+
+	for (word pc = runStart; pc < address; pc += getInstructionLength(pc))
+	{
+		word opCode = fetchOpCode(pc);
+
+		// The instruction after a skip may not run, so the registers hold the values from before or after it
+		ValueSet before[16];
+		if (conditional)
+			std::copy(registers, registers + 16, before);
+
+		applyInstruction(opCode, registers);
+
+		if (conditional)
+		{
+			for (int i = 0; i < 16; ++i)
+				registers[i] |= before[i];
+		}
+
+		BlockEnd blockEnd;
+		conditional = findBlockEnd(opCode, blockEnd) && blockEnd == BlockEnd::SKIP;
+
+		// Subroutines may change any register
+		if (decodeInstructionId(opCode) == Instruction::CALLaddr)
+		{
+			for (ValueSet & values : registers)
+				values.set();
+		}
+	}
+
+	word opCode = fetchOpCode(address);
+	word base = opCode & 0x0FFF;
+	byte x = (opCode & 0x0F00) >> 8;
+
+	// The COSMAC VIP jumps to nnn + V0, CHIP-48 and SUPER-CHIP to xnn + Vx. The profile is not known yet, so the targets
+	// of every interpretation whose register is bounded are followed.
+	ValueSet offsets;
+	bool bounded = false;
+
+	for (byte i : { static_cast<byte>(0), x })
+	{
+		if (registers[i].count() <= MAX_INDIRECT_TARGETS)
+		{
+			offsets |= registers[i];
+			bounded = true;
+		}
+	}
+
+	if (bounded)
+	{
+		for (int value = 0; value < 256; ++value)
+		{
+			word target = base + value;
+			if (offsets[value] && isInProgram(target, 2))
+				edges.push_back({ target, EdgeKind::INDIRECT });
+		}
+
+		return true;
+	}
+
+	// An unbounded offset into a table of jumps is the usual dispatch, e.g. "SHL V0" followed by "JP V0, table". The
+	// table is followed while it holds 1nnn instructions, but the block stays unresolved. A table right after the Bnnn is
+	// often addressed from the Bnnn itself, with offsets starting at 2.
+	word table = base == address ? base + 2 : base;
+	for (word entry = table; entry < base + 256 && isInProgram(entry, 2) && decodeInstructionId(fetchOpCode(entry)) == Instruction::JPaddr; entry += 2)
+		edges.push_back({ entry, EdgeKind::INDIRECT });
+
+	return false;
+}
+
+void Chip8ControlFlowGraph::splitIntoBlocks()
+{
+	bool open = false;
+
+	// Blocks that end because the next instruction is the target of another edge continue with it
+	auto closeOpenBlock = [this, &open]()
+	{
+		if (!open)
+			return;
+
+		Chip8BasicBlock & block = m_blocks.back();
+		if (isInstruction(block.end))
+		{
+			block.blockEnd = BlockEnd::FALLTHROUGH;
+			block.successors.push_back({ block.end, EdgeKind::FALLTHROUGH });
+		}
+		else
+		{
+			block.blockEnd = BlockEnd::END_OF_PROGRAM;
+		}
+
+		open = false;
+	};
+
+	for (size_t offset = 0; offset < m_size; ++offset)
+	{
+		if (m_classes[offset] != ByteClass::INSTRUCTION)
+			continue;
+
+		word address = static_cast<word>(m_loadAddress + offset);
+
+		if (open && (m_leaders[offset] || address != m_blocks.back().end))
+			closeOpenBlock();
+
+		if (!open)
+		{
+			Chip8BasicBlock block;
+			block.start = address;
+			block.end = address;
+			block.lastInstruction = address;
+			block.blockEnd = BlockEnd::FALLTHROUGH;
+			block.unresolved = false;
+
+			m_blocks.push_back(block);
+			open = true;
+		}
+
+		Chip8BasicBlock & block = m_blocks.back();
+		block.end = address + getInstructionLength(address);
+		block.lastInstruction = address;
+
+		BlockEnd blockEnd;
+		if (findBlockEnd(fetchOpCode(address), blockEnd))
+		{
+			block.blockEnd = blockEnd;
+			block.successors = m_edges[offset];
+			block.unresolved = m_unresolved[offset];
+			open = false;
+		}
+	}
+
+	closeOpenBlock();
+
+	for (const Chip8BasicBlock & block : m_blocks)
+	{
+		for (const Chip8CfgEdge & edge : block.successors)
+		{
+			auto target = std::lower_bound(m_blocks.begin(), m_blocks.end(), edge.target, [](const Chip8BasicBlock & item, word value) { return item.start < value; });
+			if (target != m_blocks.end() && target->start == edge.target)
+				target->predecessors.push_back(block.start);
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#include "Chip8/Utility/Coverage.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <iostream>
+
+Chip8Coverage::Chip8Coverage()
+{
+	reset();
+}
+
+Chip8Coverage::~Chip8Coverage()
+{
+}
+
+bool Chip8Coverage::isExecuted(word address) const
+{
+	return ((m_bitmap[address >> 6] >> (address & 63)) & 1) == 1;
+}
+
+void Chip8Coverage::reset()
+{
+	for (long i = 0; i < BITMAP_WORDS; ++i)
+		m_bitmap[i] = 0;
+}
+
+void Chip8Coverage::merge(const Chip8Coverage & other)
+{
+	for (long i = 0; i < BITMAP_WORDS; ++i)
+		m_bitmap[i] |= other.m_bitmap[i];
+}
+
+bool Chip8Coverage::mergeFromFile(const char *path)
+{
+	FILE *filePtr = fopen(path, "rb");
+
+	if (filePtr == nullptr)
+		return false;
+
+	// Files from earlier runs of the same ROM are OR-ed into the current bitmap
+	Chip8Coverage fileCoverage;
+	size_t wordsRead = fread(fileCoverage.m_bitmap, sizeof(unsigned long long), BITMAP_WORDS, filePtr);
+	fclose(filePtr);
+
+	if (wordsRead != BITMAP_WORDS)
+		return false;
+
+	merge(fileCoverage);
+	return true;
+}
+
+bool Chip8Coverage::saveToFile(const char *path) const
+{
+	FILE *filePtr = fopen(path, "wb");
+
+	if (filePtr == nullptr)
+		return false;
+
+	size_t wordsWritten = fwrite(m_bitmap, sizeof(unsigned long long), BITMAP_WORDS, filePtr);
+	fclose(filePtr);
+
+	return wordsWritten == BITMAP_WORDS;
+}
+
+long Chip8Coverage::countExecuted(word startAddress, long size) const
+{
+	long count = 0;
+
+	for (long i = 0; i < size; ++i)
+	{
+		if (isExecuted(static_cast<word>(startAddress + i)))
+			++count;
+	}
+
+	return count;
+}
+
+void Chip8Coverage::printReport(word startAddress, long size) const
+{
+	long executed = countExecuted(startAddress, size);
+
+	printf("=================================\n");
+	printf("Coverage | Start  | End    | Bytes\n");
+	printf("=================================\n");
+
+	// Walk the range and print every run of addresses that share the same state
+	long regionStart = 0;
+	while (regionStart < size)
+	{
+		bool regionExecuted = isExecuted(static_cast<word>(startAddress + regionStart));
+
+		long regionEnd = regionStart + 1;
+		while (regionEnd < size && isExecuted(static_cast<word>(startAddress + regionEnd)) == regionExecuted)
+			++regionEnd;
+
+		printf("%s\t 0x%04lX 0x%04lX %li\n",
+			regionExecuted ? "executed" : "never   ",
+			startAddress + regionStart,
+			startAddress + regionEnd - 1,
+			regionEnd - regionStart);
+
+		regionStart = regionEnd;
+	}
+
+	printf("=================================\n");
+	printf("%li of %li bytes executed (%.1f%%)\n", executed, size, size > 0 ? 100.0 * executed / size : 0.0);
+}
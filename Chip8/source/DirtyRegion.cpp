@@ -0,0 +1,117 @@
+#include "Chip8/Emulator/DirtyRegion.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <algorithm>
+
+DirtyRegion::DirtyRegion()
+	: m_rectCount(0)
+{
+}
+
+DirtyRegion::~DirtyRegion()
+{
+}
+
+void DirtyRegion::add(byte x, byte y, byte width, byte height)
+{
+	if (width == 0 || height == 0)
+		return;
+
+	DirtyRect rect = { x, y, width, height };
+
+	// Absorb every rectangle the new one overlaps or touches, merging can make it touch others, so repeat until stable
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+
+		for (int i = 0; i < m_rectCount; ++i)
+		{
+			if (touches(rect, m_rects[i]))
+			{
+				rect = merge(rect, m_rects[i]);
+				m_rects[i] = m_rects[--m_rectCount];
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	if (m_rectCount < MAX_RECTS)
+	{
+		m_rects[m_rectCount++] = rect;
+		return;
+	}
+
+	// The set is full, merge with the rectangle that results in the smallest increase in area
+	int bestIndex = 0;
+	long bestGrowth = -1;
+	for (int i = 0; i < m_rectCount; ++i)
+	{
+		long growth = area(merge(rect, m_rects[i])) - area(m_rects[i]);
+		if (bestGrowth < 0 || growth < bestGrowth)
+		{
+			bestGrowth = growth;
+			bestIndex = i;
+		}
+	}
+
+	m_rects[bestIndex] = merge(rect, m_rects[bestIndex]);
+}
+
+void DirtyRegion::addAll(byte displayWidth, byte displayHeight)
+{
+	m_rects[0] = { 0, 0, displayWidth, displayHeight };
+	m_rectCount = 1;
+}
+
+void DirtyRegion::clear()
+{
+	m_rectCount = 0;
+}
+
+bool DirtyRegion::isEmpty() const
+{
+	return m_rectCount == 0;
+}
+
+int DirtyRegion::getRectCount() const
+{
+	return m_rectCount;
+}
+
+const DirtyRect & DirtyRegion::getRect(int index) const
+{
+	return m_rects[index];
+}
+
+long DirtyRegion::getArea() const
+{
+	long total = 0;
+
+	for (int i = 0; i < m_rectCount; ++i)
+		total += area(m_rects[i]);
+
+	return total;
+}
+
+DirtyRect DirtyRegion::merge(const DirtyRect & a, const DirtyRect & b)
+{
+	int left = std::min(a.x, b.x);
+	int top = std::min(a.y, b.y);
+	int right = std::max(a.x + a.width, b.x + b.width);
+	int bottom = std::max(a.y + a.height, b.y + b.height);
+
+	return { static_cast<byte>(left), static_cast<byte>(top), static_cast<byte>(right - left), static_cast<byte>(bottom - top) };
+}
+
+bool DirtyRegion::touches(const DirtyRect & a, const DirtyRect & b)
+{
+	return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+		a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+long DirtyRegion::area(const DirtyRect & rect)
+{
+	return static_cast<long>(rect.width) * rect.height;
+}
@@ -1,6 +1,12 @@
 #include "Chip8/Utility/Disassembler.hpp"
 #include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/ControlFlowGraph.hpp"
+#include "Chip8/Utility/Coverage.hpp"
+#include "Chip8/Utility/InstructionSet.hpp"
 
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
 #include <iostream>
 
 Chip8Disassembler::Chip8Disassembler()
@@ -11,212 +17,155 @@ Chip8Disassembler::~Chip8Disassembler()
 {
 }
 
-void Chip8Disassembler::disassemble(word startLocationOfPC, word memorySize, byte * memory)
+// Appends formatted text to a listing, the lines are short enough for the stack buffer
+static void appendFormat(std::string & listing, const char *format, ...)
 {
-	m_PC = startLocationOfPC;
+	char text[128];
 
-	// Column names in the disassembly console view
-	printf("=================================\n");
-	printf("Index | OpCode | Assembly Command\n");
-	printf("=================================\n");
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(text, sizeof(text), format, arguments);
+	va_end(arguments);
 
-	// Add the offset of the PC to the memory size to get the correct end of the binary data in the ROM
-	while (m_PC < startLocationOfPC + memorySize)
-	{
-		// Fetch OpCode
-		word opCode = memory[m_PC] << 8 | memory[m_PC + 1];
-
-		// Print the program counter and OpCode values in hexadecimal
-		printf("0x%04X\t0x%04X\t", m_PC, opCode);
-
-		// Check the current OpCode against all known OpCodes
-		printOpCode(opCode);
-
-		// Move the program counter one instruction ahead (2 bytes)
-		m_PC += 2;
-	}
+	if (length > 0)
+		listing.append(text, std::min(static_cast<size_t>(length), sizeof(text) - 1));
 }
 
-void Chip8Disassembler::printOpCode(word opCode)
+void Chip8Disassembler::disassemble(word startLocationOfPC, word memorySize, byte * memory, const Chip8Coverage * coverage)
 {
-	// Decode the first number of the OpCode
-	switch (opCode & 0xF000)
-	{
-	case 0x0000:
-		switch (opCode & 0x000F)
-		{
-		case 0x0000:
-			printf("CLS\n");
-			break;
-
-		case 0x000E:
-			printf("RET\n");
-			break;
-
-		default:
-			// The "SYS" command that calls a RCA 1802 program
-			printf("SYS\t0x%3X\n", opCode & 0x0FFF);
-			break;
-		}
-		break;
-
-	case 0x1000:
-		printf("JP\t0x%3X\n", opCode & 0x0FFF);
-		break;
-
-	case 0x2000:
-		printf("CALL\t0x%3X\n", opCode & 0x0FFF);
-		break;
+	// The whole listing is formatted first and written at once
+	std::string listing;
+	formatListing(startLocationOfPC, memorySize, memory, coverage, listing);
+	fwrite(listing.data(), 1, listing.size(), stdout);
+}
 
-	case 0x3000:
-		printf("SE\tV%1X, 0x%2X\n", (opCode & 0x0F00) >> 8, opCode & 0x00FF);
-		break;
+void Chip8Disassembler::formatListing(word startLocationOfPC, word memorySize, const byte * memory, const Chip8Coverage * coverage, std::string & listing)
+{
+	// Only the bytes on paths from the entry point are decoded as instructions, everything else is printed as data
+	Chip8ControlFlowGraph controlFlowGraph;
+	controlFlowGraph.build(memory + startLocationOfPC, memorySize, startLocationOfPC);
 
-	case 0x4000:
-		printf("SNE\tV%1X, 0x%2X\n", (opCode & 0x0F00) >> 8, opCode & 0x00FF);
-		break;
+	// Column names in the disassembly console view (the coverage column is only shown when coverage data is available)
+	listing += "=================================\n";
+	listing += coverage != nullptr ? "Hit | Index | OpCode | Assembly Command\n" : "Index | OpCode | Assembly Command\n";
+	listing += "=================================\n";
 
-	case 0x5000:
-		printf("SE\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-		break;
+	// The bytes are counted separately from the 16-bit PC, which wraps around when a ROM ends at the top of the memory
+	for (size_t offset = 0; offset < memorySize; )
+	{
+		m_PC = static_cast<word>(startLocationOfPC + offset);
+		bool executed = coverage != nullptr && coverage->isExecuted(m_PC);
 
-	case 0x6000:
-		printf("LD\tV%1X, %i\n", (opCode & 0x0F00) >> 8, opCode & 0x00FF);
-		break;
+		// The traversal cannot bound every Bnnn, so bytes that were fetched while running are instructions as well
+		bool isInstruction = controlFlowGraph.isInstruction(m_PC) || (executed && controlFlowGraph.getByteClass(m_PC) == ByteClass::DATA);
 
-	case 0x7000:
-		printf("ADD\tV%1X, %i\n", (opCode & 0x0F00) >> 8, opCode & 0x00FF);
-		break;
+		// An instruction cut off by the end of the ROM is shown as data, the bytes after it are not part of the ROM
+		if (isInstruction && (offset + 2 > memorySize || offset + decodeInstruction(memory[m_PC] << 8 | memory[m_PC + 1]).length > memorySize))
+			isInstruction = false;
 
-	case 0x8000:
-		switch (opCode & 0x000F)
+		// Label the basic blocks that are entered from anywhere other than the end of the block right before them
+		const Chip8BasicBlock *block = controlFlowGraph.findBlock(m_PC);
+		if (block != nullptr && block->start == m_PC && !block->predecessors.empty() &&
+			(block->predecessors.size() > 1 || controlFlowGraph.findBlock(block->predecessors[0])->end != m_PC))
 		{
-		case 0x0000:
-			printf("LD\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x0001:
-			printf("OR\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x0002:
-			printf("AND\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x0003:
-			printf("XOR\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x0004:
-			printf("ADD\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x0005:
-			printf("SUB\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x0006:
-			printf("SHR\tV%1X {, V%1X}\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x0007:
-			printf("SUBN\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		case 0x000E:
-			printf("SHL\tV%1X {, V%1X}\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-			break;
-
-		default:
-			printf("\n");
-			break;
+			appendFormat(listing, "; 0x%04X <-", m_PC);
+			for (word predecessor : block->predecessors)
+				appendFormat(listing, " 0x%04X", predecessor);
+			listing += '\n';
 		}
-		break;
-
-	case 0x9000:
-		printf("SNE\tV%1X, V%1X\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4);
-		break;
-
-	case 0xA000:
-		printf("LD\tI, 0x%3X\n", opCode & 0x0FFF);
-		break;
-
-	case 0xB000:
-		printf("JP\tV0, 0x%3X\n", opCode & 0x0FFF);
-		break;
 
-	case 0xC000:
-		printf("RND\tV%1X, %i\n", (opCode & 0x0F00) >> 8, opCode & 0x00FF);
-		break;
+		// Mark instructions that have been fetched at least once
+		if (coverage != nullptr)
+			listing += executed ? "*\t" : "-\t";
 
-	case 0xD000:
-		printf("DRW\tV%1X, V%1X, %i\n", (opCode & 0x0F00) >> 8, (opCode & 0x00F0) >> 4, (opCode & 0x000F));
-		break;
-
-	case 0xE000:
-		switch (opCode & 0x00FF)
+		if (!isInstruction)
 		{
-		case 0x009E:
-			printf("SKP\tkeys[V%1X]\n", (opCode & 0x0F00) >> 8);
-			break;
-
-		case 0x00A1:
-			printf("SKNP\tkeys[V%1X]\n", (opCode & 0x0F00) >> 8);
-			break;
-
-		default:
-			printf("\n");
-			break;
+			// Data is shown one byte per line, with its bits drawn the way a sprite row would appear on screen
+			byte value = memory[m_PC];
+			char pixels[9] = {};
+			for (int bit = 0; bit < 8; ++bit)
+				pixels[bit] = (value & (0x80 >> bit)) != 0 ? '#' : '.';
+
+			appendFormat(listing, "0x%04X\t0x%02X\tDB\t0x%02X\t%s\n", m_PC, value, value, pixels);
+			offset += 1;
+			continue;
 		}
-		break;
 
-	case 0xF000:
-		switch (opCode & 0x00FF)
-		{
-		case 0x0007:
-			printf("LD\tV%1X, DT\n", (opCode & 0x0F00) >> 8);
-			break;
+		// Fetch OpCode
+		word opCode = memory[m_PC] << 8 | memory[m_PC + 1];
 
-		case 0x000A:
-			printf("LD\tV%1X, K\n", (opCode & 0x0F00) >> 8);
-			break;
+		// Print the program counter and OpCode values in hexadecimal
+		appendFormat(listing, "0x%04X\t0x%04X\t", m_PC, opCode);
 
-		case 0x0015:
-			printf("LD\tDT, V%1X\n", (opCode & 0x0F00) >> 8);
-			break;
+		// F000 nnnn (XO-CHIP) is the only four byte instruction, its address is shown instead of being decoded as an OpCode
+		if (decodeInstruction(opCode).length == 4)
+		{
+			appendFormat(listing, "LD\tI, 0x%04X\n", memory[m_PC + 2] << 8 | memory[m_PC + 3]);
+			offset += 4;
+			continue;
+		}
 
-		case 0x0018:
-			printf("LD\tST, V%1X\n", (opCode & 0x0F00) >> 8);
-			break;
+		// Check the current OpCode against all known OpCodes
+		char text[32];
+		int length = formatOpCode(opCode, text, sizeof(text));
+		listing.append(text, std::min(static_cast<size_t>(length), sizeof(text) - 1));
+		listing += '\n';
 
-		case 0x001E:
-			printf("ADD\tI, V%1X\n", (opCode & 0x0F00) >> 8);
-			break;
+		// Move the program counter one instruction ahead (2 bytes)
+		offset += 2;
+	}
+}
 
-		case 0x0029:
-			printf("LD\tF, V%1X\n", (opCode & 0x0F00) >> 8);
-			break;
+void Chip8Disassembler::printOpCode(word opCode)
+{
+	char text[32];
+	formatOpCode(opCode, text, sizeof(text));
+	printf("%s\n", text);
+}
 
-		case 0x0033:
-			printf("LD\tB, V%1X\n", (opCode & 0x0F00) >> 8);
-			break;
+int Chip8Disassembler::formatOpCode(word opCode, char *buffer, size_t size)
+{
+	const InstructionDescriptor & descriptor = decodeInstruction(opCode);
 
-		case 0x0055:
-			printf("LD\t[I], V%1X\n", (opCode & 0x0F00) >> 8);
-			break;
+	int length = snprintf(buffer, size, "%s%s", descriptor.mnemonic, descriptor.operands[0] != '\0' ? "\t" : "");
 
-		case 0x0065:
-			printf("LD\tV%1X, [I]\n", (opCode & 0x0F00) >> 8);
-			break;
+	// Expand the placeholders of the operand template
+	for (const char *operand = descriptor.operands; *operand != '\0' && length >= 0 && static_cast<size_t>(length) < size; )
+	{
+		char *end = buffer + length;
+		size_t remaining = size - length;
 
-		default:
-			printf("\n");
-			break;
+		if (strncmp(operand, "{x}", 3) == 0)
+		{
+			length += snprintf(end, remaining, "%X", (opCode & 0x0F00) >> 8);
+			operand += 3;
+		}
+		else if (strncmp(operand, "{y}", 3) == 0)
+		{
+			length += snprintf(end, remaining, "%X", (opCode & 0x00F0) >> 4);
+			operand += 3;
+		}
+		else if (strncmp(operand, "{n}", 3) == 0)
+		{
+			length += snprintf(end, remaining, "%i", opCode & 0x000F);
+			operand += 3;
+		}
+		else if (strncmp(operand, "{kk}", 4) == 0)
+		{
+			length += snprintf(end, remaining, "0x%02X", opCode & 0x00FF);
+			operand += 4;
+		}
+		else if (strncmp(operand, "{nnn}", 5) == 0)
+		{
+			length += snprintf(end, remaining, "0x%03X", opCode & 0x0FFF);
+			operand += 5;
+		}
+		else
+		{
+			length += snprintf(end, remaining, "%c", *operand);
+			operand += 1;
 		}
-		break;
-
-	default:
-		printf("\n");
-		break;
 	}
+
+	return length;
 }
@@ -0,0 +1,249 @@
+#include "Chip8/Emulator/DisplayWall.hpp"
+#include "Chip8/Emulator/Processor.hpp"
+#include "Chip8/Emulator/Shader.hpp"
+#include "Chip8/Emulator/Window.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include "GL/gl3w.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// A tile is one bit-packed 64x32 display
+static const int TILE_ROWS = 32;
+
+DisplayWall::DisplayWall()
+	: m_quadVAO(0)
+	, m_quadVBO(0)
+	, m_shader(0)
+	, m_textureArray(0)
+	, m_instanceCount(0)
+	, m_columns(0)
+	, m_rows(0)
+	, m_uploadedTileCount(0)
+{
+}
+
+DisplayWall::~DisplayWall()
+{
+	// Nothing was created, the OpenGL functions may not even be loaded
+	if (m_shader == 0)
+		return;
+
+	deleteScreenQuad(m_quadVAO, m_quadVBO);
+	glDeleteTextures(1, &m_textureArray);
+	glDeleteProgram(m_shader);
+}
+
+bool DisplayWall::initialize(const Window & window, int instanceCount, int columns, const char *shaderCachePath)
+{
+	int width = 0;
+	int height = 0;
+	window.getFramebufferDimensions(width, height);
+
+	GLint maxLayers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+	if (instanceCount <= 0 || instanceCount > maxLayers)
+	{
+		printf("A display wall supports 1 to %i instances.\n", maxLayers);
+		return false;
+	}
+
+	// Every tile is twice as wide as it is high
+	if (columns <= 0)
+		columns = static_cast<int>(std::ceil(std::sqrt(instanceCount * 0.5f * width / std::max(height, 1))));
+
+	m_instanceCount = instanceCount;
+	m_columns = std::max(1, std::min(columns, instanceCount));
+	m_rows = (instanceCount + m_columns - 1) / m_columns;
+
+	m_frames.assign(static_cast<size_t>(instanceCount) * TILE_ROWS, 0);
+	m_dirtyTiles.assign(instanceCount, 1);
+
+	glViewport(0, 0, width, height);
+	glClearColor(0.223f, 0.8f, 0.8f, 1.0f);	// This color is called "teal"
+
+	if (!setupShaders(shaderCachePath))
+		return false;
+
+	glUseProgram(m_shader);
+	glUniform1i(glGetUniformLocation(m_shader, "textureID"), 0);
+	glUniform2i(glGetUniformLocation(m_shader, "grid"), m_columns, m_rows);
+	glUseProgram(0);
+
+	// White pixels on a black background
+	const float ON_COLOR[3] = { 1.0f, 1.0f, 1.0f };
+	const float OFF_COLOR[3] = { 0.0f, 0.0f, 0.0f };
+	setPalette(ON_COLOR, OFF_COLOR);
+
+	setupTexture();
+	createScreenQuad(m_quadVAO, m_quadVBO);
+
+	return true;
+}
+
+void DisplayWall::publish(int instance, Chip8Processor & processor)
+{
+	if (instance < 0 || instance >= m_instanceCount)
+		return;
+
+	// Nothing was cleared or drawn since the last publish
+	if (processor.getDirtyRegion().isEmpty())
+		return;
+
+	std::lock_guard<std::mutex> lock(m_frameMutex);
+
+	// Tiles show the top left 64x32 pixels of larger displays
+	const qword *graphicsMemory = processor.getGraphicsMemory();
+	int rowWords = processor.getDisplayWidth() / 64;
+
+	for (int y = 0; y < TILE_ROWS; ++y)
+		m_frames[static_cast<size_t>(instance) * TILE_ROWS + y] = graphicsMemory[y * rowWords];
+
+	m_dirtyTiles[instance] = 1;
+
+	processor.clearDirtyRegion();
+}
+
+size_t DisplayWall::update()
+{
+	size_t uploadedBytes = 0;
+
+	std::lock_guard<std::mutex> lock(m_frameMutex);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+
+	// Neighbouring dirty tiles are consecutive layers and consecutive frames, so they are uploaded with a single call
+	int layer = 0;
+	while (layer < m_instanceCount)
+	{
+		if (m_dirtyTiles[layer] == 0)
+		{
+			++layer;
+			continue;
+		}
+
+		int firstLayer = layer;
+		while (layer < m_instanceCount && m_dirtyTiles[layer] != 0)
+			m_dirtyTiles[layer++] = 0;
+
+		int layerCount = layer - firstLayer;
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, firstLayer, 2, TILE_ROWS, layerCount, GL_RED_INTEGER, GL_UNSIGNED_INT,
+			&m_frames[static_cast<size_t>(firstLayer) * TILE_ROWS]);
+
+		uploadedBytes += static_cast<size_t>(layerCount) * TILE_ROWS * sizeof(qword);
+		m_uploadedTileCount += layerCount;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return uploadedBytes;
+}
+
+void DisplayWall::draw() const
+{
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glUseProgram(m_shader);
+
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+	glBindVertexArray(m_quadVAO);
+
+	// One instance per tile, the vertex shader places the quad and picks the texture layer
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, m_instanceCount);
+
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glUseProgram(0);
+}
+
+void DisplayWall::setPalette(const float *onColor, const float *offColor) const
+{
+	setPaletteUniforms(m_shader, onColor, offColor);
+}
+
+int DisplayWall::getInstanceCount() const
+{
+	return m_instanceCount;
+}
+
+int DisplayWall::getColumns() const
+{
+	return m_columns;
+}
+
+int DisplayWall::getRows() const
+{
+	return m_rows;
+}
+
+long DisplayWall::getUploadedTileCount() const
+{
+	return m_uploadedTileCount;
+}
+
+bool DisplayWall::setupShaders(const char *cachePath)
+{
+	const GLchar *const vertexShaderSourceCode =	"#version 330 core\n"
+													"layout(location = 0) in vec2 position;\n"
+													"layout(location = 1) in vec2 texCoord;\n"
+
+													"uniform ivec2 grid;\n"
+
+													"out vec2 uv;\n"
+													"flat out int layer;\n"
+
+													"void main() {\n"
+														// Tiles are laid out left to right, top to bottom, with a small gap in between
+														"ivec2 tile = ivec2(gl_InstanceID % grid.x, gl_InstanceID / grid.x);\n"
+														"vec2 tileSize = 2.0 / vec2(grid);\n"
+														"vec2 tileCenter = vec2(-1.0, 1.0) + (vec2(tile) + 0.5) * tileSize * vec2(1.0, -1.0);\n"
+
+														"uv = texCoord;\n"
+														"layer = gl_InstanceID;\n"
+														"gl_Position = vec4(tileCenter + position * 0.5 * tileSize * 0.96, 0.0, 1.0);\n"
+													"}\0";
+
+	const GLchar *const fragmentShaderSourceCode =	"#version 330 core\n"
+
+													"in vec2 uv;\n"
+													"flat in int layer;\n"
+													"out vec4 fragColor;\n"
+
+													"uniform usampler2DArray textureID;\n"
+													"uniform vec3 onColor;\n"
+													"uniform vec3 offColor;\n"
+
+													"void main() {\n"
+														// Same bit unpacking as the single display renderer
+														"ivec2 pixel = min(ivec2(vec2(uv.x, 1.0 - uv.y) * vec2(64.0, 32.0)), ivec2(63, 31));\n"
+														"uint bit = uint(63 - pixel.x);\n"
+														"uint texel = texelFetch(textureID, ivec3(int(bit >> 5u), pixel.y, layer), 0).r;\n"
+														"float value = float((texel >> (bit & 31u)) & 1u);\n"
+
+														"fragColor = vec4(mix(offColor, onColor, value), 1.0);\n"
+													"}\0";
+
+	return createShaderProgram(vertexShaderSourceCode, fragmentShaderSourceCode, m_shader, cachePath);
+}
+
+void DisplayWall::setupTexture()
+{
+	glGenTextures(1, &m_textureArray);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// One layer per instance, each layer is a bit-packed display of two 32-bit texels per row
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32UI, 2, TILE_ROWS, m_instanceCount, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
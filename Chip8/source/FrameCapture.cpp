@@ -0,0 +1,248 @@
+#include "Chip8/Emulator/FrameCapture.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/ImageWriter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+FrameCapture::FrameCapture()
+	: m_running(false)
+	, m_stopping(false)
+	, m_videoFile(nullptr)
+	, m_nextWrite(0)
+	, m_nextSequence(0)
+	, m_droppedFrameCount(0)
+	, m_writtenFrameCount(0)
+	, m_writeFailed(false)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+	finish();
+}
+
+bool FrameCapture::start(const CaptureSettings & settings)
+{
+	if (m_running)
+		return false;
+
+	m_settings = settings;
+	m_settings.scale = std::max(1, m_settings.scale);
+	m_settings.encoderThreads = std::max(1, m_settings.encoderThreads);
+	m_settings.queueCapacity = std::max(1, m_settings.queueCapacity);
+
+	if (m_settings.displayWidth % 64 != 0 || m_settings.displayWidth / 64 * m_settings.displayHeight > MAX_DISPLAY_WORDS)
+		return false;
+
+	std::error_code error;
+	if (m_settings.format == CaptureFormat::PNG_SEQUENCE)
+	{
+		std::filesystem::create_directories(m_settings.outputPath, error);
+		if (error)
+		{
+			printf("Failed to create the folder %s: %s\n", m_settings.outputPath.c_str(), error.message().c_str());
+			return false;
+		}
+	}
+	else
+	{
+		m_videoFile = fopen(m_settings.outputPath.c_str(), "wb");
+		if (m_videoFile == nullptr)
+		{
+			printf("Failed to create the video %s.\n", m_settings.outputPath.c_str());
+			return false;
+		}
+
+		std::vector<byte> header;
+		encodeY4mHeader(m_settings.displayWidth, m_settings.displayHeight, m_settings.scale, header);
+		fwrite(header.data(), 1, header.size(), m_videoFile);
+	}
+
+	m_slots.assign(m_settings.queueCapacity, Slot());
+	m_freeSlots.clear();
+	for (int i = m_settings.queueCapacity - 1; i >= 0; --i)
+		m_freeSlots.push_back(i);
+
+	m_pendingSlots.clear();
+	m_stopping = false;
+	m_nextWrite = 0;
+	m_nextSequence = 0;
+	m_droppedFrameCount = 0;
+	m_writtenFrameCount = 0;
+	m_writeFailed = false;
+
+	for (int i = 0; i < m_settings.encoderThreads; ++i)
+		m_encoders.emplace_back(&FrameCapture::encoderLoop, this);
+
+	m_running = true;
+
+	return true;
+}
+
+bool FrameCapture::submit(const qword *graphicsMemory, int width, int height)
+{
+	if (!acceptsDisplaySize(width, height))
+		return false;
+
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+
+	if (!m_running)
+		return false;
+
+	if (m_freeSlots.empty())
+	{
+		if (m_settings.backpressure == CaptureBackpressure::DROP)
+		{
+			++m_droppedFrameCount;
+			return false;
+		}
+
+		m_slotAvailable.wait(lock, [this]() { return !m_freeSlots.empty(); });
+	}
+
+	int slotIndex = m_freeSlots.back();
+	m_freeSlots.pop_back();
+
+	Slot & slot = m_slots[slotIndex];
+	memcpy(slot.rows, graphicsMemory, width / 64 * height * sizeof(qword));
+	slot.width = width;
+	slot.height = height;
+
+	// Dropped frames never get a sequence number, so the numbering and the video have no gaps
+	slot.sequence = m_nextSequence++;
+
+	m_pendingSlots.push_back(slotIndex);
+	lock.unlock();
+
+	m_frameAvailable.notify_one();
+
+	return true;
+}
+
+bool FrameCapture::acceptsDisplaySize(int width, int height) const
+{
+	if (width <= 0 || width % 64 != 0 || height <= 0 || width / 64 * height > MAX_DISPLAY_WORDS)
+		return false;
+
+	return m_settings.format == CaptureFormat::PNG_SEQUENCE || (width == m_settings.displayWidth && height == m_settings.displayHeight);
+}
+
+void FrameCapture::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		if (!m_running)
+			return;
+
+		m_running = false;
+		m_stopping = true;
+	}
+
+	// The encoders drain the queue before they exit
+	m_frameAvailable.notify_all();
+
+	for (std::thread & encoder : m_encoders)
+		encoder.join();
+
+	m_encoders.clear();
+
+	if (m_videoFile != nullptr)
+	{
+		fclose(m_videoFile);
+		m_videoFile = nullptr;
+	}
+
+	if (m_writeFailed)
+		printf("Failed to write some of the captured frames to %s.\n", m_settings.outputPath.c_str());
+}
+
+long FrameCapture::getSubmittedFrameCount() const
+{
+	std::lock_guard<std::mutex> lock(m_queueMutex);
+	return m_nextSequence;
+}
+
+long FrameCapture::getDroppedFrameCount() const
+{
+	std::lock_guard<std::mutex> lock(m_queueMutex);
+	return m_droppedFrameCount;
+}
+
+long FrameCapture::getWrittenFrameCount() const
+{
+	std::lock_guard<std::mutex> lock(m_queueMutex);
+	return m_writtenFrameCount;
+}
+
+void FrameCapture::encoderLoop()
+{
+	// Reused for every frame this encoder handles
+	std::vector<byte> encoded;
+	Slot slot;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_frameAvailable.wait(lock, [this]() { return m_stopping || !m_pendingSlots.empty(); });
+
+			if (m_pendingSlots.empty())
+				return;
+
+			int slotIndex = m_pendingSlots.front();
+			m_pendingSlots.pop_front();
+
+			// Give the slot back right away, the emulation may be blocked waiting for one
+			slot = m_slots[slotIndex];
+			m_freeSlots.push_back(slotIndex);
+		}
+
+		m_slotAvailable.notify_one();
+
+		bool written = writeFrame(slot, encoded);
+
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		if (written)
+			++m_writtenFrameCount;
+		else
+			m_writeFailed = true;
+	}
+}
+
+bool FrameCapture::writeFrame(const Slot & slot, std::vector<byte> & encoded)
+{
+	if (m_settings.format == CaptureFormat::PNG_SEQUENCE)
+	{
+		encodePng(slot.rows, slot.width, slot.height, m_settings.scale, m_settings.onColor, m_settings.offColor, encoded);
+
+		char fileName[32];
+		snprintf(fileName, sizeof(fileName), "frame_%06li.png", slot.sequence);
+		std::string path = (std::filesystem::path(m_settings.outputPath) / fileName).string();
+
+		FILE *filePtr = fopen(path.c_str(), "wb");
+		if (filePtr == nullptr)
+			return false;
+
+		bool success = fwrite(encoded.data(), 1, encoded.size(), filePtr) == encoded.size();
+		fclose(filePtr);
+
+		return success;
+	}
+
+	encodeY4mFrame(slot.rows, slot.width, slot.height, m_settings.scale, m_settings.onColor, m_settings.offColor, encoded);
+
+	std::unique_lock<std::mutex> lock(m_writeMutex);
+	m_writeTurn.wait(lock, [this, &slot]() { return m_nextWrite == slot.sequence; });
+
+	bool success = fwrite(encoded.data(), 1, encoded.size(), m_videoFile) == encoded.size();
+
+	++m_nextWrite;
+	lock.unlock();
+
+	m_writeTurn.notify_all();
+
+	return success;
+}
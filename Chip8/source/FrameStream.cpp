@@ -0,0 +1,585 @@
+#include "Chip8/Utility/FrameStream.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const char STREAM_MAGIC[4] = { 'C', '8', 'F', 'S' };
+static const char INDEX_MAGIC[4] = { 'C', '8', 'F', 'I' };
+static const unsigned int STREAM_VERSION = 2;	// Version 1 has no mode records and only the offsets in its index
+
+// The delta bitmap of the largest frame has to fit into 64 bytes
+static const int MAX_WORD_COUNT = 64 * 8;
+
+enum RecordType : byte
+{
+	RECORD_KEYFRAME = 0,	// All words of the frame
+	RECORD_DELTA = 1,		// Changed words only
+	RECORD_REPEAT = 2,		// Same frame as the previous one
+	RECORD_MODE = 3			// New display size, followed by a keyframe
+};
+
+// Integers are stored little-endian, display words are stored with their leftmost pixels first
+static void appendInteger(std::vector<byte> & output, unsigned long long value, int size)
+{
+	for (int i = 0; i < size; ++i)
+		output.push_back(static_cast<byte>(value >> (8 * i)));
+}
+
+static bool readInteger(FILE *filePtr, unsigned long long & value, int size)
+{
+	byte bytes[8];
+	if (fread(bytes, 1, size, filePtr) != static_cast<size_t>(size))
+		return false;
+
+	value = 0;
+	for (int i = 0; i < size; ++i)
+		value |= static_cast<unsigned long long>(bytes[i]) << (8 * i);
+
+	return true;
+}
+
+static inline byte getWordByte(qword value, int index)
+{
+	return static_cast<byte>(value >> (56 - 8 * index));
+}
+
+static bool isValidDisplaySize(unsigned long long width, unsigned long long height)
+{
+	return width > 0 && width % 64 == 0 && height > 0 && width / 64 * height <= MAX_WORD_COUNT;
+}
+
+static long long tell(FILE *filePtr)
+{
+#ifdef _WIN32
+	return _ftelli64(filePtr);
+#else
+	return ftello(filePtr);
+#endif
+}
+
+static bool seek(FILE *filePtr, long long offset, int origin = SEEK_SET)
+{
+#ifdef _WIN32
+	return _fseeki64(filePtr, offset, origin) == 0;
+#else
+	return fseeko(filePtr, offset, origin) == 0;
+#endif
+}
+
+FrameStreamWriter::FrameStreamWriter()
+	: m_file(nullptr)
+	, m_keyframeInterval(600)
+	, m_width(0)
+	, m_height(0)
+	, m_wordCount(0)
+	, m_frameCount(0)
+	, m_framesSinceKeyframe(0)
+	, m_bytesWritten(0)
+	, m_writeFailed(false)
+{
+}
+
+FrameStreamWriter::~FrameStreamWriter()
+{
+	close();
+}
+
+bool FrameStreamWriter::open(const char *path, int width, int height, int keyframeInterval)
+{
+	close();
+
+	if (!isValidDisplaySize(width, height))
+		return false;
+
+	m_file = fopen(path, "wb");
+
+	if (m_file == nullptr)
+		return false;
+
+	m_keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 600;
+	m_width = width;
+	m_height = height;
+	m_wordCount = width / 64 * height;
+	m_previousFrame.assign(m_wordCount, 0);
+	m_keyframes.clear();
+	m_frameCount = 0;
+	m_framesSinceKeyframe = m_keyframeInterval;	// The first frame is a keyframe
+	m_writeFailed = false;
+
+	m_record.assign(STREAM_MAGIC, STREAM_MAGIC + 4);
+	appendInteger(m_record, STREAM_VERSION, 4);
+	appendInteger(m_record, width, 2);
+	appendInteger(m_record, height, 2);
+	appendInteger(m_record, m_keyframeInterval, 4);
+
+	m_bytesWritten = static_cast<long long>(fwrite(m_record.data(), 1, m_record.size(), m_file));
+
+	return m_bytesWritten == static_cast<long long>(m_record.size());
+}
+
+bool FrameStreamWriter::writeFrame(const qword *graphicsMemory, int width, int height)
+{
+	if (m_file == nullptr || !isValidDisplaySize(width, height))
+		return false;
+
+	m_record.clear();
+
+	bool sizeChanged = width != m_width || height != m_height;
+
+	if (sizeChanged || m_framesSinceKeyframe >= m_keyframeInterval)
+	{
+		m_keyframes.push_back({ m_frameCount, m_bytesWritten, width, height });
+		m_framesSinceKeyframe = 0;
+
+		if (sizeChanged)
+		{
+			m_width = width;
+			m_height = height;
+			m_wordCount = width / 64 * height;
+			m_previousFrame.assign(m_wordCount, 0);
+
+			m_record.push_back(RECORD_MODE);
+			appendInteger(m_record, width, 2);
+			appendInteger(m_record, height, 2);
+		}
+
+		m_record.push_back(RECORD_KEYFRAME);
+		for (int i = 0; i < m_wordCount; ++i)
+		{
+			for (int j = 0; j < 8; ++j)
+				m_record.push_back(getWordByte(graphicsMemory[i], j));
+		}
+	}
+	else
+	{
+		// Bitmap of the changed words, the payload of every changed word follows after the complete bitmap
+		const size_t bitmapSize = (m_wordCount + 7) / 8;
+
+		m_record.push_back(RECORD_DELTA);
+		m_record.resize(1 + bitmapSize, 0);
+
+		for (int i = 0; i < m_wordCount; ++i)
+		{
+			qword difference = graphicsMemory[i] ^ m_previousFrame[i];
+			if (difference == 0)
+				continue;
+
+			m_record[1 + i / 8] |= static_cast<byte>(1 << (i % 8));
+
+			// A sprite changes one or two bytes of a row, so only the non-zero bytes are stored
+			size_t maskIndex = m_record.size();
+			m_record.push_back(0);
+
+			for (int j = 0; j < 8; ++j)
+			{
+				byte value = getWordByte(difference, j);
+				if (value == 0)
+					continue;
+
+				m_record[maskIndex] |= static_cast<byte>(1 << j);
+				m_record.push_back(value);
+			}
+		}
+
+		if (m_record.size() == 1 + bitmapSize)
+		{
+			bool unchanged = true;
+			for (size_t i = 1; i < m_record.size() && unchanged; ++i)
+				unchanged = m_record[i] == 0;
+
+			if (unchanged)
+				m_record.assign(1, RECORD_REPEAT);
+		}
+	}
+
+	memcpy(m_previousFrame.data(), graphicsMemory, m_wordCount * sizeof(qword));
+
+	size_t written = fwrite(m_record.data(), 1, m_record.size(), m_file);
+	m_bytesWritten += static_cast<long long>(written);
+
+	if (written != m_record.size())
+		m_writeFailed = true;
+
+	++m_frameCount;
+	++m_framesSinceKeyframe;
+
+	return !m_writeFailed;
+}
+
+bool FrameStreamWriter::close()
+{
+	if (m_file == nullptr)
+		return false;
+
+	long long indexOffset = m_bytesWritten;
+
+	m_record.clear();
+	for (const FrameStreamKeyframe & keyframe : m_keyframes)
+	{
+		appendInteger(m_record, static_cast<unsigned long long>(keyframe.offset), 8);
+		appendInteger(m_record, static_cast<unsigned long long>(keyframe.frame), 4);
+		appendInteger(m_record, keyframe.width, 2);
+		appendInteger(m_record, keyframe.height, 2);
+	}
+
+	appendInteger(m_record, static_cast<unsigned long long>(indexOffset), 8);
+	appendInteger(m_record, m_keyframes.size(), 4);
+	appendInteger(m_record, static_cast<unsigned long long>(m_frameCount), 4);
+	m_record.insert(m_record.end(), INDEX_MAGIC, INDEX_MAGIC + 4);
+
+	size_t written = fwrite(m_record.data(), 1, m_record.size(), m_file);
+	m_bytesWritten += static_cast<long long>(written);
+
+	bool success = !m_writeFailed && written == m_record.size();
+	success = fclose(m_file) == 0 && success;
+	m_file = nullptr;
+
+	return success;
+}
+
+long FrameStreamWriter::getFrameCount() const
+{
+	return m_frameCount;
+}
+
+long long FrameStreamWriter::getBytesWritten() const
+{
+	return m_bytesWritten;
+}
+
+FrameStreamReader::FrameStreamReader()
+	: m_file(nullptr)
+	, m_version(0)
+	, m_headerWidth(0)
+	, m_headerHeight(0)
+	, m_width(0)
+	, m_height(0)
+	, m_keyframeInterval(0)
+	, m_wordCount(0)
+	, m_dataStart(0)
+	, m_frameCount(0)
+	, m_indexRebuilt(false)
+	, m_currentFrameNumber(-1)
+{
+}
+
+FrameStreamReader::~FrameStreamReader()
+{
+	close();
+}
+
+bool FrameStreamReader::open(const char *path)
+{
+	close();
+
+	m_file = fopen(path, "rb");
+
+	if (m_file == nullptr)
+		return false;
+
+	if (!readHeader())
+	{
+		close();
+		return false;
+	}
+
+	// Recordings that were not closed properly have no index, the keyframes are found by decoding the whole file once
+	m_indexRebuilt = false;
+	if (!readIndex())
+	{
+		if (!rebuildIndex())
+		{
+			close();
+			return false;
+		}
+
+		m_indexRebuilt = true;
+	}
+
+	setDisplaySize(m_headerWidth, m_headerHeight);
+	m_currentFrameNumber = -1;
+
+	return true;
+}
+
+void FrameStreamReader::close()
+{
+	if (m_file != nullptr)
+		fclose(m_file);
+
+	m_file = nullptr;
+	m_keyframes.clear();
+	m_frameCount = 0;
+}
+
+bool FrameStreamReader::readFrame(long frame, qword *graphicsMemory)
+{
+	if (m_file == nullptr || frame < 0 || frame >= m_frameCount)
+		return false;
+
+	// Seek to the closest keyframe unless the requested frame is ahead of the current one and no keyframe lies in between
+	auto keyframe = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), frame,
+		[](long value, const FrameStreamKeyframe & candidate) { return value < candidate.frame; });
+
+	if (keyframe == m_keyframes.begin())
+		return false;
+
+	--keyframe;
+
+	if (frame < m_currentFrameNumber || m_currentFrameNumber < keyframe->frame)
+	{
+		if (!seek(m_file, keyframe->offset))
+			return false;
+
+		setDisplaySize(keyframe->width, keyframe->height);
+		m_currentFrameNumber = keyframe->frame - 1;
+	}
+
+	bool isKeyframe = false;
+	while (m_currentFrameNumber < frame)
+	{
+		if (!readRecord(isKeyframe))
+		{
+			m_currentFrameNumber = -1;
+			return false;
+		}
+
+		++m_currentFrameNumber;
+	}
+
+	memcpy(graphicsMemory, m_currentFrame.data(), m_wordCount * sizeof(qword));
+
+	return true;
+}
+
+long FrameStreamReader::getFrameCount() const
+{
+	return m_frameCount;
+}
+
+int FrameStreamReader::getKeyframeInterval() const
+{
+	return m_keyframeInterval;
+}
+
+int FrameStreamReader::getWidth() const
+{
+	return m_width;
+}
+
+int FrameStreamReader::getHeight() const
+{
+	return m_height;
+}
+
+int FrameStreamReader::getMaxWordCount() const
+{
+	int maxWordCount = m_headerWidth / 64 * m_headerHeight;
+	for (const FrameStreamKeyframe & keyframe : m_keyframes)
+		maxWordCount = std::max(maxWordCount, keyframe.width / 64 * keyframe.height);
+
+	return maxWordCount;
+}
+
+const std::vector<FrameStreamKeyframe> & FrameStreamReader::getKeyframes() const
+{
+	return m_keyframes;
+}
+
+bool FrameStreamReader::wasIndexRebuilt() const
+{
+	return m_indexRebuilt;
+}
+
+bool FrameStreamReader::readHeader()
+{
+	char magic[4];
+	unsigned long long version = 0;
+	unsigned long long width = 0;
+	unsigned long long height = 0;
+	unsigned long long keyframeInterval = 0;
+
+	if (fread(magic, 1, 4, m_file) != 4 || memcmp(magic, STREAM_MAGIC, 4) != 0)
+		return false;
+
+	if (!readInteger(m_file, version, 4) || !readInteger(m_file, width, 2) || !readInteger(m_file, height, 2) ||
+		!readInteger(m_file, keyframeInterval, 4))
+		return false;
+
+	if (version < 1 || version > STREAM_VERSION || !isValidDisplaySize(width, height) || keyframeInterval == 0)
+		return false;
+
+	m_version = static_cast<unsigned int>(version);
+	m_headerWidth = static_cast<int>(width);
+	m_headerHeight = static_cast<int>(height);
+	m_keyframeInterval = static_cast<int>(keyframeInterval);
+	m_dataStart = tell(m_file);
+
+	setDisplaySize(m_headerWidth, m_headerHeight);
+
+	return true;
+}
+
+bool FrameStreamReader::readIndex()
+{
+	const int FOOTER_SIZE = 8 + 4 + 4 + 4;
+
+	unsigned long long indexOffset = 0;
+	unsigned long long keyframeCount = 0;
+	unsigned long long frameCount = 0;
+	char magic[4];
+
+	if (!seek(m_file, -FOOTER_SIZE, SEEK_END) || !readInteger(m_file, indexOffset, 8) || !readInteger(m_file, keyframeCount, 4) ||
+		!readInteger(m_file, frameCount, 4) || fread(magic, 1, 4, m_file) != 4 || memcmp(magic, INDEX_MAGIC, 4) != 0)
+		return false;
+
+	if (!seek(m_file, static_cast<long long>(indexOffset)))
+		return false;
+
+	m_keyframes.clear();
+	for (unsigned long long i = 0; i < keyframeCount; ++i)
+	{
+		unsigned long long offset = 0;
+		if (!readInteger(m_file, offset, 8))
+			return false;
+
+		// Version 1 streams never change the display size and store a keyframe at every interval
+		unsigned long long frame = i * m_keyframeInterval;
+		unsigned long long width = m_headerWidth;
+		unsigned long long height = m_headerHeight;
+
+		if (m_version >= 2 && (!readInteger(m_file, frame, 4) || !readInteger(m_file, width, 2) || !readInteger(m_file, height, 2)))
+			return false;
+
+		if (!isValidDisplaySize(width, height))
+			return false;
+
+		m_keyframes.push_back({ static_cast<long>(frame), static_cast<long long>(offset), static_cast<int>(width), static_cast<int>(height) });
+	}
+
+	m_frameCount = static_cast<long>(frameCount);
+
+	return true;
+}
+
+bool FrameStreamReader::rebuildIndex()
+{
+	if (!seek(m_file, m_dataStart))
+		return false;
+
+	m_keyframes.clear();
+	m_frameCount = 0;
+
+	bool isKeyframe = false;
+
+	// Decoding stops at the first incomplete record, which is where the recording was interrupted
+	long long offset = tell(m_file);
+	while (readRecord(isKeyframe))
+	{
+		if (isKeyframe)
+			m_keyframes.push_back({ m_frameCount, offset, m_width, m_height });
+
+		++m_frameCount;
+		offset = tell(m_file);
+	}
+
+	return true;
+}
+
+bool FrameStreamReader::readRecord(bool & isKeyframe)
+{
+	std::vector<qword> & frame = m_currentFrame;
+
+	int type = fgetc(m_file);
+	isKeyframe = type == RECORD_KEYFRAME;
+
+	switch (type)
+	{
+	case RECORD_MODE:
+	{
+		unsigned long long width = 0;
+		unsigned long long height = 0;
+
+		if (!readInteger(m_file, width, 2) || !readInteger(m_file, height, 2) || !isValidDisplaySize(width, height))
+			return false;
+
+		setDisplaySize(static_cast<int>(width), static_cast<int>(height));
+
+		// The keyframe that follows is part of the same frame
+		return fgetc(m_file) == RECORD_KEYFRAME && seek(m_file, -1, SEEK_CUR) && readRecord(isKeyframe);
+	}
+
+	case RECORD_KEYFRAME:
+	{
+		byte bytes[8];
+		for (int i = 0; i < m_wordCount; ++i)
+		{
+			if (fread(bytes, 1, 8, m_file) != 8)
+				return false;
+
+			qword value = 0;
+			for (int j = 0; j < 8; ++j)
+				value = (value << 8) | bytes[j];
+
+			frame[i] = value;
+		}
+
+		return true;
+	}
+
+	case RECORD_DELTA:
+	{
+		byte bitmap[64];
+		const size_t bitmapSize = (m_wordCount + 7) / 8;
+
+		if (bitmapSize > sizeof(bitmap) || fread(bitmap, 1, bitmapSize, m_file) != bitmapSize)
+			return false;
+
+		for (int i = 0; i < m_wordCount; ++i)
+		{
+			if ((bitmap[i / 8] & (1 << (i % 8))) == 0)
+				continue;
+
+			int mask = fgetc(m_file);
+			if (mask == EOF)
+				return false;
+
+			byte bytes[8];
+			int byteCount = 0;
+			for (int j = 0; j < 8; ++j)
+				byteCount += (mask >> j) & 1;
+
+			if (fread(bytes, 1, byteCount, m_file) != static_cast<size_t>(byteCount))
+				return false;
+
+			qword difference = 0;
+			int next = 0;
+			for (int j = 0; j < 8; ++j)
+			{
+				if ((mask >> j) & 1)
+					difference |= static_cast<qword>(bytes[next++]) << (56 - 8 * j);
+			}
+
+			frame[i] ^= difference;
+		}
+
+		return true;
+	}
+
+	case RECORD_REPEAT:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void FrameStreamReader::setDisplaySize(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	m_wordCount = width / 64 * height;
+	m_currentFrame.assign(m_wordCount, 0);
+}
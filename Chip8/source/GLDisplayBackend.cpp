@@ -0,0 +1,68 @@
+#include "Chip8/Emulator/GLDisplayBackend.hpp"
+#include "Chip8/Emulator/Renderer.hpp"
+#include "Chip8/Emulator/Window.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+GLDisplayBackend::GLDisplayBackend(const Window & window, Renderer & renderer)
+	: m_window(window)
+	, m_renderer(renderer)
+{
+}
+
+GLDisplayBackend::~GLDisplayBackend()
+{
+}
+
+void GLDisplayBackend::setDisplaySize(int width, int height, int planeCount)
+{
+	m_renderer.setDisplaySize(width, height, planeCount);
+}
+
+size_t GLDisplayBackend::updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion)
+{
+	return m_renderer.updatePixels(graphicsMemory, dirtyRegion);
+}
+
+void GLDisplayBackend::present()
+{
+	// Render the new frame
+	m_renderer.draw();
+
+	// Swap framebuffers
+	m_window.display();
+}
+
+void GLDisplayBackend::pollEvents()
+{
+	m_window.pollKeyboard();
+}
+
+bool GLDisplayBackend::shouldClose() const
+{
+	return m_window.shouldClose();
+}
+
+const byte *GLDisplayBackend::getHexKeyPad() const
+{
+	return Window::m_hexKeyPad;
+}
+
+int GLDisplayBackend::getRefreshRate() const
+{
+	return m_window.getRefreshRate();
+}
+
+void GLDisplayBackend::setVerticalSync(bool enabled)
+{
+	m_window.setVerticalSync(enabled);
+}
+
+void GLDisplayBackend::setPalette(const float *onColor, const float *offColor)
+{
+	m_renderer.setPalette(onColor, offColor);
+}
+
+const char *GLDisplayBackend::getName() const
+{
+	return "OpenGL";
+}
@@ -0,0 +1,227 @@
+#include "Chip8/Emulator/HeadlessRunner.hpp"
+#include "Chip8/Emulator/Processor.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/BinaryBuffer.hpp"
+#include "Chip8/Utility/Hash.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+HeadlessRunner::HeadlessRunner()
+	: m_nextInputEvent(0)
+	, m_randomInput(false)
+	, m_seed(0)
+	, m_cyclesPerFrame(10)
+	, m_frameCount(0)
+	, m_instructionCount(0)
+{
+	m_processor.initialize();
+	m_processor.traceFlag = 0;
+	setSeed(0);
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+}
+
+bool HeadlessRunner::loadGame(const char *path)
+{
+	return m_processor.loadGame(path);
+}
+
+bool HeadlessRunner::loadGame(const byte *rom, size_t size)
+{
+	return m_processor.loadGame(rom, size);
+}
+
+Chip8RomAnalysis HeadlessRunner::analyzeGame(const Chip8RomDatabase *database) const
+{
+	// Programs are loaded at 0x200
+	return Chip8RomAnalyzer::analyze(m_processor.getMemoryStart() + 0x200, m_processor.getApplicationSize(), database);
+}
+
+bool HeadlessRunner::loadInputScript(const char *path)
+{
+	FILE *filePtr = fopen(path, "r");
+
+	if (filePtr == nullptr)
+		return false;
+
+	m_inputScript.clear();
+	m_nextInputEvent = 0;
+
+	long frame = 0;
+	unsigned int key = 0;
+	unsigned int state = 0;
+	while (fscanf(filePtr, "%li %x %u", &frame, &key, &state) == 3)
+		m_inputScript.push_back({ frame, static_cast<byte>(key & 0xF), static_cast<byte>(state != 0 ? 1 : 0) });
+
+	fclose(filePtr);
+
+	// Events are applied in order of their frame number
+	std::stable_sort(m_inputScript.begin(), m_inputScript.end(),
+		[](const InputEvent & a, const InputEvent & b) { return a.frame < b.frame; });
+
+	return true;
+}
+
+void HeadlessRunner::setRandomInput(bool enabled)
+{
+	m_randomInput = enabled;
+}
+
+void HeadlessRunner::setSeed(unsigned int seed)
+{
+	m_seed = seed;
+	m_inputEngine.seed(seed);
+	m_processor.setRandomSeed(seed);
+}
+
+unsigned int HeadlessRunner::getSeed() const
+{
+	return m_seed;
+}
+
+void HeadlessRunner::setCyclesPerFrame(int cyclesPerFrame)
+{
+	m_cyclesPerFrame = cyclesPerFrame > 0 ? cyclesPerFrame : 1;
+}
+
+void HeadlessRunner::setQuirkProfile(QuirkProfile profile)
+{
+	m_processor.setQuirkProfile(profile);
+}
+
+void HeadlessRunner::runFrame()
+{
+	applyInput();
+
+	m_processor.runCycles(m_cyclesPerFrame);
+
+	// Nobody presents the frame, so the draw flag is simply acknowledged
+	m_processor.drawFlag = 0;
+	m_processor.updateTimers();
+
+	m_instructionCount += m_cyclesPerFrame;
+	++m_frameCount;
+}
+
+bool HeadlessRunner::runUntilKeyPoll(long maxFrames)
+{
+	std::string frameStart;
+
+	while (m_frameCount < maxFrames)
+	{
+		saveState(frameStart);
+		long long keyPollCount = m_processor.getKeyPollCount();
+
+		runFrame();
+
+		if (m_processor.getKeyPollCount() != keyPollCount)
+			return loadState(frameStart);
+	}
+
+	return false;
+}
+
+void HeadlessRunner::saveState(std::string & state) const
+{
+	std::string processorState;
+	m_processor.saveState(processorState);
+
+	state.clear();
+	appendBinary(state, m_frameCount);
+	appendBinary(state, m_instructionCount);
+	state += processorState;
+}
+
+bool HeadlessRunner::loadState(const std::string & state)
+{
+	BinaryReader reader(state);
+
+	long frameCount;
+	long long instructionCount;
+	if (!reader.read(frameCount) || !reader.read(instructionCount) ||
+		!m_processor.loadState(state.substr(sizeof(frameCount) + sizeof(instructionCount))))
+		return false;
+
+	m_frameCount = frameCount;
+	m_instructionCount = instructionCount;
+
+	replayInputBefore(frameCount);
+	return true;
+}
+
+long HeadlessRunner::getFrameCount() const
+{
+	return m_frameCount;
+}
+
+long long HeadlessRunner::getInstructionCount() const
+{
+	return m_instructionCount;
+}
+
+int HeadlessRunner::getCyclesPerFrame() const
+{
+	return m_cyclesPerFrame;
+}
+
+unsigned long long HeadlessRunner::hashState() const
+{
+	unsigned long long hash = hashBytes(m_processor.getGraphicsMemory(), m_processor.getGraphicsMemorySize());
+	return hashBytes(m_processor.getMemoryStart(), m_processor.MEMORY_SIZE_BYTES, hash);
+}
+
+Chip8Processor & HeadlessRunner::getProcessor()
+{
+	return m_processor;
+}
+
+const Chip8Processor & HeadlessRunner::getProcessor() const
+{
+	return m_processor;
+}
+
+void HeadlessRunner::replayInputBefore(long frame)
+{
+	m_inputEngine.seed(m_seed);
+	m_nextInputEvent = 0;
+
+	long frameCount = m_frameCount;
+	for (m_frameCount = 0; m_frameCount < frame; ++m_frameCount)
+	{
+		// Only frames that change the input matter
+		if (!m_inputScript.empty() || (m_randomInput && (m_frameCount & 7) == 0))
+			applyInput();
+	}
+
+	m_frameCount = frameCount;
+}
+
+void HeadlessRunner::applyInput()
+{
+	// Scripted input takes priority over random input
+	if (!m_inputScript.empty())
+	{
+		while (m_nextInputEvent < m_inputScript.size() && m_inputScript[m_nextInputEvent].frame <= m_frameCount)
+		{
+			const InputEvent & event = m_inputScript[m_nextInputEvent++];
+			m_processor.setKey(event.key, event.state);
+		}
+
+		return;
+	}
+
+	if (!m_randomInput)
+		return;
+
+	// Every eight frames a random key changes state, which keeps games that wait for input moving
+	if ((m_frameCount & 7) == 0)
+	{
+		std::uniform_int_distribution<int> keyDistribution(0, 15);
+		std::uniform_int_distribution<int> stateDistribution(0, 1);
+
+		m_processor.setKey(static_cast<byte>(keyDistribution(m_inputEngine)), static_cast<byte>(stateDistribution(m_inputEngine)));
+	}
+}
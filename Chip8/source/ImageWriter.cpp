@@ -0,0 +1,202 @@
+#include "Chip8/Utility/ImageWriter.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+// Pixel (x, y) of a bit-packed display with rowWords words per row
+static inline bool isPixelSet(const qword *rows, int rowWords, int x, int y)
+{
+	return ((rows[y * rowWords + x / 64] >> (63 - x % 64)) & 1) != 0;
+}
+
+static const unsigned int *getCrcTable()
+{
+	static unsigned int table[256];
+
+	// Function local statics are initialized exactly once, even when several encoder threads get here at the same time
+	static bool tableReady = []()
+	{
+		for (unsigned int i = 0; i < 256; ++i)
+		{
+			unsigned int value = i;
+			for (int bit = 0; bit < 8; ++bit)
+				value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+
+			table[i] = value;
+		}
+
+		return true;
+	}();
+
+	(void)tableReady;
+	return table;
+}
+
+static unsigned int crc32(const byte *data, size_t size)
+{
+	const unsigned int *table = getCrcTable();
+
+	unsigned int crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; ++i)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+static void appendBigEndian(std::vector<byte> & output, unsigned int value)
+{
+	output.push_back(static_cast<byte>(value >> 24));
+	output.push_back(static_cast<byte>(value >> 16));
+	output.push_back(static_cast<byte>(value >> 8));
+	output.push_back(static_cast<byte>(value));
+}
+
+static void appendChunk(std::vector<byte> & output, const char *type, const std::vector<byte> & data)
+{
+	appendBigEndian(output, static_cast<unsigned int>(data.size()));
+
+	size_t typeOffset = output.size();
+	output.insert(output.end(), type, type + 4);
+	output.insert(output.end(), data.begin(), data.end());
+
+	// The CRC covers the chunk type and the data
+	appendBigEndian(output, crc32(&output[typeOffset], 4 + data.size()));
+}
+
+void encodePng(const qword *rows, int displayWidth, int displayHeight, int scale, unsigned int onColor, unsigned int offColor, std::vector<byte> & output)
+{
+	const unsigned int width = displayWidth * scale;
+	const unsigned int height = displayHeight * scale;
+	const int rowWords = displayWidth / 64;
+	const size_t rowBytes = (width + 7) / 8;
+
+	const byte SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	output.assign(SIGNATURE, SIGNATURE + 8);
+
+	// Palette image with a bit depth of 1, index 0 is "off" and index 1 is "on"
+	std::vector<byte> header;
+	appendBigEndian(header, width);
+	appendBigEndian(header, height);
+	header.push_back(1);	// Bit depth
+	header.push_back(3);	// Color type (palette)
+	header.push_back(0);	// Compression method
+	header.push_back(0);	// Filter method
+	header.push_back(0);	// No interlacing
+	appendChunk(output, "IHDR", header);
+
+	std::vector<byte> palette =
+	{
+		static_cast<byte>(offColor >> 16), static_cast<byte>(offColor >> 8), static_cast<byte>(offColor),
+		static_cast<byte>(onColor >> 16), static_cast<byte>(onColor >> 8), static_cast<byte>(onColor)
+	};
+	appendChunk(output, "PLTE", palette);
+
+	// Filtered scanlines: a filter type byte followed by the packed pixels, PNG also puts the leftmost pixel in the
+	// most significant bit
+	std::vector<byte> scanlines((1 + rowBytes) * height, 0);
+	for (int y = 0; y < displayHeight; ++y)
+	{
+		byte *line = &scanlines[(1 + rowBytes) * y * scale];
+
+		for (int x = 0; x < displayWidth; ++x)
+		{
+			if (!isPixelSet(rows, rowWords, x, y))
+				continue;
+
+			for (int i = 0; i < scale; ++i)
+			{
+				int outputX = x * scale + i;
+				line[1 + outputX / 8] |= static_cast<byte>(0x80 >> (outputX % 8));
+			}
+		}
+
+		for (int i = 1; i < scale; ++i)
+			memcpy(line + (1 + rowBytes) * i, line, 1 + rowBytes);
+	}
+
+	// zlib stream made of uncompressed deflate blocks (at most 65535 bytes each)
+	std::vector<byte> compressed = { 0x78, 0x01 };
+
+	unsigned int adlerA = 1;
+	unsigned int adlerB = 0;
+	for (byte value : scanlines)
+	{
+		adlerA = (adlerA + value) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+
+	size_t offset = 0;
+	do
+	{
+		size_t blockSize = scanlines.size() - offset < 65535 ? scanlines.size() - offset : 65535;
+		bool finalBlock = offset + blockSize == scanlines.size();
+
+		compressed.push_back(finalBlock ? 1 : 0);
+		compressed.push_back(static_cast<byte>(blockSize));
+		compressed.push_back(static_cast<byte>(blockSize >> 8));
+		compressed.push_back(static_cast<byte>(~blockSize));
+		compressed.push_back(static_cast<byte>(~blockSize >> 8));
+		compressed.insert(compressed.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+		offset += blockSize;
+	} while (offset < scanlines.size());
+
+	appendBigEndian(compressed, (adlerB << 16) | adlerA);
+	appendChunk(output, "IDAT", compressed);
+
+	appendChunk(output, "IEND", std::vector<byte>());
+}
+
+void encodeY4mHeader(int displayWidth, int displayHeight, int scale, std::vector<byte> & output)
+{
+	char header[128];
+	int length = snprintf(header, sizeof(header), "YUV4MPEG2 W%i H%i F60:1 Ip A1:1 C444\n", displayWidth * scale, displayHeight * scale);
+
+	output.assign(header, header + length);
+}
+
+// BT.601 limited range
+static void toYCbCr(unsigned int color, byte * yCbCr)
+{
+	float r = ((color >> 16) & 0xFF) / 255.0f;
+	float g = ((color >> 8) & 0xFF) / 255.0f;
+	float b = (color & 0xFF) / 255.0f;
+
+	yCbCr[0] = static_cast<byte>(16.0f + 65.481f * r + 128.553f * g + 24.966f * b + 0.5f);
+	yCbCr[1] = static_cast<byte>(128.0f - 37.797f * r - 74.203f * g + 112.0f * b + 0.5f);
+	yCbCr[2] = static_cast<byte>(128.0f + 112.0f * r - 93.786f * g - 18.214f * b + 0.5f);
+}
+
+void encodeY4mFrame(const qword *rows, int displayWidth, int displayHeight, int scale, unsigned int onColor, unsigned int offColor, std::vector<byte> & output)
+{
+	const size_t width = displayWidth * scale;
+	const size_t height = displayHeight * scale;
+	const int rowWords = displayWidth / 64;
+	const size_t planeSize = width * height;
+
+	byte on[3];
+	byte off[3];
+	toYCbCr(onColor, on);
+	toYCbCr(offColor, off);
+
+	const char FRAME_HEADER[] = "FRAME\n";
+	output.assign(FRAME_HEADER, FRAME_HEADER + 6);
+	output.resize(6 + 3 * planeSize);
+
+	for (int plane = 0; plane < 3; ++plane)
+	{
+		byte *planeStart = &output[6 + plane * planeSize];
+
+		for (int y = 0; y < displayHeight; ++y)
+		{
+			byte *line = planeStart + y * scale * width;
+
+			for (int x = 0; x < displayWidth; ++x)
+				memset(line + x * scale, isPixelSet(rows, rowWords, x, y) ? on[plane] : off[plane], scale);
+
+			for (int i = 1; i < scale; ++i)
+				memcpy(line + i * width, line, width);
+		}
+	}
+}
@@ -1,14 +1,99 @@
+#include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 #include "Chip8/Emulator/Processor.hpp"
 #include "Chip8/Emulator/Window.hpp"
 #include "Chip8/Emulator/Renderer.hpp"
+#include "Chip8/Emulator/GLDisplayBackend.hpp"
+#include "Chip8/Emulator/Presenter.hpp"
+#include "Chip8/Emulator/Quirks.hpp"
+#include "Chip8/Emulator/TerminalDisplayBackend.hpp"
+#include "Chip8/Utility/Coverage.hpp"
+#include "Chip8/Utility/Disassembler.hpp"
+#include "Chip8/Utility/FrameStream.hpp"
+#include "Chip8/Utility/RomAnalyzer.hpp"
+
+#ifdef CHIP8_HAS_X11
+#include "Chip8/Emulator/X11DisplayBackend.hpp"
+#endif
 
 int main(int argc, char const *argv[])
-{	
+{
+	// Startup is measured from the launch time passed by the caller (steady clock nanoseconds) or from here
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
 	const char *GAME_PATH = "../roms/games/Breakout [Carmelo Cortez, 1979].ch8";
 
+	// Usage: Chip8 [ROM path] [--coverage] [--present immediate|refresh|frame] [--palette RRGGBB RRGGBB]
+	//                   [--upload sync|stream] [--shader-cache path|none] [--launch-time ns] [--exit-after-first-frame]
+	//                   [--presenter auto|gl|x11|braille|halfblocks] [--record stream.c8fs]
+	//                   [--quirks auto|vip|chip48|schip|xochip] [--rom-database path] [--cycles-per-frame N]
+	bool collectCoverage = false;
+	const char *presenterName = "auto";
+	const char *recordPath = nullptr;
+	bool exitAfterFirstFrame = false;
+	const char *shaderCachePath = "Chip8.shadercache";
+	bool streamUploads = false;
+	unsigned int onColor = 0xFFFFFF;
+	unsigned int offColor = 0x000000;
+	PresentPolicy presentPolicy = PresentPolicy::HOST_REFRESH;
+	QuirkProfile quirkProfile = QuirkProfile::SUPER_CHIP;
+	bool detectQuirks = true;
+	const char *romDatabasePath = "../roms/RomDatabase.tsv";
+	int cyclesPerFrame = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--coverage") == 0)
+			collectCoverage = true;
+		else if (strcmp(argv[i], "--palette") == 0 && i + 2 < argc)
+		{
+			onColor = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 16));
+			offColor = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 16));
+		}
+		else if (strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc)
+		{
+			++i;
+			shaderCachePath = strcmp(argv[i], "none") == 0 ? nullptr : argv[i];
+		}
+		else if (strcmp(argv[i], "--launch-time") == 0 && i + 1 < argc)
+			startTime = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(strtoll(argv[++i], nullptr, 10)));
+		else if (strcmp(argv[i], "--exit-after-first-frame") == 0)
+			exitAfterFirstFrame = true;
+		else if (strcmp(argv[i], "--presenter") == 0 && i + 1 < argc)
+			presenterName = argv[++i];
+		else if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc)
+		{
+			++i;
+			detectQuirks = strcmp(argv[i], "auto") == 0;
+			if (!detectQuirks && !parseQuirkProfile(argv[i], quirkProfile))
+				printf("Unknown quirk profile %s, using %s.\n", argv[i], getQuirkProfileName(quirkProfile));
+		}
+		else if (strcmp(argv[i], "--rom-database") == 0 && i + 1 < argc)
+			romDatabasePath = argv[++i];
+		else if (strcmp(argv[i], "--cycles-per-frame") == 0 && i + 1 < argc)
+			cyclesPerFrame = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+			recordPath = argv[++i];
+		else if (strcmp(argv[i], "--upload") == 0 && i + 1 < argc)
+			streamUploads = strcmp(argv[++i], "stream") == 0;
+		else if (strcmp(argv[i], "--present") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(argv[i], "immediate") == 0)
+				presentPolicy = PresentPolicy::IMMEDIATE;
+			else if (strcmp(argv[i], "frame") == 0)
+				presentPolicy = PresentPolicy::EMULATED_FRAME;
+			else
+				presentPolicy = PresentPolicy::HOST_REFRESH;
+		}
+		else
+			GAME_PATH = argv[i];
+	}
+
 	Chip8Processor chip8Processor;
 	chip8Processor.initialize();
 
@@ -19,49 +104,233 @@ int main(int argc, char const *argv[])
 		std::cin.get();
 		return -1;
 	}
-	
+
+	// The ROM database knows the quirks and speed of the ROMs that come with the emulator, others are analyzed
+	if (detectQuirks)
+	{
+		Chip8RomDatabase romDatabase;
+		romDatabase.load(romDatabasePath);
+
+		Chip8RomAnalysis analysis = Chip8RomAnalyzer::analyze(chip8Processor.getMemoryStart() + 0x200, chip8Processor.getApplicationSize(), &romDatabase);
+		quirkProfile = analysis.quirkProfile;
+
+		if (cyclesPerFrame == 0)
+			cyclesPerFrame = analysis.cyclesPerFrame;
+
+		printf("Running with the %s quirks at %i cycles per frame (%s).\n", getQuirkProfileName(quirkProfile), cyclesPerFrame,
+			analysis.fromDatabase ? "ROM database" : "heuristics");
+	}
+
+	chip8Processor.setQuirkProfile(quirkProfile);
+
+	// Without a speed the Chip8 runs at a clock speed of 500Hz
+	const float CYCLE_DURATION = cyclesPerFrame > 0 ? 1.0f / (60.0f * cyclesPerFrame) : 0.002f;
+
+	// Coverage of this run is merged with the coverage of all previous runs of the same ROM
+	Chip8Coverage coverage;
+	std::string coveragePath = std::string(GAME_PATH) + ".cov";
+
+	if (collectCoverage)
+	{
+		coverage.mergeFromFile(coveragePath.c_str());
+		chip8Processor.setCoverage(&coverage);
+	}
+
+	// The display is recorded once per emulated frame, for replay in Chip8Stream. The file is created at the end of the
+	// first frame, when a hires ROM has switched the display mode, later mode switches start a keyframe of the new size.
+	FrameStreamWriter frameStream;
+	bool recordingStarted = false;
+
+	const char *WINDOW_TITLE = "Chip8 emulation - Tahar Meijs";
+
 	Window window;
 	Renderer renderer;
+	GLDisplayBackend glBackend(window, renderer);
+	TerminalDisplayBackend terminalBackend;
+	DisplayBackend *backend = nullptr;
 
-	if (!window.create("Chip8 emulation - Tahar Meijs", 640, 320, 3, 3))
-		return -1;
+	bool terminalPresenter = strcmp(presenterName, "braille") == 0 || strcmp(presenterName, "halfblocks") == 0;
+	if (terminalPresenter)
+	{
+		// The OpCode trace would scroll the display out of the terminal
+		chip8Processor.traceFlag = 0;
+
+		terminalBackend.create(strcmp(presenterName, "braille") == 0 ? TerminalCells::BRAILLE : TerminalCells::HALF_BLOCKS);
+		backend = &terminalBackend;
+	}
 
-	if (!renderer.initialize(window))
+	// Automatic selection prefers OpenGL and falls back to the software backend on machines without a usable driver
+	if (backend == nullptr && strcmp(presenterName, "x11") != 0)
+	{
+		if (window.create(WINDOW_TITLE, 640, 320, 3, 3) && renderer.initialize(window, shaderCachePath))
+			backend = &glBackend;
+		else if (strcmp(presenterName, "gl") == 0)
+			return -1;
+		else
+			printf("OpenGL is not available, falling back to the software presenter.\n");
+	}
+
+#ifdef CHIP8_HAS_X11
+	X11DisplayBackend x11Backend;
+
+	if (backend == nullptr && x11Backend.create(WINDOW_TITLE, 640, 320))
+		backend = &x11Backend;
+#endif
+
+	if (backend == nullptr)
+	{
+		printf("No display backend is available.\n");
 		return -1;
+	}
 
-	printf("ROM successfully loaded.\n");
+	// The terminal presenter owns the screen from here on
+	if (!terminalPresenter)
+		printf("ROM successfully loaded, presenting through %s.\n", backend->getName());
+
+	const float ON_COLOR[3] = { ((onColor >> 16) & 0xFF) / 255.0f, ((onColor >> 8) & 0xFF) / 255.0f, (onColor & 0xFF) / 255.0f };
+	const float OFF_COLOR[3] = { ((offColor >> 16) & 0xFF) / 255.0f, ((offColor >> 8) & 0xFF) / 255.0f, (offColor & 0xFF) / 255.0f };
+	backend->setPalette(ON_COLOR, OFF_COLOR);
+
+	if (streamUploads && backend == &glBackend)
+	{
+		if (renderer.setUploadPath(UploadPath::STREAMING))
+			printf("Streaming texture uploads through %s pixel buffers.\n", renderer.isPersistentlyMapped() ? "persistently mapped" : "orphaned");
+		else
+			printf("Pixel buffers are not available, uploading synchronously.\n");
+	}
+
+	// Presents are aligned with the monitor refresh. A swap can block for up to one refresh interval, the loop below
+	// catches up by running every cycle and timer update that came due in the meantime.
+	if (presentPolicy == PresentPolicy::HOST_REFRESH)
+		backend->setVerticalSync(true);
+
+	Presenter presenter(*backend, presentPolicy);
 
 	std::chrono::high_resolution_clock::time_point then = std::chrono::high_resolution_clock::now();
+	std::chrono::high_resolution_clock::time_point lastFrame = then;
+	const std::chrono::high_resolution_clock::duration FRAME_DURATION =
+		std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(1.0 / 60.0));
+
+	// After a longer stall, e.g. while the window is dragged, the emulation skips ahead instead of racing to catch up
+	const int MAX_CATCH_UP_FRAMES = 15;
+	const int MAX_CATCH_UP_CYCLES = static_cast<int>(MAX_CATCH_UP_FRAMES / (60.0 * CYCLE_DURATION));
+
+	// Measured when --exit-after-first-frame ends the loop, printed once the terminal is restored
+	double startupTime = -1.0;
 
 	// Main application loop
-	while (chip8Processor.quitFlag == 0)
+	while (chip8Processor.quitFlag == 0 && !backend->shouldClose())
 	{
 		std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
-		float duration = std::chrono::duration_cast<std::chrono::duration<float>>(now - then).count();
-		
-		// The Chip8 runs at a clock speed of 500Hz
-		if (duration < 0.002f)
+		double duration = std::chrono::duration<double>(now - then).count();
+
+		if (duration < CYCLE_DURATION)
 			continue;
 
-		// The Chip8 timers should update at 60Hz
-		if (duration >= 0.016f)
+		// The emulated clock advances by the cycles that were run, not to the current time, so no time is lost
+		int dueCycles = static_cast<int>(duration / CYCLE_DURATION);
+		if (dueCycles > MAX_CATCH_UP_CYCLES)
+		{
+			dueCycles = MAX_CATCH_UP_CYCLES;
+			then = now - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(dueCycles * CYCLE_DURATION));
+		}
+
+		// Presenting after every clear / draw instruction needs the presenter to see each cycle, the others stay due
+		if (presentPolicy == PresentPolicy::IMMEDIATE)
+			dueCycles = 1;
+
+		then += std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(dueCycles * CYCLE_DURATION));
+
+		if (now - lastFrame > MAX_CATCH_UP_FRAMES * FRAME_DURATION)
+			lastFrame = now - FRAME_DURATION;
+
+		// The Chip8 timers should update at 60Hz, which is also the length of an emulated frame
+		bool frameBoundary = false;
+		while (now - lastFrame >= FRAME_DURATION)
+		{
 			chip8Processor.updateTimers();
+			lastFrame += FRAME_DURATION;
+			frameBoundary = true;
+
+			if (recordPath != nullptr && !recordingStarted)
+			{
+				recordingStarted = frameStream.open(recordPath, chip8Processor.getDisplayWidth(), chip8Processor.getDisplayHeight());
+				if (!recordingStarted)
+				{
+					printf("Failed to create the recording %s.\n", recordPath);
+					recordPath = nullptr;
+				}
+			}
+
+			if (recordPath != nullptr)
+				frameStream.writeFrame(chip8Processor.getGraphicsMemory(), chip8Processor.getDisplayWidth(), chip8Processor.getDisplayHeight());
+		}
 
-		// Simulate a CPU cycle
-		chip8Processor.newCycle();
+		// Simulate the CPU cycles, a single call resolves the quirk profile once for all of them
+		chip8Processor.runCycles(dueCycles);
 
-		// Draw whenever a clear / display OpCode has been processed
+		// Clear / display OpCodes only mark the display as dirty, the presenter decides when to actually draw
 		if (chip8Processor.drawFlag == 1)
-			chip8Processor.updateDisplay(window, renderer);
+		{
+			presenter.markDirty();
+			chip8Processor.drawFlag = 0;
+		}
+
+		presenter.update(chip8Processor, frameBoundary);
+
+		if (exitAfterFirstFrame && presenter.getPresentedFrameCount() > 0)
+		{
+			startupTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+			break;
+		}
 
 		// Update the input
-		chip8Processor.updateKeys(window);
+		const byte *hexKeyPad = backend->getHexKeyPad();
+		for (byte key = 0; key < 16; ++key)
+			chip8Processor.setKey(key, hexKeyPad[key]);
+
+		backend->pollEvents();
+	}
+
+	// Restore the terminal before printing the statistics
+	terminalBackend.destroy();
+
+	if (startupTime >= 0.0)
+		printf("First frame presented after %.3f ms.\n", startupTime);
+
+	printf("Presented %li frames, skipped %li unchanged frames, uploaded %zu bytes (%.1f per frame).\n",
+		presenter.getPresentedFrameCount(), presenter.getSkippedFrameCount(), presenter.getTotalUploadBytes(),
+		presenter.getPresentedFrameCount() > 0 ? static_cast<double>(presenter.getTotalUploadBytes()) / presenter.getPresentedFrameCount() : 0.0);
+
+	if (recordingStarted)
+	{
+		long recordedFrames = frameStream.getFrameCount();
+		if (frameStream.close())
+			printf("Recorded %li frames to %s (%lli bytes).\n", recordedFrames, recordPath, frameStream.getBytesWritten());
+		else
+			printf("Failed to write the recording %s.\n", recordPath);
+	}
+
+	if (backend == &glBackend)
+	{
+		const UploadStatistics & uploadStatistics = renderer.getUploadStatistics();
+		printf("Texture uploads took %.2f us on average, %li waits on the GPU (%.2f ms in total).\n",
+			uploadStatistics.uploadCount > 0 ? uploadStatistics.cpuTime * 1e6 / uploadStatistics.uploadCount : 0.0,
+			uploadStatistics.fenceWaitCount, uploadStatistics.fenceWaitTime * 1e3);
+	}
+
+	if (collectCoverage)
+	{
+		Chip8Disassembler disassembler;
+		disassembler.disassemble(0x200, static_cast<word>(chip8Processor.getApplicationSize()), chip8Processor.getMemoryStart(), &coverage);
+		coverage.printReport(0x200, chip8Processor.getApplicationSize());
 
-		// Update the emulator global timer
-		then = now;
+		if (!coverage.saveToFile(coveragePath.c_str()))
+			printf("Failed to save the coverage file.\n");
 	}
 
-	window.quit();
+	if (backend == &glBackend)
+		window.quit();
 
     return 0;
 }
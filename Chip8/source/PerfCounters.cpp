@@ -0,0 +1,209 @@
+#include "Chip8/Benchmark/PerfCounters.hpp"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+PerfCounters::PerfCounters()
+	: m_groupLeader(-1)
+	, m_groupSize(0)
+	, m_timeEnabled(0)
+	, m_timeRunning(0)
+	, m_taskClockOverhead(0)
+{
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+		m_fileDescriptors[i] = -1;
+		m_values[i] = 0;
+		m_groupPositions[i] = -1;
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+	close();
+}
+
+#if defined(__linux__)
+static int openEvent(unsigned int type, unsigned long long config, int groupLeader, bool excludeKernel)
+{
+	perf_event_attr attributes;
+	memset(&attributes, 0, sizeof(attributes));
+
+	attributes.size = sizeof(attributes);
+	attributes.type = type;
+	attributes.config = config;
+	attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	// The leader starts disabled, the other counters of the group follow it
+	attributes.disabled = groupLeader < 0 ? 1 : 0;
+
+	attributes.exclude_kernel = excludeKernel ? 1 : 0;
+	attributes.exclude_hv = 1;
+
+	// Calling thread, any CPU
+	return static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, groupLeader, 0));
+}
+#endif
+
+void PerfCounters::openCounter(Counter counter, unsigned int type, unsigned long long config)
+{
+#if defined(__linux__)
+	// Hardware counters only count user space, so they also work with perf_event_paranoid set to 2. Context switches and
+	// page faults are handled by the kernel, software counters include it where the system allows that.
+	int fileDescriptor = openEvent(type, config, m_groupLeader, type != PERF_TYPE_SOFTWARE);
+
+	// A context switch never happens in user space, it would always read zero
+	if (fileDescriptor < 0 && type == PERF_TYPE_SOFTWARE && counter != CONTEXT_SWITCHES)
+		fileDescriptor = openEvent(type, config, m_groupLeader, true);
+
+	if (fileDescriptor < 0)
+		return;
+
+	if (m_groupLeader < 0)
+		m_groupLeader = fileDescriptor;
+
+	m_fileDescriptors[counter] = fileDescriptor;
+	m_groupPositions[counter] = m_groupSize++;
+#endif
+}
+
+bool PerfCounters::open()
+{
+	close();
+
+#if defined(__linux__)
+	openCounter(CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	openCounter(INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	openCounter(BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	openCounter(L1D_READ_MISSES, PERF_TYPE_HW_CACHE,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+
+	if (m_groupSize == 0)
+	{
+		openCounter(TASK_CLOCK, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+		openCounter(CONTEXT_SWITCHES, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+		openCounter(PAGE_FAULTS, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+	}
+
+	// The task clock runs from the moment the group is enabled until it is disabled, which includes a few hundred
+	// nanoseconds of kernel code. The fastest of a number of empty intervals is taken off every interval.
+	if (m_fileDescriptors[TASK_CLOCK] >= 0)
+	{
+		unsigned long long overhead = ~0ull;
+		for (int i = 0; i < 100; ++i)
+		{
+			start();
+			stop();
+			overhead = std::min(overhead, m_values[TASK_CLOCK]);
+		}
+
+		m_taskClockOverhead = overhead;
+	}
+#endif
+
+	return m_groupSize > 0;
+}
+
+void PerfCounters::close()
+{
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+#if defined(__linux__)
+		if (m_fileDescriptors[i] >= 0)
+			::close(m_fileDescriptors[i]);
+#endif
+
+		m_fileDescriptors[i] = -1;
+		m_groupPositions[i] = -1;
+	}
+
+	m_groupLeader = -1;
+	m_groupSize = 0;
+	m_timeEnabled = 0;
+	m_timeRunning = 0;
+	m_taskClockOverhead = 0;
+}
+
+bool PerfCounters::isAvailable(Counter counter) const
+{
+	return m_fileDescriptors[counter] >= 0;
+}
+
+const char *PerfCounters::getName(Counter counter)
+{
+	switch (counter)
+	{
+	case CYCLES:			return "cycles";
+	case INSTRUCTIONS:		return "instructions";
+	case BRANCH_MISSES:		return "branch_misses";
+	case L1D_READ_MISSES:	return "l1d_read_misses";
+	case TASK_CLOCK:		return "task_clock_ns";
+	case CONTEXT_SWITCHES:	return "context_switches";
+	case PAGE_FAULTS:		return "page_faults";
+	default:				return "unknown";
+	}
+}
+
+void PerfCounters::start()
+{
+#if defined(__linux__)
+	if (m_groupLeader < 0)
+		return;
+
+	ioctl(m_groupLeader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(m_groupLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void PerfCounters::stop()
+{
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+		m_values[i] = 0;
+
+#if defined(__linux__)
+	if (m_groupLeader < 0)
+		return;
+
+	ioctl(m_groupLeader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+	// Number of counters, time enabled, time running, then one value per counter
+	unsigned long long data[3 + COUNTER_COUNT] = {};
+	ssize_t size = static_cast<ssize_t>((3 + m_groupSize) * sizeof(unsigned long long));
+	if (read(m_groupLeader, data, size) != size || data[0] != static_cast<unsigned long long>(m_groupSize))
+		return;
+
+	// The values start at zero every interval, the times keep running, so the interval is the difference to the last one
+	unsigned long long timeEnabled = data[1] - m_timeEnabled;
+	unsigned long long timeRunning = data[2] - m_timeRunning;
+	m_timeEnabled = data[1];
+	m_timeRunning = data[2];
+
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+		if (m_groupPositions[i] < 0)
+			continue;
+
+		unsigned long long value = data[3 + m_groupPositions[i]];
+
+		// Scale the value up when the kernel had to multiplex the group with other events during the interval
+		if (timeRunning != 0 && timeRunning < timeEnabled)
+			value = static_cast<unsigned long long>(static_cast<double>(value) * timeEnabled / timeRunning);
+
+		m_values[i] = value;
+	}
+
+	m_values[TASK_CLOCK] -= std::min(m_values[TASK_CLOCK], m_taskClockOverhead);
+#endif
+}
+
+unsigned long long PerfCounters::getValue(Counter counter) const
+{
+	return m_values[counter];
+}
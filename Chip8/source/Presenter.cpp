@@ -0,0 +1,119 @@
+#include "Chip8/Emulator/Presenter.hpp"
+#include "Chip8/Emulator/DisplayBackend.hpp"
+#include "Chip8/Emulator/Processor.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <cstring>
+
+Presenter::Presenter(DisplayBackend & backend, PresentPolicy policy)
+	: m_backend(backend)
+	, m_displayWidth(0)
+	, m_displayHeight(0)
+	, m_planeCount(0)
+	, m_policy(policy)
+	, m_refreshInterval(1.0f / backend.getRefreshRate())
+	, m_lastPresentTime()	// Long ago, so the first frame is presented without waiting for a refresh interval
+	, m_dirty(true)
+	, m_presentedFrameCount(0)
+	, m_skippedFrameCount(0)
+	, m_lastUploadBytes(0)
+	, m_totalUploadBytes(0)
+{
+}
+
+Presenter::~Presenter()
+{
+}
+
+void Presenter::markDirty()
+{
+	m_dirty = true;
+}
+
+void Presenter::update(Chip8Processor & processor, bool frameBoundary)
+{
+	if (!m_dirty)
+		return;
+
+	switch (m_policy)
+	{
+	case PresentPolicy::IMMEDIATE:
+		present(processor);
+		break;
+
+	case PresentPolicy::HOST_REFRESH:
+		// Swapping more often than the monitor refreshes only blocks the emulation when vsync is on
+		if (std::chrono::high_resolution_clock::now() - m_lastPresentTime >= m_refreshInterval)
+			present(processor);
+		break;
+
+	case PresentPolicy::EMULATED_FRAME:
+		if (frameBoundary)
+			present(processor);
+		break;
+
+	default:
+		break;
+	}
+}
+
+long Presenter::getPresentedFrameCount() const
+{
+	return m_presentedFrameCount;
+}
+
+long Presenter::getSkippedFrameCount() const
+{
+	return m_skippedFrameCount;
+}
+
+size_t Presenter::getLastUploadBytes() const
+{
+	return m_lastUploadBytes;
+}
+
+size_t Presenter::getTotalUploadBytes() const
+{
+	return m_totalUploadBytes;
+}
+
+void Presenter::present(Chip8Processor & processor)
+{
+	const qword *framebuffer = processor.getGraphicsMemory();
+	size_t framebufferSize = static_cast<size_t>(processor.getGraphicsMemorySize());
+
+	m_dirty = false;
+	m_lastPresentTime = std::chrono::high_resolution_clock::now();
+
+	// Switching the display mode or adding a plane marks the complete display as dirty, the backend only has to resize
+	if (processor.getDisplayWidth() != m_displayWidth || processor.getDisplayHeight() != m_displayHeight ||
+		processor.getDisplayPlaneCount() != m_planeCount)
+	{
+		m_displayWidth = processor.getDisplayWidth();
+		m_displayHeight = processor.getDisplayHeight();
+		m_planeCount = processor.getDisplayPlaneCount();
+		m_backend.setDisplaySize(m_displayWidth, m_displayHeight, m_planeCount);
+		m_presentedFrame.clear();
+	}
+
+	// Sprites are XOR-ed, so drawing the same sprite twice within one present interval results in the same image.
+	// The very first present after a mode switch is never skipped because nothing has been presented yet.
+	bool firstPresent = m_presentedFrame.empty();
+	if (!firstPresent && memcmp(framebuffer, m_presentedFrame.data(), framebufferSize) == 0)
+	{
+		processor.clearDirtyRegion();
+		++m_skippedFrameCount;
+		return;
+	}
+
+	m_presentedFrame.assign(framebuffer, framebuffer + framebufferSize / sizeof(qword));
+
+	// Upload only the parts of the framebuffer that the clear / draw instructions touched
+	m_lastUploadBytes = m_backend.updatePixels(m_presentedFrame.data(), processor.getDirtyRegion());
+	m_totalUploadBytes += m_lastUploadBytes;
+	processor.clearDirtyRegion();
+
+	m_backend.present();
+
+	++m_presentedFrameCount;
+}
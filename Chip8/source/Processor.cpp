@@ -1,14 +1,33 @@
 #include "Chip8/Emulator/Processor.hpp"
 #include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/BinaryBuffer.hpp"
 #include "Chip8/Emulator/Window.hpp"
-#include "Chip8/Emulator/Renderer.hpp"
 #include "Chip8/Utility/Disassembler.hpp"
+#include "Chip8/Utility/Coverage.hpp"
+#include "Chip8/Utility/InstructionSet.hpp"
+#include "Chip8/Utility/RomLibrary.hpp"
+#include "Chip8/Utility/RowShift.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <random>
+#include <sstream>
 #include <chrono>
+#include <cmath>
+
+// The 8x10 SUPER-CHIP font is stored right after the 4x5 font
+static const word BIG_FONT_ADDRESS = 0x50;
+
+// Addresses wrap around at the end of the 64 KB of memory
+static const int ADDRESS_MASK = 0xFFFF;
+
+// Written at the start of saved states, followed by the CORE_VERSION
+static const char SAVE_STATE_MAGIC[4] = { 'C', '8', 'S', 'T' };
 
 Chip8Processor::Chip8Processor()
+	: m_quirkProfile(QuirkProfile::SUPER_CHIP)
+	, m_coverage(nullptr)
 {
 }
 
@@ -28,8 +47,13 @@ void Chip8Processor::initialize()
 	m_soundTimer		= 0;		// Reset sound timer
 	drawFlag			= 0;		// Reset draw flag
 	quitFlag			= 0;		// Reset quit flag
+	traceFlag			= 1;		// Trace OpCodes by default
 	m_finalizeCalled	= 0;		// Reset finalization flag
 	m_applicationSize	= 0;		// Reset the size of the loaded application or game
+	m_keyPollCount		= 0;		// Reset the number of key checks
+
+	// Seed the random number generator, use setRandomSeed() for reproducible runs
+	m_randomEngine.seed(static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count()));
 
 	// Chip8 fontset
 	byte fontset[80] =
@@ -52,19 +76,52 @@ void Chip8Processor::initialize()
 		0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 	};
 
+	// SUPER-CHIP fontset (the digits A-F are not part of the original, they follow the style of the others)
+	byte bigFontset[160] =
+	{
+		0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+		0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+		0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+		0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+		0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+		0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+		0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+		0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+		0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+		0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+		0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+		0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+		0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+	};
+
 	// Reset the memory
 	m_memory = new byte[MEMORY_SIZE_BYTES];
-	for (size_t i = 0; i < MEMORY_SIZE_BYTES; ++i)
+	for (long i = 0; i < MEMORY_SIZE_BYTES; ++i)
 		m_memory[i] = 0;
 
 	// Save the fontset in memory
 	for (size_t j = 0; j < 80; ++j)
 		m_memory[j] = fontset[j];
 
-	// Reset the graphics memory
-	m_graphicsMemory = new byte[64 * 32];
-	for (size_t k = 0; k < 64 * 32; ++k)
-		m_graphicsMemory[k] = 0;
+	for (size_t j = 0; j < 160; ++j)
+		m_memory[BIG_FONT_ADDRESS + j] = bigFontset[j];
+
+	// Reset the graphics memory, it is large enough for every display mode. Setting the mode clears it and marks the
+	// complete display as dirty, so the first present always uploads everything.
+	m_graphicsMemory = new qword[MAX_DISPLAY_WORDS * MAX_DISPLAY_PLANES];
+	m_planeMask = 1;
+	m_planeCount = 1;
+	setDisplayMode(DisplayMode::LORES);
+	drawFlag = 0;
+
+	// Until a program loads its own pattern the sound is a square wave at the default pitch of 4000 samples per second
+	for (size_t i = 0; i < 16; ++i)
+		m_audioPattern[i] = i < 8 ? 0xFF : 0x00;
+
+	m_audioPitch = 64;
 
 	// Reset registers, stack, and keys
 	m_V		= new byte[16];
@@ -75,279 +132,383 @@ void Chip8Processor::initialize()
 		m_V[m]		= 0;
 		m_key[m]	= 0;
 		m_stack[m]	= 0;
+		m_flags[m]	= 0;
 	}
 }
 
 bool Chip8Processor::loadGame(const char *name)
 {
-	// Load the binary data
-	FILE *filePtr = fopen(name, "rb");
+	// Map the binary data instead of reading it into a temporary buffer
+	Chip8RomMapping mapping;
 
 	// The file needs to be open for this to work
-	if (filePtr == nullptr)
+	if (!mapping.open(name))
 		return false;
 
-	// Retrieve the size of the file by seeking all the way to the end
-	fseek(filePtr, 0, SEEK_END);	// Seek to end of the file
-	m_applicationSize = ftell(filePtr); // Get the current file pointer
-	fseek(filePtr, 0, SEEK_SET);	// Seek back to beginning of the file
+	return loadGame(mapping.getData(), mapping.getSize());
+}
 
-	// Allocate a buffer of the same size as the ROM
-	byte *romData = new byte[m_applicationSize];
-	fread(romData, sizeof(byte), m_applicationSize, filePtr);
-	fclose(filePtr);
+bool Chip8Processor::loadGame(const byte *rom, size_t size)
+{
+	// The ROM has to fit in the memory after the reserved space
+	if (size > static_cast<size_t>(MEMORY_SIZE_BYTES - 512))
+	{
+		m_applicationSize = 0;
+		return false;
+	}
 
 	// Save the ROM to the memory of the processor (offset of 0x200 a.k.a. 512 bytes to account for the reserved space)
-	for (long i = 0; i < m_applicationSize; ++i)
-		m_memory[512 + i] = romData[i];
+	if (size > 0)
+		memcpy(m_memory + 512, rom, size);
 
-	// No need to keep this data around any longer
-	delete[] romData;
+	m_applicationSize = static_cast<long>(size);
 
 	// Successfully loaded the ROM!
 	return true;
 }
 
 void Chip8Processor::newCycle()
+{
+	runCycles(1);
+}
+
+void Chip8Processor::runCycles(int count)
+{
+	// The profile is resolved once per call, the loop itself runs the interpreter that was compiled for the profile
+	switch (m_quirkProfile)
+	{
+	case QuirkProfile::COSMAC_VIP:
+		runCyclesWith<CosmacVipQuirks>(count);
+		break;
+
+	case QuirkProfile::CHIP48:
+		runCyclesWith<Chip48Quirks>(count);
+		break;
+
+	case QuirkProfile::XO_CHIP:
+		runCyclesWith<XoChipQuirks>(count);
+		break;
+
+	default:
+		runCyclesWith<SuperChipQuirks>(count);
+		break;
+	}
+}
+
+void Chip8Processor::setQuirkProfile(QuirkProfile profile)
+{
+	m_quirkProfile = profile;
+}
+
+QuirkProfile Chip8Processor::getQuirkProfile() const
+{
+	return m_quirkProfile;
+}
+
+template <typename Quirks>
+void Chip8Processor::runCyclesWith(int count)
+{
+	for (int i = 0; i < count; ++i)
+		executeCycle<Quirks>();
+}
+
+template <typename Quirks>
+void Chip8Processor::executeCycle()
 {
 	// Fetch OpCode (combines two bytes into a word)
-	word opCode = m_memory[m_PC] << 8 | m_memory[m_PC + 1];
+	word opCode = m_memory[m_PC] << 8 | m_memory[(m_PC + 1) & ADDRESS_MASK];
 
-	Chip8Disassembler::printOpCode(opCode);
+	// VIP two-page hires ROMs start with a jump to 0x260, where the hires interpreter they carry sets up the 64x64 display
+	// before it jumps to the actual program at 0x2C0. That interpreter is 1802 machine code, so it is skipped. The other
+	// profiles compile the check away, for them JP 0x260 is an ordinary jump.
+	if (Quirks::VIP_HIRES_ENTRY && opCode == 0x1260 && m_PC == 0x200)
+	{
+		setDisplayMode(DisplayMode::VIP_HIRES);
+		opCode = 0x12C0;
+	}
+
+	if (m_coverage != nullptr)
+		m_coverage->markFetch(m_PC);
+
+	if (traceFlag == 1)
+		Chip8Disassembler::printOpCode(opCode);
 
-	// TODO: use function pointers instead of this horrible switch statement
-	// Decode the first number of the OpCode
+	// The descriptor table decodes the OpCode. There is no default case, so the compiler warns about instructions without a handler.
 	// Reference: http://devernay.free.fr/hacks/chip8/C8TECH10.HTM#3.0
-	switch (opCode & 0xF000)
+	switch (decodeInstructionId(opCode))
 	{
-	case 0x0000:
-		switch (opCode & 0x000F)
-		{
-			// 00E0 - CLS (Clear the display)
-		case 0x0000:
-			CLS(opCode);
-			break;
-
-			// 00EE - RET (The interpreter sets the program counter to the address at the top of the stack, then subtracts 1 from the stack pointer)
-		case 0x000E:
-			RET(opCode);
-			break;
-
-			// 0nnn - SYS address (Execute a RCA 1802 program, not implemented in this emulator)
-		default:
-			SYSaddr(opCode);
-			break;
-		}
+		// 00Cn - SCD nibble (Scroll the display down by n pixels)
+	case Instruction::SCDnibble:
+		SCDnibble(opCode);
+		break;
+
+		// 00Dn - SCU nibble (Scroll the display up by n pixels, XO-CHIP)
+	case Instruction::SCUnibble:
+		SCUnibble(opCode);
+		break;
+
+		// 00FB - SCR (Scroll the display right by 4 pixels)
+	case Instruction::SCR:
+		SCR(opCode);
+		break;
+
+		// 00FC - SCL (Scroll the display left by 4 pixels)
+	case Instruction::SCL:
+		SCL(opCode);
+		break;
+
+		// 00FD - EXIT (Exit the interpreter)
+	case Instruction::EXIT:
+		EXIT(opCode);
+		break;
+
+		// 00FE - LOW (Switch to the 64x32 display)
+	case Instruction::LOW:
+		LOW(opCode);
+		break;
+
+		// 00FF - HIGH (Switch to the 128x64 display)
+	case Instruction::HIGH:
+		HIGH(opCode);
+		break;
+
+		// 00E0 - CLS (Clear the display)
+		// 0230 - CLS in the VIP two-page hires interpreter, which clears all 64 rows
+	case Instruction::CLS:
+		CLS(opCode);
+		break;
+
+		// 00EE - RET (The interpreter sets the program counter to the address at the top of the stack, then subtracts 1 from the stack pointer)
+	case Instruction::RET:
+		RET(opCode);
+		break;
+
+		// 0nnn - SYS address (Execute a RCA 1802 program, not implemented in this emulator)
+	case Instruction::SYSaddr:
+		SYSaddr(opCode);
 		break;
 
 		// 1nnn - JP addr (The interpreter sets the program counter to nnn)
-	case 0x1000:
+	case Instruction::JPaddr:
 		JPaddr(opCode);
 		break;
 
 		// 2nnn - CALL addr (The interpreter increments the stack pointer, then puts the current PC on the top of the stack. The PC is then set to nnn)
-	case 0x2000:
+	case Instruction::CALLaddr:
 		CALLaddr(opCode);
 		break;
 
 		// 3xkk - SE Vx, byte (The interpreter compares register Vx to kk, and if they are equal, increments the program counter by 2)
-	case 0x3000:
+	case Instruction::SEvxbyte:
 		SEvxbyte(opCode);
 		break;
 
 		// 4xkk - SNE Vx, byte (The interpreter compares register Vx to kk, and if they are not equal, increments the program counter by 2)
-	case 0x4000:
+	case Instruction::SNEvxbyte:
 		SNEvxbyte(opCode);
 		break;
 
+		// 5xy2 - SAVE Vx - Vy (Stores the registers Vx through Vy in memory starting at I, XO-CHIP)
+	case Instruction::SAVEvxvy:
+		SAVEvxvy(opCode);
+		break;
+
+		// 5xy3 - LOAD Vx - Vy (Reads the registers Vx through Vy from memory starting at I, XO-CHIP)
+	case Instruction::LOADvxvy:
+		LOADvxvy(opCode);
+		break;
+
 		// 5xy0 - SE Vx, Vy (The interpreter compares register Vx to register Vy, and if they are equal, increments the program counter by 2)
-	case 0x5000:
+	case Instruction::SEvxvy:
 		SEvxvy(opCode);
 		break;
 
 		// 6xkk - LD Vx, byte (The interpreter puts the value kk into register Vx)
-	case 0x6000:
+	case Instruction::LDvxbyte:
 		LDvxbyte(opCode);
 		break;
 
 		// 7xkk - ADD Vx, byte (Adds the value kk to the value of register Vx, then stores the result in Vx)
-	case 0x7000:
+	case Instruction::ADDvxbyte:
 		ADDvxbyte(opCode);
 		break;
 
-	case 0x8000:
-		switch (opCode & 0x000F)
-		{
-			// 8xy0 - LD Vx, Vy (Stores the value of register Vy in register Vx)
-		case 0x0000:
-			LDvxvy(opCode);
-			break;
-
-			// 8xy1 - OR Vx, Vy (Performs a bitwise OR on the values of Vx and Vy, then stores the result in Vx)
-		case 0x0001:
-			ORvxvy(opCode);
-			break;
-
-			// 8xy2 - AND Vx, Vy (Performs a bitwise AND on the values of Vx and Vy, then stores the result in Vx)
-		case 0x0002:
-			ANDvxvy(opCode);
-			break;
-
-			// 8xy3 - XOR Vx, Vy (Performs a bitwise exclusive OR on the values of Vx and Vy, then stores the result in Vx)
-		case 0x0003:
-			XORvxvy(opCode);
-			break;
-
-			// 8xy4 - ADD Vx, Vy (The values of Vx and Vy are added together. If the result is greater than 8 bits (i.e., > 255,)
-			//					  VF is set to 1, otherwise 0. Only the lowest 8 bits of the result are kept, and stored in Vx.)
-		case 0x0004:
-			ADDvxvy(opCode);
-			break;
-
-			// 8xy5 - SUB Vx, Vy (If Vx > Vy, then VF is set to 1, otherwise 0. Then Vy is subtracted from Vx, and the results stored in Vx)
-		case 0x0005:
-			SUBvxvy(opCode);
-			break;
-
-			// 8xy6 - SHR Vx {, Vy} (If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0. Then Vx is divided by 2)
-		case 0x0006:
-			SHRvxvy(opCode);
-			break;
-
-			// 8xy7 - SUBN Vx, Vy (If Vy > Vx, then VF is set to 1, otherwise 0. Then Vx is subtracted from Vy, and the results stored in Vx)
-		case 0x0007:
-			SUBNvxvy(opCode);
-			break;
-
-			// 8xyE - SHL Vx {, Vy} (If the most-significant bit of Vx is 1, then VF is set to 1, otherwise to 0. Then Vx is multiplied by 2)
-		case 0x000E:
-			SHLvxvy(opCode);
-			break;
-
-		default:
-			break;
-		}
+		// 8xy0 - LD Vx, Vy (Stores the value of register Vy in register Vx)
+	case Instruction::LDvxvy:
+		LDvxvy(opCode);
+		break;
+
+		// 8xy1 - OR Vx, Vy (Performs a bitwise OR on the values of Vx and Vy, then stores the result in Vx)
+	case Instruction::ORvxvy:
+		ORvxvy(opCode);
+		break;
+
+		// 8xy2 - AND Vx, Vy (Performs a bitwise AND on the values of Vx and Vy, then stores the result in Vx)
+	case Instruction::ANDvxvy:
+		ANDvxvy(opCode);
+		break;
+
+		// 8xy3 - XOR Vx, Vy (Performs a bitwise exclusive OR on the values of Vx and Vy, then stores the result in Vx)
+	case Instruction::XORvxvy:
+		XORvxvy(opCode);
+		break;
+
+		// 8xy4 - ADD Vx, Vy (The values of Vx and Vy are added together. If the result is greater than 8 bits (i.e., > 255,)
+		//					  VF is set to 1, otherwise 0. Only the lowest 8 bits of the result are kept, and stored in Vx.)
+	case Instruction::ADDvxvy:
+		ADDvxvy(opCode);
+		break;
+
+		// 8xy5 - SUB Vx, Vy (If Vx > Vy, then VF is set to 1, otherwise 0. Then Vy is subtracted from Vx, and the results stored in Vx)
+	case Instruction::SUBvxvy:
+		SUBvxvy(opCode);
+		break;
+
+		// 8xy6 - SHR Vx {, Vy} (If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0. Then Vx is divided by 2.
+		//						 The COSMAC VIP and XO-CHIP shift Vy and store the result in Vx instead)
+	case Instruction::SHRvxvy:
+		SHRvxvy<Quirks>(opCode);
+		break;
+
+		// 8xy7 - SUBN Vx, Vy (If Vy > Vx, then VF is set to 1, otherwise 0. Then Vx is subtracted from Vy, and the results stored in Vx)
+	case Instruction::SUBNvxvy:
+		SUBNvxvy(opCode);
+		break;
+
+		// 8xyE - SHL Vx {, Vy} (If the most-significant bit of Vx is 1, then VF is set to 1, otherwise to 0. Then Vx is multiplied by 2.
+		//						 The COSMAC VIP and XO-CHIP shift Vy and store the result in Vx instead)
+	case Instruction::SHLvxvy:
+		SHLvxvy<Quirks>(opCode);
 		break;
 
 		// 9xy0 - SNE Vx, Vy (The values of Vx and Vy are compared, and if they are not equal, the program counter is increased by 2)
-	case 0x9000:
+	case Instruction::SNEvxvy:
 		SNEvxvy(opCode);
 		break;
 
 		// Annn - LD I, addr (The value of register I is set to nnn)
-	case 0xA000:
+	case Instruction::LDiaddr:
 		LDiaddr(opCode);
 		break;
 
-		// Bnnn - JP V0, addr (The program counter is set to nnn plus the value of V0)
-	case 0xB000:
-		JPv0addr(opCode);
+		// Bnnn - JP V0, addr (The program counter is set to nnn plus the value of V0, CHIP-48 and SUPER-CHIP add Vx instead)
+	case Instruction::JPv0addr:
+		JPv0addr<Quirks>(opCode);
 		break;
 
 		// Cxkk - RND Vx, byte (The interpreter generates a random number from 0 to 255, which is then ANDed with the value kk.
 		//						The results are stored in Vx)
-	case 0xC000:
+	case Instruction::RNDvxbyte:
 		RNDvxbyte(opCode);
 		break;
 
-		// TODO: add a setting for the end user to toggle screen coordinate wrapping
 		// Dxyn - DRW Vx, Vy, nibble (The interpreter reads n bytes from memory, starting at the address stored in I. These bytes are then
 		//							  displayed as sprites on screen at coordinates (Vx, Vy). Sprites are XORed onto the existing screen.
 		//							  If this causes any pixels to be erased, VF is set to 1, otherwise it is set to 0. If the sprite is positioned
-		//							  so part of it is outside the coordinates of the display, it wraps around to the opposite side of the screen)
-	case 0xD000:
-		DRWvxvynibble(opCode);
+		//							  so part of it is outside the coordinates of the display, it wraps around to the opposite side of the screen
+		//							  or it is clipped, depending on the quirk profile)
+		// Dxy0 - DRW Vx, Vy, 0 (Draws a 16x16 sprite of two bytes per row, SUPER-CHIP)
+	case Instruction::DRWvxvynibble:
+		DRWvxvynibble<Quirks>(opCode);
 		break;
 
-	case 0xE000:
-		switch (opCode & 0x00FF)
-		{
-			// Ex9E - SKP Vx (Checks the keyboard, and if the key corresponding to the value of Vx is currently in the down position, PC is increased by 2)
-		case 0x009E:
-			SKPvx(opCode);
-			break;
-
-			// ExA1 - SKNP Vx (Checks the keyboard, and if the key corresponding to the value of Vx is currently in the up position, PC is increased by 2)
-		case 0x00A1:
-			SKNPvx(opCode);
-			break;
-
-		default:
-			break;
-		}
+		// Ex9E - SKP Vx (Checks the keyboard, and if the key corresponding to the value of Vx is currently in the down position, PC is increased by 2)
+	case Instruction::SKPvx:
+		SKPvx(opCode);
 		break;
 
-	case 0xF000:
-		switch (opCode & 0x00FF)
-		{
-			// Fx07 - LD Vx, DT (The value of DT is placed into Vx)
-		case 0x0007:
-			LDvxdt(opCode);
-			break;
-
-			// Fx0A - LD Vx, K (All execution stops until a key is pressed, then the value of that key is stored in Vx)
-		case 0x000A:
-			LDvxk(opCode);
-			break;
-
-			// Fx15 - LD DT, Vx (DT is set equal to the value of Vx)
-		case 0x0015:
-			LDdtvx(opCode);
-			break;
-			
-			// Fx18 - LD ST, Vx (ST is set equal to the value of Vx)
-		case 0x0018:
-			LDstvx(opCode);
-			break;
-
-			// Fx1E - ADD I, Vx (The values of I and Vx are added, and the results are stored in I)
-		case 0x001E:
-			ADDivx(opCode);
-			break;
-
-			// Fx29 - LD F, Vx (The value of I is set to the location for the hexadecimal sprite corresponding to the value of Vx)
-		case 0x0029:
-			LDfvx(opCode);
-			break;
-
-			// Fx33 - LD B, Vx (The interpreter takes the decimal value of Vx, and places the hundreds digit in memory at location in I,
-			//					the tens digit at location I+1, and the ones digit at location I+2)
-		case 0x0033:
-			LDbvx(opCode);
-			break;
-
-			// Fx55 - LD [I], Vx (The interpreter copies the values of registers V0 through Vx into memory, starting at the address in I)
-		case 0x0055:
-			LDivx(opCode);
-			break;
-
-			// Fx65 - LD Vx, [I] (The interpreter reads values from memory starting at location I into registers V0 through Vx)
-		case 0x0065:
-			LDvxi(opCode);
-			break;
-
-		default:
-			break;
-		}
+		// ExA1 - SKNP Vx (Checks the keyboard, and if the key corresponding to the value of Vx is currently in the up position, PC is increased by 2)
+	case Instruction::SKNPvx:
+		SKNPvx(opCode);
 		break;
 
-	default:
+		// F000 nnnn - LD I, long (The value of I is set to the 16-bit address in the next two bytes, XO-CHIP)
+	case Instruction::LDilong:
+		LDilong(opCode);
 		break;
-	}
-}
 
-void Chip8Processor::updateDisplay(const Window & window, const Renderer & renderer)
-{
-	// Save the new framebuffer to the render texture
-	renderer.updatePixels(m_graphicsMemory);
+		// Fn01 - PLANE n (Selects the planes that clear / draw / scroll instructions work on, XO-CHIP)
+	case Instruction::PLANEn:
+		PLANEn(opCode);
+		break;
 
-	// Render the new frame
-	renderer.draw();
+		// F002 - AUDIO (Copies the 16 bytes at I into the sound pattern, XO-CHIP)
+	case Instruction::AUDIO:
+		AUDIO(opCode);
+		break;
 
-	// Swap framebuffers
-	window.display();
+		// Fx07 - LD Vx, DT (The value of DT is placed into Vx)
+	case Instruction::LDvxdt:
+		LDvxdt(opCode);
+		break;
 
-	drawFlag = 0;
+		// Fx0A - LD Vx, K (All execution stops until a key is pressed, then the value of that key is stored in Vx)
+	case Instruction::LDvxk:
+		LDvxk(opCode);
+		break;
+
+		// Fx15 - LD DT, Vx (DT is set equal to the value of Vx)
+	case Instruction::LDdtvx:
+		LDdtvx(opCode);
+		break;
+
+		// Fx18 - LD ST, Vx (ST is set equal to the value of Vx)
+	case Instruction::LDstvx:
+		LDstvx(opCode);
+		break;
+
+		// Fx1E - ADD I, Vx (The values of I and Vx are added, and the results are stored in I)
+	case Instruction::ADDivx:
+		ADDivx(opCode);
+		break;
+
+		// Fx29 - LD F, Vx (The value of I is set to the location for the hexadecimal sprite corresponding to the value of Vx)
+	case Instruction::LDfvx:
+		LDfvx(opCode);
+		break;
+
+		// Fx30 - LD HF, Vx (The value of I is set to the location for the 8x10 sprite of the decimal digit in Vx, SUPER-CHIP)
+	case Instruction::LDhfvx:
+		LDhfvx(opCode);
+		break;
+
+		// Fx33 - LD B, Vx (The interpreter takes the decimal value of Vx, and places the hundreds digit in memory at location in I,
+		//					the tens digit at location I+1, and the ones digit at location I+2)
+	case Instruction::LDbvx:
+		LDbvx(opCode);
+		break;
+
+		// Fx3A - PITCH Vx (Sets the playback rate of the sound pattern, XO-CHIP)
+	case Instruction::PITCHvx:
+		PITCHvx(opCode);
+		break;
+
+		// Fx55 - LD [I], Vx (The interpreter copies the values of registers V0 through Vx into memory, starting at the address in I.
+		//					  Whether I is advanced afterwards depends on the quirk profile)
+	case Instruction::LDivx:
+		LDivx<Quirks>(opCode);
+		break;
+
+		// Fx65 - LD Vx, [I] (The interpreter reads values from memory starting at location I into registers V0 through Vx.
+		//					  Whether I is advanced afterwards depends on the quirk profile)
+	case Instruction::LDvxi:
+		LDvxi<Quirks>(opCode);
+		break;
+
+		// Fx75 - LD R, Vx (Stores V0 through Vx in the flag registers, SUPER-CHIP)
+	case Instruction::LDrvx:
+		LDrvx(opCode);
+		break;
+
+		// Fx85 - LD Vx, R (Reads V0 through Vx from the flag registers, SUPER-CHIP)
+	case Instruction::LDvxr:
+		LDvxr(opCode);
+		break;
+
+		// Unknown OpCodes are ignored
+	case Instruction::INVALID:
+		break;
+	}
 }
 
 void Chip8Processor::updateKeys(const Window & window)
@@ -379,6 +540,135 @@ void Chip8Processor::finalize()
 	m_finalizeCalled = 1;
 }
 
+void Chip8Processor::setKey(byte key, byte state)
+{
+	m_key[key & 0xF] = state;
+}
+
+void Chip8Processor::setRandomSeed(unsigned int seed)
+{
+	m_randomEngine.seed(seed);
+}
+
+void Chip8Processor::setCoverage(Chip8Coverage *coverage)
+{
+	m_coverage = coverage;
+}
+
+void Chip8Processor::saveState(std::string & state) const
+{
+	std::ostringstream randomEngine;
+	randomEngine << m_randomEngine;
+
+	state.clear();
+	state.append(SAVE_STATE_MAGIC, sizeof(SAVE_STATE_MAGIC));
+	appendBinary(state, CORE_VERSION);
+	appendBinary(state, m_quirkProfile);
+
+	appendBinary(state, m_memory, MEMORY_SIZE_BYTES);
+	appendBinary(state, m_applicationSize);
+
+	appendBinary(state, m_displayMode);
+	appendBinary(state, m_planeMask);
+	appendBinary(state, m_planeCount);
+	appendBinary(state, m_graphicsMemory, sizeof(qword) * MAX_DISPLAY_WORDS * MAX_DISPLAY_PLANES);
+
+	appendBinary(state, m_V, 16);
+	appendBinary(state, m_flags);
+	appendBinary(state, m_key, 16);
+	appendBinary(state, m_stack, sizeof(word) * 16);
+	appendBinary(state, m_SP);
+	appendBinary(state, m_I);
+	appendBinary(state, m_PC);
+	appendBinary(state, m_opCode);
+	appendBinary(state, m_delayTimer);
+	appendBinary(state, m_soundTimer);
+	appendBinary(state, m_audioPattern);
+	appendBinary(state, m_audioPitch);
+	appendBinary(state, quitFlag);
+	appendBinaryString(state, randomEngine.str());
+}
+
+bool Chip8Processor::loadState(const std::string & state)
+{
+	BinaryReader reader(state);
+
+	char magic[4];
+	unsigned int version;
+	QuirkProfile quirkProfile;
+
+	if (!reader.read(magic) || memcmp(magic, SAVE_STATE_MAGIC, sizeof(magic)) != 0 || !reader.read(version) ||
+		version != CORE_VERSION || !reader.read(quirkProfile))
+		return false;
+
+	// Everything is read into a copy first, so a damaged state leaves the processor as it was
+	std::string memory(MEMORY_SIZE_BYTES, '\0');
+	std::string graphicsMemory(sizeof(qword) * MAX_DISPLAY_WORDS * MAX_DISPLAY_PLANES, '\0');
+	long applicationSize;
+	DisplayMode displayMode;
+	byte planeMask, planeCount;
+	byte V[16], flags[16], key[16];
+	word stack[16];
+	word SP, I, PC, opCode;
+	byte delayTimer, soundTimer;
+	byte audioPattern[16];
+	byte audioPitch;
+	byte quit;
+	std::string randomEngineText;
+
+	if (!reader.read(&memory[0], memory.size()) || !reader.read(applicationSize) || !reader.read(displayMode) ||
+		!reader.read(planeMask) || !reader.read(planeCount) || !reader.read(&graphicsMemory[0], graphicsMemory.size()) ||
+		!reader.read(V) || !reader.read(flags) || !reader.read(key) || !reader.read(stack) || !reader.read(SP) ||
+		!reader.read(I) || !reader.read(PC) || !reader.read(opCode) || !reader.read(delayTimer) || !reader.read(soundTimer) ||
+		!reader.read(audioPattern) || !reader.read(audioPitch) || !reader.read(quit) || !reader.readString(randomEngineText) ||
+		!reader.isAtEnd())
+		return false;
+
+	// The emulation indexes and switches with these values, anything out of range was not written by saveState()
+	if (quirkProfile > QuirkProfile::XO_CHIP || displayMode > DisplayMode::SCHIP_HIRES || planeMask > 3 ||
+		(planeCount != 1 && planeCount != 2) || SP > 15 || applicationSize < 0 || applicationSize > MEMORY_SIZE_BYTES - 512)
+		return false;
+
+	std::default_random_engine randomEngine;
+	std::istringstream randomEngineStream(randomEngineText);
+	randomEngineStream >> randomEngine;
+	if (randomEngineStream.fail())
+		return false;
+
+	m_quirkProfile = quirkProfile;
+
+	// Setting the mode clears the display and marks all of it as dirty, the saved pixels are copied in afterwards
+	setDisplayMode(displayMode);
+	memcpy(m_graphicsMemory, graphicsMemory.data(), graphicsMemory.size());
+	m_planeMask = planeMask;
+	m_planeCount = planeCount;
+
+	memcpy(m_memory, memory.data(), memory.size());
+	m_applicationSize = applicationSize;
+
+	memcpy(m_V, V, sizeof(V));
+	memcpy(m_flags, flags, sizeof(flags));
+	memcpy(m_key, key, sizeof(key));
+	memcpy(m_stack, stack, sizeof(stack));
+	m_SP = SP;
+	m_I = I;
+	m_PC = PC;
+	m_opCode = opCode;
+	m_delayTimer = delayTimer;
+	m_soundTimer = soundTimer;
+	memcpy(m_audioPattern, audioPattern, sizeof(audioPattern));
+	m_audioPitch = audioPitch;
+	quitFlag = quit;
+	m_randomEngine = randomEngine;
+
+	return true;
+}
+
+long long Chip8Processor::getKeyPollCount() const
+{
+	return m_keyPollCount;
+}
+
 const word Chip8Processor::getPC() const
 {
 	return m_PC;
@@ -394,17 +684,88 @@ byte *Chip8Processor::getMemoryStart() const
 	return m_finalizeCalled == 0 ? &m_memory[0] : nullptr;
 }
 
+const qword *Chip8Processor::getGraphicsMemory() const
+{
+	return m_finalizeCalled == 0 ? &m_graphicsMemory[0] : nullptr;
+}
+
+const long Chip8Processor::getGraphicsMemorySize() const
+{
+	return m_planeCount * m_rowWords * m_displayHeight * sizeof(qword);
+}
+
+byte Chip8Processor::getPixel(byte x, byte y) const
+{
+	x %= m_displayWidth;
+	size_t index = (y % m_displayHeight) * m_rowWords + x / 64;
+
+	byte color = 0;
+	for (byte plane = 0; plane < m_planeCount; ++plane)
+		color |= ((getPlane(plane)[index] >> (63 - (x % 64))) & 1) << plane;
+
+	return color;
+}
+
+DisplayMode Chip8Processor::getDisplayMode() const
+{
+	return m_displayMode;
+}
+
+int Chip8Processor::getDisplayWidth() const
+{
+	return m_displayWidth;
+}
+
+int Chip8Processor::getDisplayHeight() const
+{
+	return m_displayHeight;
+}
+
+int Chip8Processor::getDisplayPlaneCount() const
+{
+	return m_planeCount;
+}
+
+const byte *Chip8Processor::getAudioPattern() const
+{
+	return m_audioPattern;
+}
+
+double Chip8Processor::getAudioPlaybackRate() const
+{
+	// A pitch of 64 plays 4000 samples per second, every 48 steps double the rate
+	return 4000.0 * pow(2.0, (m_audioPitch - 64) / 48.0);
+}
+
+const DirtyRegion & Chip8Processor::getDirtyRegion() const
+{
+	return m_dirtyRegion;
+}
+
+void Chip8Processor::clearDirtyRegion()
+{
+	m_dirtyRegion.clear();
+}
+
 void Chip8Processor::CLS(word opCode)
 {
-	for (size_t i = 0; i < 64 * 32; ++i)
-		m_graphicsMemory[i] = 0;
+	for (byte plane = 0; plane < m_planeCount; ++plane)
+	{
+		if ((m_planeMask & (1 << plane)) != 0)
+			memset(getPlane(plane), 0, static_cast<size_t>(m_rowWords) * m_displayHeight * sizeof(qword));
+	}
+
+	m_dirtyRegion.addAll(m_displayWidth, m_displayHeight);
+	drawFlag = 1;
 
 	m_PC += 2;
 }
 
 void Chip8Processor::RET(word opCode)
 {
-	m_PC = m_stack[m_SP--];
+	// The stack pointer wraps around instead of running off the 16 levels of nesting
+	m_PC = m_stack[m_SP];
+	m_SP = (m_SP - 1) & 0xF;
 	m_PC += 2;
 }
 
@@ -420,14 +781,15 @@ void Chip8Processor::JPaddr(word opCode)
 
 void Chip8Processor::CALLaddr(word opCode)
 {
-	m_stack[++m_SP] = m_PC;
+	m_SP = (m_SP + 1) & 0xF;
+	m_stack[m_SP] = m_PC;
 	m_PC = (opCode & 0x0FFF);
 }
 
 void Chip8Processor::SEvxbyte(word opCode)
 {
 	if (m_V[(opCode & 0x0F00) >> 8] == (opCode & 0x00FF))
-		m_PC += 4;
+		m_PC += getSkipDistance();
 	else
 		m_PC += 2;
 }
@@ -435,7 +797,7 @@ void Chip8Processor::SEvxbyte(word opCode)
 void Chip8Processor::SNEvxbyte(word opCode)
 {
 	if (m_V[(opCode & 0x0F00) >> 8] != (opCode & 0x00FF))
-		m_PC += 4;
+		m_PC += getSkipDistance();
 	else
 		m_PC += 2;
 }
@@ -443,7 +805,7 @@ void Chip8Processor::SNEvxbyte(word opCode)
 void Chip8Processor::SEvxvy(word opCode)
 {
 	if (m_V[(opCode & 0x0F00) >> 8] == m_V[(opCode & 0x00F0) >> 4])
-		m_PC += 4;
+		m_PC += getSkipDistance();
 	else
 		m_PC += 2;
 }
@@ -484,64 +846,59 @@ void Chip8Processor::XORvxvy(word opCode)
 	m_PC += 2;
 }
 
+// The flag is written after the result, so an operation on VF itself ends with the flag in VF
 void Chip8Processor::ADDvxvy(word opCode)
 {
-	// Add Vy to Vx
-	m_V[(opCode & 0x0F00) >> 8] += m_V[(opCode & 0x00F0) >> 4];
+	// Add Vy to Vx, the sum is computed in more than 8 bits to see the carry
+	int sum = m_V[(opCode & 0x0F00) >> 8] + m_V[(opCode & 0x00F0) >> 4];
 
-	if (m_V[(opCode & 0x0F00) >> 8] > 0xFF)
-		m_V[0xF] = 1;	// Carry flag set
-	else
-		m_V[0xF] = 0;	// Carry flag unset
+	m_V[(opCode & 0x0F00) >> 8] = static_cast<byte>(sum);
+	m_V[0xF] = sum > 0xFF ? 1 : 0;	// Carry flag
 
 	m_PC += 2;
 }
 
 void Chip8Processor::SUBvxvy(word opCode)
 {
-	if (m_V[(opCode & 0x0F00) >> 8] > m_V[(opCode & 0x00F0) >> 4])
-		m_V[0xF] = 1;
-	else
-		m_V[0xF] = 0;
+	byte vx = m_V[(opCode & 0x0F00) >> 8];
+	byte vy = m_V[(opCode & 0x00F0) >> 4];
 
-	m_V[(opCode & 0x0F00) >> 8] -= m_V[(opCode & 0x00F0) >> 4];
+	m_V[(opCode & 0x0F00) >> 8] = vx - vy;
+	m_V[0xF] = vx >= vy ? 1 : 0;	// No borrow flag
 
 	m_PC += 2;
 }
 
+template <typename Quirks>
 void Chip8Processor::SHRvxvy(word opCode)
 {
-	if ((opCode & 1) == 1)
-		m_V[0xF] = 1;
-	else
-		m_V[0xF] = 0;
+	byte value = m_V[Quirks::SHIFT_READS_VY ? (opCode & 0x00F0) >> 4 : (opCode & 0x0F00) >> 8];
 
-	m_V[(opCode & 0x0F00) >> 8] /= 2;
+	m_V[(opCode & 0x0F00) >> 8] = value >> 1;
+	m_V[0xF] = value & 0x1;
 
 	m_PC += 2;
 }
 
 void Chip8Processor::SUBNvxvy(word opCode)
 {
-	if (m_V[(opCode & 0x0F00) >> 8] > m_V[(opCode & 0x00F0) >> 4])
-		m_V[0xF] = 1;	// No borrow flag set
-	else
-		m_V[0xF] = 0;	// No borrow flag unset
+	byte vx = m_V[(opCode & 0x0F00) >> 8];
+	byte vy = m_V[(opCode & 0x00F0) >> 4];
 
-	m_V[(opCode & 0x0F00) >> 8] = m_V[(opCode & 0x00F0) >> 4] - m_V[(opCode & 0x0F00) >> 8];
+	m_V[(opCode & 0x0F00) >> 8] = vy - vx;
+	m_V[0xF] = vy >= vx ? 1 : 0;	// No borrow flag
 
 	m_PC += 2;
 }
 
+template <typename Quirks>
 void Chip8Processor::SHLvxvy(word opCode)
 {
-	// Since the value in the register is 8 bits, the MSB can be retrieved by shifting all bits 7 places to the right
-	if ((m_V[(opCode & 0x0F00) >> 8] >> 7) == 1)
-		m_V[0xF] = 1;
-	else
-		m_V[0xF] = 0;
+	byte value = m_V[Quirks::SHIFT_READS_VY ? (opCode & 0x00F0) >> 4 : (opCode & 0x0F00) >> 8];
 
-	m_V[(opCode & 0x0F00) >> 8] *= 2;
+	// Since the value in the register is 8 bits, the MSB can be retrieved by shifting all bits 7 places to the right
+	m_V[(opCode & 0x0F00) >> 8] = value << 1;
+	m_V[0xF] = value >> 7;
 
 	m_PC += 2;
 }
@@ -549,7 +906,7 @@ void Chip8Processor::SHLvxvy(word opCode)
 void Chip8Processor::SNEvxvy(word opCode)
 {
 	if (m_V[(opCode & 0x0F00) >> 8] != m_V[(opCode & 0x00F0) >> 4])
-		m_PC += 4;
+		m_PC += getSkipDistance();
 	else
 		m_PC += 2;
 }
@@ -560,19 +917,18 @@ void Chip8Processor::LDiaddr(word opCode)
 	m_PC += 2;
 }
 
+template <typename Quirks>
 void Chip8Processor::JPv0addr(word opCode)
 {
-	m_PC = (opCode & 0x0FFF) + m_V[0x0];
+	m_PC = (opCode & 0x0FFF) + m_V[Quirks::JUMP_ADDS_VX ? (opCode & 0x0F00) >> 8 : 0x0];
 }
 
 void Chip8Processor::RNDvxbyte(word opCode)
 {
-	// Create and seed the random number generator
-	std::default_random_engine generator(std::chrono::system_clock::now().time_since_epoch().count());
 	std::uniform_int_distribution<int> distribution(0, 255);
 
 	// Get a random value
-	byte randomValue = static_cast<byte>(distribution(generator));
+	byte randomValue = static_cast<byte>(distribution(m_randomEngine));
 
 	// Perform bit-wise AND on kk and the random number, then store the result in register Vx
 	m_V[(opCode & 0x0F00) >> 8] = randomValue & (opCode & 0x00FF);
@@ -583,53 +939,157 @@ void Chip8Processor::RNDvxbyte(word opCode)
 // Dxyn - DRW Vx, Vy, nibble (The interpreter reads n bytes from memory, starting at the address stored in I. These bytes are then
 //							  displayed as sprites on screen at coordinates (Vx, Vy). Sprites are XORed onto the existing screen.
 //							  If this causes any pixels to be erased, VF is set to 1, otherwise it is set to 0. If the sprite is positioned
-//							  so part of it is outside the coordinates of the display, it wraps around to the opposite side of the screen)
+//							  so part of it is outside the coordinates of the display, it wraps around to the opposite side of the screen
+//							  or it is clipped, depending on the quirk profile. The coordinates themselves always wrap)
+template <typename Quirks>
 void Chip8Processor::DRWvxvynibble(word opCode)
 {
 	byte coordinateX	= m_V[(opCode & 0x0F00) >> 8];
 	byte coordinateY	= m_V[(opCode & 0x00F0) >> 4];
 	byte numOfBytes		= (opCode & 0x000F);
 
-	// Reset the Vf register
-	m_V[0xF] = 0;
+	// Dxy0 draws a 16x16 sprite of two bytes per row
+	byte spriteWidth	= numOfBytes == 0 ? 16 : 8;
+	byte spriteHeight	= numOfBytes == 0 ? 16 : numOfBytes;
+
+	// Display sizes are powers of two, so wrapping is a mask
+	byte left			= coordinateX & (m_displayWidth - 1);
+	byte top			= coordinateY & (m_displayHeight - 1);
+
+	// The sprite is drawn on every selected plane (XO-CHIP), the data of the next plane follows the data of the previous one
+	bool collision = false;
+	word address = m_I;
+
+	for (byte plane = 0; plane < m_planeCount; ++plane)
+	{
+		if ((m_planeMask & (1 << plane)) == 0)
+			continue;
+
+		collision |= drawSprite<Quirks>(getPlane(plane), address, left, top, spriteWidth, spriteHeight);
+		address += spriteHeight * (spriteWidth / 8);
+	}
+
+	// If any pixel on the display was erased, the Vf register needs to be set
+	m_V[0xF] = collision ? 1 : 0;
+
+	// Record the touched area, a sprite that wraps around the edges of the display is split into up to four rectangles
+	byte leftWidth		= std::min<byte>(spriteWidth, m_displayWidth - left);
+	byte topHeight		= std::min<byte>(spriteHeight, m_displayHeight - top);
+
+	m_dirtyRegion.add(left, top, leftWidth, topHeight);
+
+	if (!Quirks::SPRITES_WRAP)
+	{
+		drawFlag = 1;
+		m_PC += 2;
+		return;
+	}
+
+	if (leftWidth < spriteWidth)
+		m_dirtyRegion.add(0, top, spriteWidth - leftWidth, topHeight);
+
+	if (topHeight < spriteHeight)
+	{
+		m_dirtyRegion.add(left, 0, leftWidth, spriteHeight - topHeight);
+
+		if (leftWidth < spriteWidth)
+			m_dirtyRegion.add(0, 0, spriteWidth - leftWidth, spriteHeight - topHeight);
+	}
+
+	drawFlag = 1;
+	m_PC += 2;
+}
+
+template <typename Quirks>
+bool Chip8Processor::drawSprite(qword *plane, word address, byte left, byte top, byte spriteWidth, byte spriteHeight)
+{
+	qword collision = 0;
+
+	// Sprite rows are moved to the leftmost pixels of a word
+	auto spriteRowAt = [this, address, spriteWidth](byte i) -> qword
+	{
+		if (spriteWidth == 16)
+			return static_cast<qword>(m_memory[(address + i * 2) & ADDRESS_MASK] << 8 | m_memory[(address + i * 2 + 1) & ADDRESS_MASK]) << 48;
+
+		return static_cast<qword>(m_memory[(address + i) & ADDRESS_MASK]) << 56;
+	};
+
+	// Clipped sprites stop at the bottom of the display
+	if (!Quirks::SPRITES_WRAP)
+		spriteHeight = std::min<byte>(spriteHeight, m_displayHeight - top);
+
+	if (m_rowWords == 1)
+	{
+		for (byte i = 0; i < spriteHeight; ++i)
+		{
+			// Rotate the sprite into place, rotating wraps the sprite around to the opposite side of the screen. Shifting
+			// drops the pixels past the right edge instead.
+			qword spriteRow = spriteRowAt(i);
+
+			if (Quirks::SPRITES_WRAP && left != 0)
+				spriteRow = (spriteRow >> left) | (spriteRow << (64 - left));
+			else
+				spriteRow >>= left;
+
+			qword & row = plane[(top + i) & (m_displayHeight - 1)];
 
-	// Loop through every byte of the sprite
-	for (byte i = 0; i < numOfBytes; ++i)
+			// XOR the new pixels with the existing screen pixels
+			collision |= row & spriteRow;
+			row ^= spriteRow;
+		}
+	}
+	else
 	{
-		// Retrieve the sprite data
-		byte spriteData = m_memory[m_I + i];
+		// Rotating the 128-bit row (sprite, 0) right by 64 or more swaps the words, clipping drops the word past the edge
+		byte shift = left & 63;
+		bool swapWords = left >= 64;
 
-		for (byte j = 0; j < 8; ++j)
+		for (byte i = 0; i < spriteHeight; ++i)
 		{
-			// Check every bit of the byte
-			if ((spriteData & (0x80 >> j)) != 0)
+			qword leftWord = spriteRowAt(i);
+			qword rightWord = 0;
+
+			if (shift != 0)
 			{
-				// If the pixel on the display is already set to one, the Vf register needs to be set
-				if (m_graphicsMemory[(coordinateX + j + ((coordinateY + i) * 64))] == 1)
-					m_V[0xF] = 1;
-				
-				// XOR the new pixel value with the existing screen pixel value
-				m_graphicsMemory[coordinateX + j + ((coordinateY + i) * 64)] ^= 1;
+				rightWord = leftWord << (64 - shift);
+				leftWord >>= shift;
 			}
+
+			if (swapWords && Quirks::SPRITES_WRAP)
+				std::swap(leftWord, rightWord);
+			else if (swapWords)
+			{
+				rightWord = leftWord;
+				leftWord = 0;
+			}
+
+			qword *row = &plane[((top + i) & (m_displayHeight - 1)) * 2];
+
+			collision |= (row[0] & leftWord) | (row[1] & rightWord);
+			row[0] ^= leftWord;
+			row[1] ^= rightWord;
 		}
 	}
 
-	drawFlag = 1;
-	m_PC += 2;
+	return collision != 0;
 }
 
 void Chip8Processor::SKPvx(word opCode)
 {
-	if (m_key[m_V[(opCode & 0x0F00) >> 8]] == 1)	// Key down, contact
-		m_PC += 4;
+	++m_keyPollCount;
+
+	if (m_key[m_V[(opCode & 0x0F00) >> 8] & 0xF] == 1)	// Key down, contact
+		m_PC += getSkipDistance();
 	else
 		m_PC += 2;
 }
 
 void Chip8Processor::SKNPvx(word opCode)
 {
-	if (m_key[m_V[(opCode & 0x0F00) >> 8]] == 0)	// Key up, no contact
-		m_PC += 4;
+	++m_keyPollCount;
+
+	if (m_key[m_V[(opCode & 0x0F00) >> 8] & 0xF] == 0)	// Key up, no contact
+		m_PC += getSkipDistance();
 	else
 		m_PC += 2;
 }
@@ -642,6 +1102,8 @@ void Chip8Processor::LDvxdt(word opCode)
 
 void Chip8Processor::LDvxk(word opCode)
 {
+	++m_keyPollCount;
+
 	byte keyPressed = 0;
 
 	for (byte i = 0; i < 16; ++i)
@@ -681,7 +1143,8 @@ void Chip8Processor::ADDivx(word opCode)
 
 void Chip8Processor::LDfvx(word opCode)
 {
-	m_I = m_memory[m_V[(opCode & 0x0F00) >> 8]];
+	// The 4x5 font starts at address 0 with five bytes per digit
+	m_I = (m_V[(opCode & 0x0F00) >> 8] & 0xF) * 5;
 	m_PC += 2;
 }
 
@@ -689,25 +1152,254 @@ void Chip8Processor::LDbvx(word opCode)
 {
 	byte value = m_V[(opCode & 0x0F00) >> 8];
 
-	m_memory[m_I + 0] = value / 100;		// Hundreds
-	m_memory[m_I + 1] = (value / 10) % 10;	// Tens
-	m_memory[m_I + 2] = (value % 100) % 10;	// Ones
+	m_memory[(m_I + 0) & ADDRESS_MASK] = value / 100;			// Hundreds
+	m_memory[(m_I + 1) & ADDRESS_MASK] = (value / 10) % 10;	// Tens
+	m_memory[(m_I + 2) & ADDRESS_MASK] = (value % 100) % 10;	// Ones
 
 	m_PC += 2;
 }
 
+template <typename Quirks>
 void Chip8Processor::LDivx(word opCode)
 {
-	for (byte i = 0; i < ((opCode & 0x0F00) >> 8); ++i)
-		m_memory[m_I + i] = m_V[i];
+	byte x = (opCode & 0x0F00) >> 8;
+
+	for (byte i = 0; i <= x; ++i)
+		m_memory[(m_I + i) & ADDRESS_MASK] = m_V[i];
 
+	advanceIndex<Quirks>(x);
 	m_PC += 2;
 }
 
+template <typename Quirks>
 void Chip8Processor::LDvxi(word opCode)
 {
-	for (byte i = 0; i < ((opCode & 0x0F00) >> 8); ++i)
-		m_V[i] = m_memory[m_I + i];
+	byte x = (opCode & 0x0F00) >> 8;
+
+	for (byte i = 0; i <= x; ++i)
+		m_V[i] = m_memory[(m_I + i) & ADDRESS_MASK];
+
+	advanceIndex<Quirks>(x);
+	m_PC += 2;
+}
+
+template <typename Quirks>
+void Chip8Processor::advanceIndex(byte x)
+{
+	if (Quirks::INDEX_INCREMENT == IndexIncrement::X)
+		m_I += x;
+	else if (Quirks::INDEX_INCREMENT == IndexIncrement::X_PLUS_ONE)
+		m_I += x + 1;
+}
+
+// Scroll amounts are in pixels of the current display mode, only the selected planes scroll
+void Chip8Processor::SCDnibble(word opCode)
+{
+	size_t rows = std::min<size_t>(opCode & 0x000F, m_displayHeight);
+	size_t rowBytes = m_rowWords * sizeof(qword);
+
+	for (byte plane = 0; plane < m_planeCount; ++plane)
+	{
+		if ((m_planeMask & (1 << plane)) == 0)
+			continue;
+
+		// Rows are contiguous, so scrolling down is a single move of the display followed by clearing the rows at the top
+		qword *rowsOfPlane = getPlane(plane);
+		memmove(rowsOfPlane + rows * m_rowWords, rowsOfPlane, (m_displayHeight - rows) * rowBytes);
+		memset(rowsOfPlane, 0, rows * rowBytes);
+	}
+
+	m_dirtyRegion.addAll(m_displayWidth, m_displayHeight);
+	drawFlag = 1;
+
+	m_PC += 2;
+}
+
+void Chip8Processor::SCR(word opCode)
+{
+	for (byte plane = 0; plane < m_planeCount; ++plane)
+	{
+		if ((m_planeMask & (1 << plane)) != 0)
+			shiftBitPackedRowsRight(getPlane(plane), m_rowWords, m_displayHeight, 4);
+	}
+
+	m_dirtyRegion.addAll(m_displayWidth, m_displayHeight);
+	drawFlag = 1;
+
+	m_PC += 2;
+}
+
+void Chip8Processor::SCL(word opCode)
+{
+	for (byte plane = 0; plane < m_planeCount; ++plane)
+	{
+		if ((m_planeMask & (1 << plane)) != 0)
+			shiftBitPackedRowsLeft(getPlane(plane), m_rowWords, m_displayHeight, 4);
+	}
+
+	m_dirtyRegion.addAll(m_displayWidth, m_displayHeight);
+	drawFlag = 1;
+
+	m_PC += 2;
+}
+
+void Chip8Processor::EXIT(word opCode)
+{
+	quitFlag = 1;
+}
+
+void Chip8Processor::LOW(word opCode)
+{
+	setDisplayMode(DisplayMode::LORES);
+	m_PC += 2;
+}
+
+void Chip8Processor::HIGH(word opCode)
+{
+	setDisplayMode(DisplayMode::SCHIP_HIRES);
+	m_PC += 2;
+}
+
+void Chip8Processor::LDhfvx(word opCode)
+{
+	m_I = BIG_FONT_ADDRESS + (m_V[(opCode & 0x0F00) >> 8] & 0xF) * 10;
+	m_PC += 2;
+}
+
+void Chip8Processor::LDrvx(word opCode)
+{
+	for (byte i = 0; i <= ((opCode & 0x0F00) >> 8); ++i)
+		m_flags[i] = m_V[i];
+
+	m_PC += 2;
+}
+
+void Chip8Processor::LDvxr(word opCode)
+{
+	for (byte i = 0; i <= ((opCode & 0x0F00) >> 8); ++i)
+		m_V[i] = m_flags[i];
+
+	m_PC += 2;
+}
+
+void Chip8Processor::SCUnibble(word opCode)
+{
+	size_t rows = std::min<size_t>(opCode & 0x000F, m_displayHeight);
+	size_t rowBytes = m_rowWords * sizeof(qword);
+
+	for (byte plane = 0; plane < m_planeCount; ++plane)
+	{
+		if ((m_planeMask & (1 << plane)) == 0)
+			continue;
+
+		qword *rowsOfPlane = getPlane(plane);
+		memmove(rowsOfPlane, rowsOfPlane + rows * m_rowWords, (m_displayHeight - rows) * rowBytes);
+		memset(rowsOfPlane + (m_displayHeight - rows) * m_rowWords, 0, rows * rowBytes);
+	}
+
+	m_dirtyRegion.addAll(m_displayWidth, m_displayHeight);
+	drawFlag = 1;
+
+	m_PC += 2;
+}
+
+// The registers are stored in the order they are listed, so 5xy2 with x > y stores them in descending order
+void Chip8Processor::SAVEvxvy(word opCode)
+{
+	byte x = (opCode & 0x0F00) >> 8;
+	byte y = (opCode & 0x00F0) >> 4;
+	byte count = (x < y ? y - x : x - y) + 1;
+
+	for (byte i = 0; i < count; ++i)
+		m_memory[(m_I + i) & ADDRESS_MASK] = m_V[x < y ? x + i : x - i];
+
+	m_PC += 2;
+}
+
+void Chip8Processor::LOADvxvy(word opCode)
+{
+	byte x = (opCode & 0x0F00) >> 8;
+	byte y = (opCode & 0x00F0) >> 4;
+	byte count = (x < y ? y - x : x - y) + 1;
+
+	for (byte i = 0; i < count; ++i)
+		m_V[x < y ? x + i : x - i] = m_memory[(m_I + i) & ADDRESS_MASK];
+
+	m_PC += 2;
+}
+
+void Chip8Processor::LDilong(word opCode)
+{
+	m_I = m_memory[(m_PC + 2) & ADDRESS_MASK] << 8 | m_memory[(m_PC + 3) & ADDRESS_MASK];
+	m_PC += 4;
+}
+
+void Chip8Processor::PLANEn(word opCode)
+{
+	m_planeMask = (opCode & 0x0F00) >> 8 & 0x3;
+
+	// The second plane is part of the display from the first time it is selected on
+	if ((m_planeMask & 0x2) != 0 && m_planeCount < 2)
+	{
+		m_planeCount = 2;
+		m_dirtyRegion.addAll(m_displayWidth, m_displayHeight);
+		drawFlag = 1;
+	}
+
+	m_PC += 2;
+}
+
+void Chip8Processor::AUDIO(word opCode)
+{
+	for (byte i = 0; i < 16; ++i)
+		m_audioPattern[i] = m_memory[(m_I + i) & ADDRESS_MASK];
+
+	m_PC += 2;
+}
 
+void Chip8Processor::PITCHvx(word opCode)
+{
+	m_audioPitch = m_V[(opCode & 0x0F00) >> 8];
 	m_PC += 2;
 }
+
+word Chip8Processor::getSkipDistance() const
+{
+	if (m_memory[(m_PC + 2) & ADDRESS_MASK] == 0xF0 && m_memory[(m_PC + 3) & ADDRESS_MASK] == 0x00)
+		return 6;
+
+	return 4;
+}
+
+qword *Chip8Processor::getPlane(byte plane) const
+{
+	return m_graphicsMemory + static_cast<size_t>(plane) * m_rowWords * m_displayHeight;
+}
+
+void Chip8Processor::setDisplayMode(DisplayMode mode)
+{
+	m_displayMode = mode;
+	m_displayWidth = static_cast<byte>(getDisplayModeWidth(mode));
+	m_displayHeight = static_cast<byte>(getDisplayModeHeight(mode));
+	m_rowWords = m_displayWidth / 64;
+
+	for (size_t i = 0; i < MAX_DISPLAY_WORDS * MAX_DISPLAY_PLANES; ++i)
+		m_graphicsMemory[i] = 0;
+
+	m_dirtyRegion.addAll(m_displayWidth, m_displayHeight);
+	drawFlag = 1;
+}
+
+// The handlers are instantiated for every profile, so the micro-benchmarks can time them directly
+#define INSTANTIATE_QUIRK_HANDLERS(Quirks) \
+	template void Chip8Processor::SHRvxvy<Quirks>(word opCode); \
+	template void Chip8Processor::SHLvxvy<Quirks>(word opCode); \
+	template void Chip8Processor::JPv0addr<Quirks>(word opCode); \
+	template void Chip8Processor::DRWvxvynibble<Quirks>(word opCode); \
+	template void Chip8Processor::LDivx<Quirks>(word opCode); \
+	template void Chip8Processor::LDvxi<Quirks>(word opCode);
+
+INSTANTIATE_QUIRK_HANDLERS(CosmacVipQuirks)
+INSTANTIATE_QUIRK_HANDLERS(Chip48Quirks)
+INSTANTIATE_QUIRK_HANDLERS(SuperChipQuirks)
+INSTANTIATE_QUIRK_HANDLERS(XoChipQuirks)
@@ -1,23 +1,50 @@
 #include "Chip8/Emulator/Renderer.hpp"
 #include "Chip8/Emulator/Window.hpp"
+#include "Chip8/Emulator/DirtyRegion.hpp"
+#include "Chip8/Emulator/DisplayMode.hpp"
+#include "Chip8/Emulator/Shader.hpp"
 #include "Chip8/Utility/DataTypes.hpp"
 
 #include "GL/gl3w.h"
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
 
+// The largest bit-packed display with all of its planes, which is also the size of one pixel buffer segment
+static const size_t FRAME_SIZE_BYTES = MAX_DISPLAY_WORDS * MAX_DISPLAY_PLANES * sizeof(qword);
+
 Renderer::Renderer()
+	: m_quadVAO(0)
+	, m_quadVBO(0)
+	, m_shader(0)
+	, m_texture(0)
+	, m_displayWidth(64)
+	, m_displayHeight(32)
+	, m_planeCount(1)
+	, m_uploadPath(UploadPath::SYNCHRONOUS)
+	, m_uploadStatistics()
+	, m_pixelBuffer(0)
+	, m_persistentMapping(false)
+	, m_mappedPixels(nullptr)
+	, m_segmentFences()
+	, m_segmentIndex(0)
 {
 }
 
 Renderer::~Renderer()
 {
-	glDeleteVertexArrays(1, &m_quadVAO);
-	glDeleteBuffers(1, &m_quadVBO);
+	// Nothing was created, the OpenGL functions may not even be loaded
+	if (m_shader == 0)
+		return;
+
+	deletePixelBuffers();
+	deleteScreenQuad(m_quadVAO, m_quadVBO);
+	glDeleteTextures(1, &m_texture);
 	glDeleteProgram(m_shader);
 }
 
-bool Renderer::initialize(const Window & window)
+bool Renderer::initialize(const Window & window, const char *shaderCachePath)
 {
 	// Set the framebuffer to cover the complete window
 	int width = 0;
@@ -27,16 +54,22 @@ bool Renderer::initialize(const Window & window)
 	glViewport(0, 0, width, height);
 	glClearColor(0.223f, 0.8f, 0.8f, 1.0f);	// This color is called "teal"
 	
-	if (!setupShaders())
+	if (!setupShaders(shaderCachePath))
 		return false;
 
 	// Set the texture index
 	glUseProgram(m_shader);
 	glUniform1i(glGetUniformLocation(m_shader, "textureID"), 0);
+	glUniform1i(glGetUniformLocation(m_shader, "planeCount"), m_planeCount);
 	glUseProgram(0);
 
+	// White pixels on a black background
+	const float ON_COLOR[3] = { 1.0f, 1.0f, 1.0f };
+	const float OFF_COLOR[3] = { 0.0f, 0.0f, 0.0f };
+	setPalette(ON_COLOR, OFF_COLOR);
+
 	setupTexture();
-	setupQuad();
+	createScreenQuad(m_quadVAO, m_quadVBO);
 
 	return true;
 }
@@ -60,123 +93,228 @@ void Renderer::draw() const
 	glUseProgram(0);
 }
 
-void Renderer::updatePixels(byte *graphicsMemory) const
+void Renderer::setDisplaySize(int width, int height, int planeCount)
 {
+	if (width == m_displayWidth && height == m_displayHeight && planeCount == m_planeCount)
+		return;
+
+	m_displayWidth = width;
+	m_displayHeight = height;
+	m_planeCount = planeCount;
+
+	// The shader derives the display size from the texture size and the number of planes stacked in it
 	glBindTexture(GL_TEXTURE_2D, m_texture);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 64, 32, GL_RED, GL_UNSIGNED_BYTE, graphicsMemory);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, m_displayWidth / 32, m_displayHeight * m_planeCount, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
 	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glUseProgram(m_shader);
+	glUniform1i(glGetUniformLocation(m_shader, "planeCount"), m_planeCount);
+	glUseProgram(0);
 }
 
-bool Renderer::setupShaders()
+size_t Renderer::updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion)
 {
-	const GLchar *const vertexShaderSourceCode =	"#version 330 core\n"
-													"layout(location = 0) in vec2 position;\n"
-													"layout(location = 1) in vec2 texCoord;\n"
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
 
-													"out vec2 uv;\n"
+	size_t uploadedBytes = 0;
 
-													"void main() {\n"
-														"uv = texCoord;\n"
-														"gl_Position = vec4(position, 0.0, 1.0);\n"
-													"}\0";
+	glBindTexture(GL_TEXTURE_2D, m_texture);
 
-	const GLchar *const fragmentShaderSourceCode =	"#version 330 core\n"
+	// Every 64-bit word of a row is two 32-bit texels, rectangles are read straight out of the full framebuffer by
+	// offsetting into it
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, m_displayWidth / 32);
 
-													"in vec2 uv;\n"
-													"out vec4 fragColor;\n"
+	if (m_uploadPath == UploadPath::STREAMING)
+	{
+		// With a pixel buffer bound the "pixels" argument is an offset into the buffer
+		size_t offset = streamFrame(graphicsMemory);
+		uploadRects(reinterpret_cast<const void *>(offset), dirtyRegion, uploadedBytes);
 
-													"uniform sampler2D textureID;\n"
+		// The segment can be reused once the GPU has consumed these uploads
+		if (m_persistentMapping)
+			m_segmentFences[m_segmentIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
-													"void main() {\n"
-														"float grayscaleValue = texture(textureID, vec2(uv.x, 1.0 - uv.y)).r * 255.0;\n"
-														"fragColor = vec4(grayscaleValue, grayscaleValue, grayscaleValue, 1.0);\n"
-													"}\0";
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_segmentIndex = (m_segmentIndex + 1) % PIXEL_BUFFER_SEGMENTS;
+	}
+	else
+		uploadRects(graphicsMemory, dirtyRegion, uploadedBytes);
+
+	// Restore the default unpack state
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-	GLint successFlag = 0;
+	++m_uploadStatistics.uploadCount;
+	m_uploadStatistics.cpuTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
 
-	// Create the vertex shader
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSourceCode, 0);
-	glCompileShader(vertexShader);
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &successFlag);
+	return uploadedBytes;
+}
 
-	if (successFlag == GL_FALSE)
+bool Renderer::setUploadPath(UploadPath path)
+{
+	if (path == UploadPath::STREAMING && m_pixelBuffer == 0 && !setupPixelBuffers())
 	{
-		GLint maxLength = 0;
-		glGetShaderiv(vertexShader, GL_INFO_LOG_LENGTH, &maxLength);
+		m_uploadPath = UploadPath::SYNCHRONOUS;
+		return false;
+	}
 
-		GLchar * log = new GLchar[maxLength];
-		glGetShaderInfoLog(vertexShader, maxLength, &maxLength, &log[0]);
+	m_uploadPath = path;
+	return true;
+}
 
-		printf("Failed to compile the vertex shader.\n");
-		printf("Error: %s.\n\n", log);
+UploadPath Renderer::getUploadPath() const
+{
+	return m_uploadPath;
+}
+
+bool Renderer::isPersistentlyMapped() const
+{
+	return m_persistentMapping;
+}
 
-		delete[] log;
+const UploadStatistics & Renderer::getUploadStatistics() const
+{
+	return m_uploadStatistics;
+}
 
-		glDeleteShader(vertexShader);
+void Renderer::resetUploadStatistics()
+{
+	m_uploadStatistics = UploadStatistics();
+}
 
-		return false;
-	}
+size_t Renderer::streamFrame(const qword *graphicsMemory)
+{
+	size_t offset = static_cast<size_t>(m_segmentIndex) * FRAME_SIZE_BYTES;
+	size_t frameSize = static_cast<size_t>(m_displayWidth / 64) * m_displayHeight * m_planeCount * sizeof(qword);
 
-	// Create the fragment shader
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSourceCode, 0);
-	glCompileShader(fragmentShader);
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &successFlag);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
 
-	if (successFlag == GL_FALSE)
+	if (m_persistentMapping)
 	{
-		GLint maxLength = 0;
-		glGetShaderiv(fragmentShader, GL_INFO_LOG_LENGTH, &maxLength);
+		// Wait until the GPU is done with the uploads that last used this segment
+		GLsync fence = m_segmentFences[m_segmentIndex];
+		if (fence != nullptr)
+		{
+			GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (result == GL_TIMEOUT_EXPIRED)
+			{
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+				while (result == GL_TIMEOUT_EXPIRED)
+					result = glClientWaitSync(fence, 0, 1000000);
+
+				++m_uploadStatistics.fenceWaitCount;
+				m_uploadStatistics.fenceWaitTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+			}
+
+			glDeleteSync(fence);
+			m_segmentFences[m_segmentIndex] = nullptr;
+		}
+
+		// The mapping is coherent, so a plain copy is visible to the next glTexSubImage2D
+		memcpy(m_mappedPixels + offset, graphicsMemory, frameSize);
+		return offset;
+	}
 
-		GLchar * log = new GLchar[maxLength];
-		glGetShaderInfoLog(fragmentShader, maxLength, &maxLength, &log[0]);
+	// Orphan the buffer, the driver hands out fresh storage while the GPU may still read the old one
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, FRAME_SIZE_BYTES * PIXEL_BUFFER_SEGMENTS, nullptr, GL_STREAM_DRAW);
 
-		printf("Failed to compile the fragment shader.\n");
-		printf("Error: %s.\n\n", log);
+	void *pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, frameSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (pixels != nullptr)
+	{
+		memcpy(pixels, graphicsMemory, frameSize);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
 
-		delete[] log;
+	return offset;
+}
 
-		glDeleteShader(fragmentShader);
+void Renderer::uploadRects(const void *source, const DirtyRegion & dirtyRegion, size_t & uploadedBytes) const
+{
+	for (int i = 0; i < dirtyRegion.getRectCount(); ++i)
+	{
+		const DirtyRect & rect = dirtyRegion.getRect(i);
 
-		return false;
-	}
+		// A texel holds 32 pixels, so the rectangle is widened to whole texels. On a little-endian machine the first
+		// texel of a word holds its low half, which is the right half of the word on screen, so the two texels of every
+		// word are swapped.
+		int firstHalf = rect.x / 32;
+		int lastHalf = (rect.x + rect.width - 1) / 32;
+		int firstTexel = firstHalf == lastHalf ? firstHalf ^ 1 : firstHalf & ~1;
+		int lastTexel = firstHalf == lastHalf ? lastHalf ^ 1 : lastHalf | 1;
+		int texelCount = lastTexel - firstTexel + 1;
 
-	// Create the shader program
-	m_shader = glCreateProgram();
-	glAttachShader(m_shader, vertexShader);
-	glAttachShader(m_shader, fragmentShader);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, firstTexel);
 
-	glLinkProgram(m_shader);
+		// The planes follow each other in the framebuffer and in the texture, the same rectangle is uploaded for each
+		for (int plane = 0; plane < m_planeCount; ++plane)
+		{
+			int y = plane * m_displayHeight + rect.y;
 
-	glDetachShader(m_shader, vertexShader);
-	glDetachShader(m_shader, fragmentShader);
+			glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, firstTexel, y, texelCount, rect.height, GL_RED_INTEGER, GL_UNSIGNED_INT, source);
+		}
 
-	// No need to keep the shaders around anymore
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+		uploadedBytes += static_cast<size_t>(texelCount) * rect.height * m_planeCount * sizeof(GLuint);
+	}
+}
 
-	glGetProgramiv(m_shader, GL_LINK_STATUS, &successFlag);
+void Renderer::setPalette(const float *onColor, const float *offColor) const
+{
+	setPaletteUniforms(m_shader, onColor, offColor);
+}
 
-	if (successFlag == GL_FALSE)
-	{
-		GLint maxLength = 0;
-		glGetProgramiv(m_shader, GL_INFO_LOG_LENGTH, &maxLength);
+bool Renderer::setupShaders(const char *cachePath)
+{
+	const GLchar *const vertexShaderSourceCode =	"#version 330 core\n"
+													"layout(location = 0) in vec2 position;\n"
+													"layout(location = 1) in vec2 texCoord;\n"
 
-		GLchar * log = new GLchar[maxLength];
-		glGetProgramInfoLog(m_shader, maxLength, &maxLength, &log[0]);
+													"out vec2 uv;\n"
+
+													"void main() {\n"
+														"uv = texCoord;\n"
+														"gl_Position = vec4(position, 0.0, 1.0);\n"
+													"}\0";
 
-		printf("Failed to link the program.\n");
-		printf("Error: %s.\n\n", log);
+	const GLchar *const fragmentShaderSourceCode =	"#version 330 core\n"
 
-		delete[] log;
+													"in vec2 uv;\n"
+													"out vec4 fragColor;\n"
 
-		glDeleteProgram(m_shader);
+													"uniform usampler2D textureID;\n"
+													"uniform vec3 onColor;\n"
+													"uniform vec3 offColor;\n"
+													"uniform int planeCount;\n"
 
-		return false;
-	}
+													"void main() {\n"
+														// Pixel coordinates on the display, row 0 is at the top. A texel holds 32 pixels, the planes are
+														// stacked vertically in the texture.
+														"ivec2 displaySize = textureSize(textureID, 0) * ivec2(32, 1) / ivec2(1, planeCount);\n"
+														"ivec2 pixel = min(ivec2(vec2(uv.x, 1.0 - uv.y) * vec2(displaySize)), displaySize - 1);\n"
+
+														// Bit 63 of a word is its leftmost pixel, the high half of the 64-bit word is the second texel
+														"uint bit = uint(63 - (pixel.x & 63));\n"
+														"ivec2 texelPosition = ivec2((pixel.x >> 6) * 2 + int(bit >> 5u), pixel.y);\n"
+
+														// Bit n of the color is the pixel in plane n
+														"uint color = 0u;\n"
+														"for (int plane = 0; plane < planeCount; ++plane) {\n"
+															"uint texel = texelFetch(textureID, texelPosition + ivec2(0, plane * displaySize.y), 0).r;\n"
+															"color |= ((texel >> (bit & 31u)) & 1u) << uint(plane);\n"
+														"}\n"
+
+														// The first plane uses the on color, the second plane and the overlap of both are shades in between
+														"const float SHADES[4] = float[4](0.0, 1.0, 1.0 / 3.0, 2.0 / 3.0);\n"
+														"float value = SHADES[color];\n"
+
+														"fragColor = vec4(mix(offColor, onColor, value), 1.0);\n"
+													"}\0";
 
-	return true;
+	return createShaderProgram(vertexShaderSourceCode, fragmentShaderSourceCode, m_shader, cachePath);
 }
 
 void Renderer::setupTexture()
@@ -187,38 +325,80 @@ void Renderer::setupTexture()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, 64, 32, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
+	// The display is bit-packed, every 64 pixels of a row are two 32-bit unsigned integer texels
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, m_displayWidth / 32, m_displayHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
 	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void Renderer::setupQuad()
+bool Renderer::setupPixelBuffers()
+{
+	const GLsizeiptr bufferSize = static_cast<GLsizeiptr>(FRAME_SIZE_BYTES * PIXEL_BUFFER_SEGMENTS);
+
+	glGenBuffers(1, &m_pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+
+	m_persistentMapping = gl3wIsSupported(4, 4) || isExtensionSupported("GL_ARB_buffer_storage");
+
+	if (m_persistentMapping)
+	{
+		// Map the buffer once and keep it mapped for the lifetime of the renderer
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, flags);
+		m_mappedPixels = static_cast<byte *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bufferSize, flags));
+
+		if (m_mappedPixels == nullptr)
+		{
+			printf("Failed to map the pixel buffer persistently, falling back to orphaning.\n");
+
+			// Immutable storage cannot be respecified, so start over with a regular buffer
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &m_pixelBuffer);
+			glGenBuffers(1, &m_pixelBuffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+			m_persistentMapping = false;
+		}
+	}
+
+	if (!m_persistentMapping)
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (glGetError() != GL_NO_ERROR)
+	{
+		printf("Failed to create the pixel buffer.\n");
+		deletePixelBuffers();
+		return false;
+	}
+
+	m_segmentIndex = 0;
+
+	return true;
+}
+
+void Renderer::deletePixelBuffers()
 {
-	GLfloat vertices[] =
+	if (m_pixelBuffer == 0)
+		return;
+
+	for (int i = 0; i < PIXEL_BUFFER_SEGMENTS; ++i)
 	{
-		// Position		// Texture coordinate
-		 1.0f,  1.0f,	1.0f, 1.0f,
-		-1.0f,  1.0f,	0.0f, 1.0f,
-		-1.0f, -1.0f,	0.0f, 0.0f,
+		if (m_segmentFences[i] != nullptr)
+			glDeleteSync(m_segmentFences[i]);
 
-		-1.0f, -1.0f,	0.0f, 0.0f,
-		 1.0f, -1.0f,	1.0f, 0.0f,
-		 1.0f,  1.0f,	1.0f, 1.0f
-	};
+		m_segmentFences[i] = nullptr;
+	}
 
-	glGenVertexArrays(1, &m_quadVAO);
-	glGenBuffers(1, &m_quadVBO);
+	if (m_mappedPixels != nullptr)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_mappedPixels = nullptr;
+	}
 
-	glBindVertexArray(m_quadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
-	
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 24, vertices, GL_STATIC_DRAW);
-	
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 4, (GLvoid *)(0));
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 4, (GLvoid *)(sizeof(GLfloat) * 2));
-	
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glDeleteBuffers(1, &m_pixelBuffer);
+	m_pixelBuffer = 0;
+	m_persistentMapping = false;
 }
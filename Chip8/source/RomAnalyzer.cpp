@@ -0,0 +1,253 @@
+#include "Chip8/Utility/RomAnalyzer.hpp"
+#include "Chip8/Utility/ControlFlowGraph.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/Hash.hpp"
+#include "Chip8/Utility/InstructionSet.hpp"
+
+#include <cstring>
+#include <iostream>
+
+// Programs are loaded after the 512 bytes reserved for the interpreter
+static const word ENTRY_POINT = 0x200;
+
+// Instructions inspected after Fx55 / Fx65 when looking for an access that depends on the new value of I
+static const int INDEX_LOOKAHEAD = 8;
+
+Chip8RomDatabase::Chip8RomDatabase()
+{
+}
+
+Chip8RomDatabase::~Chip8RomDatabase()
+{
+}
+
+bool Chip8RomDatabase::load(const char *path)
+{
+	FILE *filePtr = fopen(path, "r");
+
+	if (filePtr == nullptr)
+		return false;
+
+	char line[1024];
+	while (fgets(line, sizeof(line), filePtr) != nullptr)
+	{
+		if (line[0] == '#')
+			continue;
+
+		line[strcspn(line, "\r\n")] = '\0';
+
+		// The name is the last field and may contain spaces
+		char profileName[32];
+		char source[32];
+		int nameOffset = 0;
+
+		Chip8RomDatabaseEntry entry;
+		if (sscanf(line, "%llX\t%31[^\t]\t%i\t%31[^\t]\t%n", &entry.hash, profileName, &entry.cyclesPerFrame, source, &nameOffset) != 4 ||
+			nameOffset == 0 || !parseQuirkProfile(profileName, entry.quirkProfile))
+			continue;
+
+		entry.source = source;
+		entry.name = line + nameOffset;
+		add(entry);
+	}
+
+	fclose(filePtr);
+	return true;
+}
+
+bool Chip8RomDatabase::save(const char *path) const
+{
+	FILE *filePtr = fopen(path, "w");
+
+	if (filePtr == nullptr)
+		return false;
+
+	fprintf(filePtr, "# hash\tquirks\tcycles per frame\tsource\tname\n");
+
+	for (const auto & item : m_entries)
+	{
+		const Chip8RomDatabaseEntry & entry = item.second;
+		fprintf(filePtr, "%016llX\t%s\t%i\t%s\t%s\n", entry.hash, getQuirkProfileName(entry.quirkProfile), entry.cyclesPerFrame,
+			entry.source.c_str(), entry.name.c_str());
+	}
+
+	fclose(filePtr);
+	return true;
+}
+
+void Chip8RomDatabase::add(const Chip8RomDatabaseEntry & entry)
+{
+	m_entries[entry.hash] = entry;
+}
+
+const Chip8RomDatabaseEntry *Chip8RomDatabase::find(unsigned long long hash) const
+{
+	auto item = m_entries.find(hash);
+	return item != m_entries.end() ? &item->second : nullptr;
+}
+
+size_t Chip8RomDatabase::getEntryCount() const
+{
+	return m_entries.size();
+}
+
+unsigned long long Chip8RomAnalyzer::hashRom(const byte *rom, size_t size)
+{
+	return hashBytes(rom, size);
+}
+
+int Chip8RomAnalyzer::getRecommendedCyclesPerFrame(QuirkProfile profile)
+{
+	switch (profile)
+	{
+	case QuirkProfile::COSMAC_VIP:
+		return 10;
+
+	case QuirkProfile::CHIP48:
+		return 20;
+
+	case QuirkProfile::SUPER_CHIP:
+		return 30;
+
+	case QuirkProfile::XO_CHIP:
+		return 100;
+
+	default:
+		return 10;
+	}
+}
+
+static word fetchOpCode(const byte *rom, size_t size, word address)
+{
+	size_t offset = address - ENTRY_POINT;
+	return offset + 1 < size ? static_cast<word>(rom[offset] << 8 | rom[offset + 1]) : 0x0000;
+}
+
+enum class IndexUse
+{
+	NONE,			// I is reloaded, or not used within the straight line
+	INCREMENTED,	// Another Fx55 / Fx65 of the same kind continues where the previous one stopped
+	UNCHANGED		// The memory that was just stored / loaded is accessed again
+};
+
+// Follows the straight line after Fx55 / Fx65 until I is reloaded or used again
+static IndexUse findIndexUseAfterLoadStore(const byte *rom, size_t size, word address)
+{
+	Instruction kind = decodeInstructionId(fetchOpCode(rom, size, address));
+
+	for (int i = 0; i < INDEX_LOOKAHEAD; ++i)
+	{
+		address += 2;
+		if (address < ENTRY_POINT || static_cast<size_t>(address - ENTRY_POINT) + 1 >= size)
+			return IndexUse::NONE;
+
+		const InstructionDescriptor & descriptor = decodeInstruction(fetchOpCode(rom, size, address));
+
+		if (descriptor.instruction == Instruction::LDivx || descriptor.instruction == Instruction::LDvxi)
+			return descriptor.instruction == kind ? IndexUse::INCREMENTED : IndexUse::UNCHANGED;
+
+		// Reloads of I (Fx1E means the program advances I itself), and anything but a skip leaving the straight line
+		if (descriptor.flags & (InstructionFlags::SETS_INDEX | (InstructionFlags::ENDS_BLOCK & ~InstructionFlags::SKIP)))
+			return IndexUse::NONE;
+
+		// Sprites, BCD, audio patterns and register ranges are accessed at I
+		if (descriptor.flags & (InstructionFlags::READS_MEMORY | InstructionFlags::WRITES_MEMORY))
+			return IndexUse::UNCHANGED;
+	}
+
+	return IndexUse::NONE;
+}
+
+Chip8RomAnalysis Chip8RomAnalyzer::analyze(const byte *rom, size_t size, const Chip8RomDatabase *database)
+{
+	Chip8RomAnalysis analysis = {};
+	analysis.hash = hashRom(rom, size);
+
+	// Only the instructions on paths from the entry point are inspected, so sprite data is not mistaken for them
+	Chip8ControlFlowGraph controlFlowGraph;
+	controlFlowGraph.build(rom, size, ENTRY_POINT);
+
+	analysis.usesVipHires = fetchOpCode(rom, size, ENTRY_POINT) == 0x1260;
+	analysis.reachableBytes = controlFlowGraph.getCodeByteCount();
+
+	for (size_t offset = 0; offset + 1 < size; ++offset)
+	{
+		word address = static_cast<word>(ENTRY_POINT + offset);
+		if (!controlFlowGraph.isInstruction(address))
+			continue;
+
+		word opCode = fetchOpCode(rom, size, address);
+		byte x = (opCode & 0x0F00) >> 8;
+		byte y = (opCode & 0x00F0) >> 4;
+
+		const InstructionDescriptor & descriptor = decodeInstruction(opCode);
+
+		// The processor ignores x in 00Cn - 00FF, but 0nnn with x != 0 is a call into VIP machine code, not an extension
+		bool isMachineCodeCall = (opCode & 0xF000) == 0x0000 && (opCode & 0x0F00) != 0x0000;
+		unsigned int flags = isMachineCodeCall ? 0 : descriptor.flags;
+
+		if (flags & InstructionFlags::XO_CHIP)
+			analysis.usesXoChip = true;
+		else if (flags & InstructionFlags::SUPER_CHIP)
+			analysis.usesSuperChip = true;
+
+		switch (descriptor.instruction)
+		{
+		// Assemblers for the HP48 encode "SHR Vx" with y = 0, so only other registers count as shifting Vy
+		case Instruction::SHRvxvy:
+		case Instruction::SHLvxvy:
+			if (x != y && y != 0)
+				analysis.shiftsVy = true;
+			break;
+
+		case Instruction::JPv0addr:
+			analysis.jumpsWithOffset = true;
+			break;
+
+		case Instruction::LDivx:
+		case Instruction::LDvxi:
+			switch (findIndexUseAfterLoadStore(rom, size, address))
+			{
+			case IndexUse::INCREMENTED:
+				analysis.reliesOnIndexIncrement = true;
+				break;
+
+			case IndexUse::UNCHANGED:
+				analysis.reliesOnUnchangedIndex = true;
+				break;
+
+			default:
+				break;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// Newer instruction sets win, otherwise the quirks the program relies on decide. Plain CHIP-8 programs without any
+	// hints were most likely written for the COSMAC VIP.
+	if (analysis.usesXoChip)
+		analysis.quirkProfile = QuirkProfile::XO_CHIP;
+	else if (analysis.usesSuperChip)
+		analysis.quirkProfile = QuirkProfile::SUPER_CHIP;
+	else if (analysis.usesVipHires || analysis.shiftsVy || analysis.reliesOnIndexIncrement)
+		analysis.quirkProfile = QuirkProfile::COSMAC_VIP;
+	else if (analysis.reliesOnUnchangedIndex)
+		analysis.quirkProfile = QuirkProfile::SUPER_CHIP;
+	else
+		analysis.quirkProfile = QuirkProfile::COSMAC_VIP;
+
+	analysis.cyclesPerFrame = getRecommendedCyclesPerFrame(analysis.quirkProfile);
+
+	const Chip8RomDatabaseEntry *entry = database != nullptr ? database->find(analysis.hash) : nullptr;
+	if (entry != nullptr)
+	{
+		analysis.quirkProfile = entry->quirkProfile;
+		analysis.cyclesPerFrame = entry->cyclesPerFrame;
+		analysis.fromDatabase = true;
+	}
+
+	return analysis;
+}
@@ -0,0 +1,382 @@
+#include "Chip8/Utility/RomLibrary.hpp"
+#include "Chip8/Utility/BinaryBuffer.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/Hash.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Written at the start of the index, the version changes whenever the layout of the entries does
+static const char INDEX_MAGIC[4] = { 'C', '8', 'R', 'L' };
+static const unsigned int INDEX_VERSION = 1;
+
+Chip8RomMapping::Chip8RomMapping()
+	: m_data(nullptr)
+	, m_size(0)
+{
+}
+
+Chip8RomMapping::~Chip8RomMapping()
+{
+	close();
+}
+
+bool Chip8RomMapping::open(const char *path)
+{
+	close();
+
+#ifndef _WIN32
+	int fileDescriptor = ::open(path, O_RDONLY);
+	if (fileDescriptor < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(fileDescriptor, &status) != 0)
+	{
+		::close(fileDescriptor);
+		return false;
+	}
+
+	m_size = static_cast<size_t>(status.st_size);
+
+	// mmap refuses empty files, they are valid ROMs without any data
+	if (m_size > 0)
+	{
+		void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			::close(fileDescriptor);
+			m_size = 0;
+			return false;
+		}
+
+		m_data = static_cast<const byte *>(data);
+	}
+
+	// The mapping stays valid after the file is closed
+	::close(fileDescriptor);
+	return true;
+#else
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	m_data = m_buffer.empty() ? nullptr : m_buffer.data();
+	m_size = m_buffer.size();
+	return true;
+#endif
+}
+
+void Chip8RomMapping::close()
+{
+#ifndef _WIN32
+	if (m_data != nullptr)
+		munmap(const_cast<byte *>(m_data), m_size);
+#endif
+
+	m_buffer.clear();
+	m_data = nullptr;
+	m_size = 0;
+}
+
+const byte *Chip8RomMapping::getData() const
+{
+	return m_data;
+}
+
+size_t Chip8RomMapping::getSize() const
+{
+	return m_size;
+}
+
+static std::string trim(const std::string & text)
+{
+	size_t first = text.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos)
+		return std::string();
+
+	size_t last = text.find_last_not_of(" \t\r\n");
+	return text.substr(first, last - first + 1);
+}
+
+// "15 Puzzle [Roger Ivie] (alt)" is the title "15 Puzzle (alt)" by Roger Ivie, "Clock Program [Bill Fisher, 1981]" has a
+// year as well. Decades like "199x" are not stored as a year.
+static void parseFileName(const std::string & name, Chip8RomLibraryEntry & entry)
+{
+	size_t open = name.find('[');
+	size_t close = open != std::string::npos ? name.find(']', open) : std::string::npos;
+
+	if (close == std::string::npos)
+	{
+		entry.title = trim(name);
+		return;
+	}
+
+	std::string rest = trim(name.substr(close + 1));
+	entry.title = trim(name.substr(0, open)) + (rest.empty() ? "" : " " + rest);
+
+	std::string credits = name.substr(open + 1, close - open - 1);
+	size_t comma = credits.rfind(',');
+	std::string last = trim(comma != std::string::npos ? credits.substr(comma + 1) : credits);
+
+	bool isYear = last.size() == 4 && isdigit(static_cast<unsigned char>(last[0])) && isdigit(static_cast<unsigned char>(last[1])) &&
+		isdigit(static_cast<unsigned char>(last[2]));
+	if (isYear)
+	{
+		entry.year = isdigit(static_cast<unsigned char>(last[3])) ? atoi(last.c_str()) : 0;
+		entry.author = comma != std::string::npos ? trim(credits.substr(0, comma)) : std::string();
+	}
+	else
+	{
+		entry.author = trim(credits);
+	}
+}
+
+// The first line of the text that is not empty, it usually names the program and its author
+static std::string readDescription(const std::filesystem::path & path)
+{
+	std::ifstream file(path);
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		line = trim(line);
+		if (!line.empty())
+			return line;
+	}
+
+	return std::string();
+}
+
+static long long getModifiedTime(const std::filesystem::path & path)
+{
+	std::error_code error;
+	auto time = std::filesystem::last_write_time(path, error);
+	return error ? 0 : static_cast<long long>(time.time_since_epoch().count());
+}
+
+// "roms", "./roms" and "roms/" are the same directory
+static std::string normalizeDirectory(const char *directory)
+{
+	std::filesystem::path path = std::filesystem::path(directory).lexically_normal();
+	return (path.has_filename() ? path : path.parent_path()).generic_string();
+}
+
+Chip8RomLibrary::Chip8RomLibrary()
+{
+}
+
+Chip8RomLibrary::~Chip8RomLibrary()
+{
+}
+
+bool Chip8RomLibrary::open(const char *directory, const char *indexPath)
+{
+	if (loadIndex(indexPath) && m_directory == normalizeDirectory(directory))
+		return true;
+
+	if (!scan(directory))
+		return false;
+
+	// The library is still usable without an index, the next run scans again
+	if (!saveIndex(indexPath))
+		printf("Failed to write the ROM index %s.\n", indexPath);
+
+	return true;
+}
+
+bool Chip8RomLibrary::scan(const char *directory)
+{
+	m_directory = normalizeDirectory(directory);
+	m_entries.clear();
+	m_entriesByHash.clear();
+
+	std::vector<std::filesystem::path> paths;
+
+	std::error_code error;
+	for (const auto & item : std::filesystem::recursive_directory_iterator(directory, error))
+	{
+		if (item.is_regular_file() && item.path().extension() == ".ch8")
+			paths.push_back(item.path());
+	}
+
+	if (error)
+	{
+		printf("Failed to read %s: %s\n", directory, error.message().c_str());
+		return false;
+	}
+
+	// Sorted, so the same files always give the same index
+	std::sort(paths.begin(), paths.end());
+
+	Chip8RomMapping mapping;
+	for (const std::filesystem::path & path : paths)
+	{
+		if (!mapping.open(path.string().c_str()))
+		{
+			printf("Failed to open %s.\n", path.string().c_str());
+			continue;
+		}
+
+		Chip8RomLibraryEntry entry = {};
+		entry.hash = hashBytes(mapping.getData(), mapping.getSize());
+		entry.path = path.lexically_normal().lexically_relative(m_directory).generic_string();
+		entry.size = static_cast<long long>(mapping.getSize());
+		entry.modifiedTime = getModifiedTime(path);
+
+		parseFileName(path.stem().string(), entry);
+
+		std::filesystem::path metadataPath = path;
+		metadataPath.replace_extension(".txt");
+		if (std::filesystem::exists(metadataPath, error))
+			entry.description = readDescription(metadataPath);
+
+		addEntry(entry);
+	}
+
+	return true;
+}
+
+bool Chip8RomLibrary::loadIndex(const char *indexPath)
+{
+	std::ifstream file(indexPath, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	BinaryReader reader(buffer);
+
+	char magic[4];
+	unsigned int version;
+	unsigned int entryCount;
+	std::string directory;
+
+	if (!reader.read(magic) || memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 || !reader.read(version) ||
+		version != INDEX_VERSION || !reader.readString(directory) || !reader.read(entryCount))
+		return false;
+
+	// The count of a damaged index can be anything, so the entries grow as they are read instead of being allocated up front
+	std::vector<Chip8RomLibraryEntry> entries;
+	for (unsigned int i = 0; i < entryCount; ++i)
+	{
+		Chip8RomLibraryEntry entry;
+		if (!reader.read(entry.hash) || !reader.read(entry.size) || !reader.read(entry.modifiedTime) ||
+			!reader.read(entry.year) || !reader.readString(entry.path) || !reader.readString(entry.title) ||
+			!reader.readString(entry.author) || !reader.readString(entry.description))
+			return false;
+
+		entries.push_back(entry);
+	}
+
+	// Only replace the current entries once the whole index was read
+	m_directory = directory;
+	m_entries.clear();
+	m_entriesByHash.clear();
+
+	for (const Chip8RomLibraryEntry & entry : entries)
+		addEntry(entry);
+
+	return true;
+}
+
+bool Chip8RomLibrary::saveIndex(const char *indexPath) const
+{
+	std::string buffer;
+	buffer.append(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	appendBinary(buffer, INDEX_VERSION);
+	appendBinaryString(buffer, m_directory);
+	appendBinary(buffer, static_cast<unsigned int>(m_entries.size()));
+
+	for (const Chip8RomLibraryEntry & entry : m_entries)
+	{
+		appendBinary(buffer, entry.hash);
+		appendBinary(buffer, entry.size);
+		appendBinary(buffer, entry.modifiedTime);
+		appendBinary(buffer, entry.year);
+		appendBinaryString(buffer, entry.path);
+		appendBinaryString(buffer, entry.title);
+		appendBinaryString(buffer, entry.author);
+		appendBinaryString(buffer, entry.description);
+	}
+
+	FILE *filePtr = fopen(indexPath, "wb");
+
+	if (filePtr == nullptr)
+		return false;
+
+	bool success = fwrite(buffer.data(), 1, buffer.size(), filePtr) == buffer.size();
+	return fclose(filePtr) == 0 && success;
+}
+
+const std::vector<Chip8RomLibraryEntry> & Chip8RomLibrary::getEntries() const
+{
+	return m_entries;
+}
+
+const Chip8RomLibraryEntry *Chip8RomLibrary::find(unsigned long long hash) const
+{
+	auto item = m_entriesByHash.find(hash);
+	return item != m_entriesByHash.end() ? &m_entries[item->second] : nullptr;
+}
+
+std::string Chip8RomLibrary::getFullPath(const Chip8RomLibraryEntry & entry) const
+{
+	return (std::filesystem::path(m_directory) / entry.path).string();
+}
+
+bool Chip8RomLibrary::map(const Chip8RomLibraryEntry & entry, Chip8RomMapping & mapping) const
+{
+	std::string path = getFullPath(entry);
+
+	if (getModifiedTime(path) != entry.modifiedTime || !mapping.open(path.c_str()))
+		return false;
+
+	if (static_cast<long long>(mapping.getSize()) != entry.size)
+	{
+		mapping.close();
+		return false;
+	}
+
+	return true;
+}
+
+std::vector<std::string> Chip8RomLibrary::findRoms(const std::vector<std::string> & directories)
+{
+	std::vector<std::string> roms;
+
+	for (const std::string & directory : directories)
+	{
+		std::error_code error;
+		for (const auto & item : std::filesystem::recursive_directory_iterator(directory, error))
+		{
+			if (item.is_regular_file() && item.path().extension() == ".ch8")
+				roms.push_back(item.path().generic_string());
+		}
+
+		if (error)
+			fprintf(stderr, "Failed to read %s: %s\n", directory.c_str(), error.message().c_str());
+	}
+
+	std::sort(roms.begin(), roms.end());
+	return roms;
+}
+
+void Chip8RomLibrary::addEntry(const Chip8RomLibraryEntry & entry)
+{
+	m_entriesByHash.emplace(entry.hash, m_entries.size());
+	m_entries.push_back(entry);
+}
@@ -0,0 +1,96 @@
+#include "Chip8/Utility/RowShift.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIP8_HAS_SSE2 1
+#else
+#define CHIP8_HAS_SSE2 0
+#endif
+
+void shiftBitPackedRowsLeft(qword *rows, int rowWords, int rowCount, int pixels)
+{
+	if (pixels <= 0 || pixels >= 64)
+		return;
+
+	int y = 0;
+
+#if CHIP8_HAS_SSE2
+	__m128i count = _mm_cvtsi32_si128(pixels);
+	__m128i carryCount = _mm_cvtsi32_si128(64 - pixels);
+
+	if (rowWords == 1)
+	{
+		// Two single word rows per register, the words are independent
+		for (; y + 2 <= rowCount; y += 2)
+		{
+			__m128i *pair = reinterpret_cast<__m128i *>(rows + y);
+			_mm_storeu_si128(pair, _mm_sll_epi64(_mm_loadu_si128(pair), count));
+		}
+	}
+	else if (rowWords == 2)
+	{
+		// One row per register, the leftmost pixels of the right word move into the left word (the low lane)
+		for (; y < rowCount; ++y)
+		{
+			__m128i *row = reinterpret_cast<__m128i *>(rows + y * 2);
+			__m128i pixelsIn = _mm_loadu_si128(row);
+			__m128i carry = _mm_srli_si128(_mm_srl_epi64(pixelsIn, carryCount), 8);
+			_mm_storeu_si128(row, _mm_or_si128(_mm_sll_epi64(pixelsIn, count), carry));
+		}
+	}
+#endif
+
+	for (; y < rowCount; ++y)
+	{
+		qword *row = rows + y * rowWords;
+
+		for (int word = 0; word < rowWords - 1; ++word)
+			row[word] = (row[word] << pixels) | (row[word + 1] >> (64 - pixels));
+
+		row[rowWords - 1] <<= pixels;
+	}
+}
+
+void shiftBitPackedRowsRight(qword *rows, int rowWords, int rowCount, int pixels)
+{
+	if (pixels <= 0 || pixels >= 64)
+		return;
+
+	int y = 0;
+
+#if CHIP8_HAS_SSE2
+	__m128i count = _mm_cvtsi32_si128(pixels);
+	__m128i carryCount = _mm_cvtsi32_si128(64 - pixels);
+
+	if (rowWords == 1)
+	{
+		for (; y + 2 <= rowCount; y += 2)
+		{
+			__m128i *pair = reinterpret_cast<__m128i *>(rows + y);
+			_mm_storeu_si128(pair, _mm_srl_epi64(_mm_loadu_si128(pair), count));
+		}
+	}
+	else if (rowWords == 2)
+	{
+		// The rightmost pixels of the left word (the low lane) move into the right word
+		for (; y < rowCount; ++y)
+		{
+			__m128i *row = reinterpret_cast<__m128i *>(rows + y * 2);
+			__m128i pixelsIn = _mm_loadu_si128(row);
+			__m128i carry = _mm_slli_si128(_mm_sll_epi64(pixelsIn, carryCount), 8);
+			_mm_storeu_si128(row, _mm_or_si128(_mm_srl_epi64(pixelsIn, count), carry));
+		}
+	}
+#endif
+
+	for (; y < rowCount; ++y)
+	{
+		qword *row = rows + y * rowWords;
+
+		for (int word = rowWords - 1; word > 0; --word)
+			row[word] = (row[word] >> pixels) | (row[word - 1] << (64 - pixels));
+
+		row[0] >>= pixels;
+	}
+}
@@ -0,0 +1,114 @@
+#include "Chip8/Utility/Scaler.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIP8_HAS_SSE2 1
+#else
+#define CHIP8_HAS_SSE2 0
+#endif
+
+#if CHIP8_HAS_SSE2
+// Writes one scaled output line of a display row. Four pixels are expanded at a time: every lane receives the same
+// nibble and compares it against its own bit, which gives an all ones mask for the pixels that are set.
+static void scaleLine(const qword *row, int rowWords, int scale, unsigned int onColor, unsigned int offColor, unsigned int *line)
+{
+	const __m128i laneBits = _mm_set_epi32(1, 2, 4, 8);	// The leftmost pixel is the most significant bit
+	const __m128i onColors = _mm_set1_epi32(static_cast<int>(onColor));
+	const __m128i offColors = _mm_set1_epi32(static_cast<int>(offColor));
+
+	for (int word = 0; word < rowWords; ++word)
+	{
+		qword bits = row[word];
+
+		for (int shift = 60; shift >= 0; shift -= 4)
+		{
+			__m128i nibble = _mm_set1_epi32(static_cast<int>((bits >> shift) & 0xF));
+			__m128i mask = _mm_cmpeq_epi32(_mm_and_si128(nibble, laneBits), laneBits);
+			__m128i colors = _mm_or_si128(_mm_and_si128(mask, onColors), _mm_andnot_si128(mask, offColors));
+
+			if (scale == 1)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(line), colors);
+				line += 4;
+				continue;
+			}
+
+			if (scale == 2)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(line), _mm_unpacklo_epi32(colors, colors));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(line + 4), _mm_unpackhi_epi32(colors, colors));
+				line += 8;
+				continue;
+			}
+
+			const __m128i pixels[4] =
+			{
+				_mm_shuffle_epi32(colors, 0x00),
+				_mm_shuffle_epi32(colors, 0x55),
+				_mm_shuffle_epi32(colors, 0xAA),
+				_mm_shuffle_epi32(colors, 0xFF)
+			};
+
+			for (const __m128i & pixel : pixels)
+			{
+				// The last store of a pixel overlaps the previous one instead of falling back to single writes
+				if (scale >= 4)
+				{
+					for (int x = 0; x + 4 < scale; x += 4)
+						_mm_storeu_si128(reinterpret_cast<__m128i *>(line + x), pixel);
+
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(line + scale - 4), pixel);
+				}
+				else
+				{
+					unsigned int color = static_cast<unsigned int>(_mm_cvtsi128_si32(pixel));
+					for (int x = 0; x < scale; ++x)
+						line[x] = color;
+				}
+
+				line += scale;
+			}
+		}
+	}
+}
+#else
+// Writes one scaled output line of a display row
+static void scaleLine(const qword *row, int rowWords, int scale, unsigned int onColor, unsigned int offColor, unsigned int *line)
+{
+	for (int word = 0; word < rowWords; ++word)
+	{
+		qword bits = row[word];
+
+		for (int bit = 63; bit >= 0; --bit)
+		{
+			// Select the color without a branch, the pixels are essentially random
+			unsigned int mask = 0u - static_cast<unsigned int>((bits >> bit) & 1);
+			unsigned int color = (onColor & mask) | (offColor & ~mask);
+
+			for (int x = 0; x < scale; ++x)
+				line[x] = color;
+
+			line += scale;
+		}
+	}
+}
+#endif
+
+void scaleBitPackedRows(const qword *rows, int rowWords, int firstRow, int rowCount, int scale,
+	unsigned int onColor, unsigned int offColor, unsigned int *pixels, size_t pitch)
+{
+	const size_t lineBytes = static_cast<size_t>(rowWords) * 64 * scale * sizeof(unsigned int);
+
+	for (int y = firstRow; y < firstRow + rowCount; ++y)
+	{
+		unsigned int *firstLine = pixels + static_cast<size_t>(y) * scale * pitch;
+		scaleLine(rows + static_cast<size_t>(y) * rowWords, rowWords, scale, onColor, offColor, firstLine);
+
+		// Nearest neighbour scaling repeats the same line vertically
+		for (int i = 1; i < scale; ++i)
+			memcpy(firstLine + i * pitch, firstLine, lineBytes);
+	}
+}
@@ -0,0 +1,303 @@
+#include "Chip8/Emulator/Shader.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/Hash.hpp"
+
+#include "GL/gl3w.h"
+
+#include <cstring>
+#include <iostream>
+
+// Header of a program binary cache file, the binary itself follows directly after it
+struct ProgramCacheHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned long long key;
+	GLenum binaryFormat;
+	GLint binaryLength;
+};
+
+static const char PROGRAM_CACHE_MAGIC[4] = { 'C', '8', 'P', 'B' };
+static const unsigned int PROGRAM_CACHE_VERSION = 1;
+
+static bool isProgramBinarySupported()
+{
+	if (!gl3wIsSupported(4, 1) && !isExtensionSupported("GL_ARB_get_program_binary"))
+		return false;
+
+	// Some drivers expose the functions without supporting a single binary format
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+// Binaries are only valid for the exact driver that produced them and the exact source code they were compiled from
+static unsigned long long getProgramCacheKey(const GLchar *vertexSourceCode, const GLchar *fragmentSourceCode)
+{
+	const GLenum DRIVER_STRINGS[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+
+	unsigned long long key = hashBytes(&PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION));
+
+	for (GLenum name : DRIVER_STRINGS)
+	{
+		const char *value = reinterpret_cast<const char *>(glGetString(name));
+		if (value != nullptr)
+			key = hashBytes(value, strlen(value) + 1, key);
+	}
+
+	key = hashBytes(vertexSourceCode, strlen(vertexSourceCode) + 1, key);
+	key = hashBytes(fragmentSourceCode, strlen(fragmentSourceCode) + 1, key);
+
+	return key;
+}
+
+static bool loadProgramBinary(const char *cachePath, unsigned long long key, GLuint & programStorage)
+{
+	FILE *filePtr = fopen(cachePath, "rb");
+
+	if (filePtr == nullptr)
+		return false;
+
+	ProgramCacheHeader header;
+	if (fread(&header, sizeof(header), 1, filePtr) != 1 ||
+		memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC)) != 0 ||
+		header.version != PROGRAM_CACHE_VERSION || header.key != key || header.binaryLength <= 0)
+	{
+		fclose(filePtr);
+		return false;
+	}
+
+	byte *binary = new byte[header.binaryLength];
+	bool readSuccess = fread(binary, 1, header.binaryLength, filePtr) == static_cast<size_t>(header.binaryLength);
+
+	fclose(filePtr);
+
+	if (!readSuccess)
+	{
+		delete[] binary;
+		return false;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.binaryFormat, binary, header.binaryLength);
+
+	delete[] binary;
+
+	// The driver is free to reject a binary, for example after an update that kept the version string
+	GLint successFlag = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &successFlag);
+
+	if (successFlag == GL_FALSE)
+	{
+		glDeleteProgram(program);
+		return false;
+	}
+
+	programStorage = program;
+
+	return true;
+}
+
+static void saveProgramBinary(const char *cachePath, unsigned long long key, GLuint program)
+{
+	GLint binaryLength = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+
+	if (binaryLength <= 0)
+		return;
+
+	ProgramCacheHeader header;
+	memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.binaryFormat = 0;
+	header.binaryLength = 0;
+
+	byte *binary = new byte[binaryLength];
+	glGetProgramBinary(program, binaryLength, &header.binaryLength, &header.binaryFormat, binary);
+
+	FILE *filePtr = fopen(cachePath, "wb");
+
+	if (filePtr == nullptr)
+	{
+		printf("Failed to write the shader cache %s.\n", cachePath);
+		delete[] binary;
+		return;
+	}
+
+	fwrite(&header, sizeof(header), 1, filePtr);
+	fwrite(binary, 1, header.binaryLength, filePtr);
+	fclose(filePtr);
+
+	delete[] binary;
+}
+
+static GLuint compileShader(GLenum type, const GLchar *sourceCode, const char *name)
+{
+	GLint successFlag = 0;
+
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &sourceCode, 0);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &successFlag);
+
+	if (successFlag == GL_FALSE)
+	{
+		GLint maxLength = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &maxLength);
+
+		GLchar * log = new GLchar[maxLength];
+		glGetShaderInfoLog(shader, maxLength, &maxLength, &log[0]);
+
+		printf("Failed to compile the %s shader.\n", name);
+		printf("Error: %s.\n\n", log);
+
+		delete[] log;
+
+		glDeleteShader(shader);
+
+		return 0;
+	}
+
+	return shader;
+}
+
+bool createShaderProgram(const GLchar *vertexSourceCode, const GLchar *fragmentSourceCode, GLuint & programStorage,
+	const char *cachePath)
+{
+	GLint successFlag = 0;
+
+	// Try the cached binary first, anything that does not match falls through to a regular compile
+	bool useCache = cachePath != nullptr && isProgramBinarySupported();
+	unsigned long long cacheKey = 0;
+
+	if (useCache)
+	{
+		cacheKey = getProgramCacheKey(vertexSourceCode, fragmentSourceCode);
+
+		if (loadProgramBinary(cachePath, cacheKey, programStorage))
+			return true;
+	}
+
+	// Create the vertex shader
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSourceCode, "vertex");
+	if (vertexShader == 0)
+		return false;
+
+	// Create the fragment shader
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSourceCode, "fragment");
+	if (fragmentShader == 0)
+	{
+		glDeleteShader(vertexShader);
+		return false;
+	}
+
+	// Create the shader program
+	GLuint program = glCreateProgram();
+
+	if (useCache)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+
+	glLinkProgram(program);
+
+	glDetachShader(program, vertexShader);
+	glDetachShader(program, fragmentShader);
+
+	// No need to keep the shaders around anymore
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &successFlag);
+
+	if (successFlag == GL_FALSE)
+	{
+		GLint maxLength = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+
+		GLchar * log = new GLchar[maxLength];
+		glGetProgramInfoLog(program, maxLength, &maxLength, &log[0]);
+
+		printf("Failed to link the program.\n");
+		printf("Error: %s.\n\n", log);
+
+		delete[] log;
+
+		glDeleteProgram(program);
+
+		return false;
+	}
+
+	if (useCache)
+		saveProgramBinary(cachePath, cacheKey, program);
+
+	programStorage = program;
+
+	return true;
+}
+
+bool isExtensionSupported(const char *name)
+{
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+	for (GLint i = 0; i < extensionCount; ++i)
+	{
+		const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+		if (extension != nullptr && strcmp(extension, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+void createScreenQuad(GLuint & vertexArrayStorage, GLuint & vertexBufferStorage)
+{
+	GLfloat vertices[] =
+	{
+		// Position		// Texture coordinate
+		 1.0f,  1.0f,	1.0f, 1.0f,
+		-1.0f,  1.0f,	0.0f, 1.0f,
+		-1.0f, -1.0f,	0.0f, 0.0f,
+
+		-1.0f, -1.0f,	0.0f, 0.0f,
+		 1.0f, -1.0f,	1.0f, 0.0f,
+		 1.0f,  1.0f,	1.0f, 1.0f
+	};
+
+	glGenVertexArrays(1, &vertexArrayStorage);
+	glGenBuffers(1, &vertexBufferStorage);
+
+	glBindVertexArray(vertexArrayStorage);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferStorage);
+
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 4, (GLvoid *)(0));
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 4, (GLvoid *)(sizeof(GLfloat) * 2));
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void deleteScreenQuad(GLuint & vertexArray, GLuint & vertexBuffer)
+{
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteBuffers(1, &vertexBuffer);
+
+	vertexArray = 0;
+	vertexBuffer = 0;
+}
+
+void setPaletteUniforms(GLuint program, const float *onColor, const float *offColor)
+{
+	glUseProgram(program);
+	glUniform3fv(glGetUniformLocation(program, "onColor"), 1, onColor);
+	glUniform3fv(glGetUniformLocation(program, "offColor"), 1, offColor);
+	glUseProgram(0);
+}
@@ -0,0 +1,168 @@
+#include "Chip8/Emulator/SnapshotCache.hpp"
+#include "Chip8/Emulator/HeadlessRunner.hpp"
+#include "Chip8/Emulator/Processor.hpp"
+#include "Chip8/Emulator/Quirks.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/Hash.hpp"
+
+#include <filesystem>
+#include <iostream>
+
+// Programs are loaded at 0x200
+static const word ENTRY_POINT = 0x200;
+
+// Snapshots are mostly the 64 KB of memory, so they are read with a single call
+static bool readFile(const std::string & path, std::string & data)
+{
+	FILE *filePtr = fopen(path.c_str(), "rb");
+	if (filePtr == nullptr)
+		return false;
+
+	fseek(filePtr, 0, SEEK_END);
+	long size = ftell(filePtr);
+	fseek(filePtr, 0, SEEK_SET);
+
+	data.resize(size > 0 ? static_cast<size_t>(size) : 0);
+	bool success = size >= 0 && fread(&data[0], 1, data.size(), filePtr) == data.size();
+	fclose(filePtr);
+
+	return success;
+}
+
+// Snapshots are written under a temporary name first, so a process that builds the same snapshot at the same time
+// never reads one that is half written
+static bool writeFile(const std::string & path, const std::string & data)
+{
+	std::string temporaryPath = path + ".tmp";
+
+	FILE *filePtr = fopen(temporaryPath.c_str(), "wb");
+	if (filePtr == nullptr)
+		return false;
+
+	bool success = fwrite(data.data(), 1, data.size(), filePtr) == data.size();
+	success = fclose(filePtr) == 0 && success;
+
+	std::error_code error;
+	if (success)
+		std::filesystem::rename(temporaryPath, path, error);
+	else
+		std::filesystem::remove(temporaryPath, error);
+
+	return success && !error;
+}
+
+SnapshotCache::SnapshotCache()
+	: m_hitCount(0)
+	, m_buildCount(0)
+{
+}
+
+SnapshotCache::~SnapshotCache()
+{
+}
+
+bool SnapshotCache::open(const char *directory)
+{
+	m_directory = directory;
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+	if (error)
+	{
+		printf("Failed to create %s: %s\n", directory, error.message().c_str());
+		return false;
+	}
+
+	// Snapshots of other core versions would never be loaded again
+	std::string currentVersion = "-v" + std::to_string(Chip8Processor::CORE_VERSION) + ".state";
+
+	for (const auto & item : std::filesystem::directory_iterator(m_directory, error))
+	{
+		std::string name = item.path().filename().string();
+		bool isSnapshot = item.path().extension() == ".state";
+		bool isCurrent = name.size() >= currentVersion.size() && name.compare(name.size() - currentVersion.size(), std::string::npos, currentVersion) == 0;
+
+		if (isSnapshot && !isCurrent)
+		{
+			std::error_code removeError;
+			std::filesystem::remove(item.path(), removeError);
+		}
+	}
+
+	return true;
+}
+
+bool SnapshotCache::warmStart(HeadlessRunner & runner, SnapshotCheckpoint checkpoint, long frames)
+{
+	if (runner.getFrameCount() != 0)
+		return false;
+
+	std::string path = getSnapshotPath(runner, checkpoint, frames);
+	std::string state;
+
+	// A snapshot that cannot be loaded, e.g. because it is damaged, is replaced
+	if (readFile(path, state) && runner.loadState(state))
+	{
+		++m_hitCount;
+		return true;
+	}
+
+	if (!buildSnapshot(runner, checkpoint, frames, state) || !runner.loadState(state))
+		return false;
+
+	++m_buildCount;
+
+	// The runner is at the checkpoint even when the snapshot cannot be stored
+	if (!writeFile(path, state))
+		printf("Failed to write the snapshot %s.\n", path.c_str());
+
+	return true;
+}
+
+long SnapshotCache::getHitCount() const
+{
+	return m_hitCount;
+}
+
+long SnapshotCache::getBuildCount() const
+{
+	return m_buildCount;
+}
+
+std::string SnapshotCache::getSnapshotPath(const HeadlessRunner & runner, SnapshotCheckpoint checkpoint, long frames) const
+{
+	const Chip8Processor & processor = runner.getProcessor();
+	unsigned long long hash = hashBytes(processor.getMemoryStart() + ENTRY_POINT, processor.getApplicationSize());
+
+	char name[128];
+	snprintf(name, sizeof(name), "%016llX-%s-%i-%u-%s%li-v%u.state", hash, getQuirkProfileName(processor.getQuirkProfile()),
+		runner.getCyclesPerFrame(), runner.getSeed(), checkpoint == SnapshotCheckpoint::FIRST_KEY_POLL ? "poll" : "frame", frames,
+		Chip8Processor::CORE_VERSION);
+
+	return (std::filesystem::path(m_directory) / name).string();
+}
+
+bool SnapshotCache::buildSnapshot(const HeadlessRunner & runner, SnapshotCheckpoint checkpoint, long frames, std::string & state) const
+{
+	const Chip8Processor & processor = runner.getProcessor();
+
+	// Built without input, the runner that loads the snapshot replays its own
+	HeadlessRunner builder;
+	if (!builder.loadGame(processor.getMemoryStart() + ENTRY_POINT, processor.getApplicationSize()))
+		return false;
+
+	builder.setQuirkProfile(processor.getQuirkProfile());
+	builder.setCyclesPerFrame(runner.getCyclesPerFrame());
+	builder.setSeed(runner.getSeed());
+
+	if (checkpoint == SnapshotCheckpoint::FIRST_KEY_POLL)
+		builder.runUntilKeyPoll(frames);
+	else
+	{
+		while (builder.getFrameCount() < frames)
+			builder.runFrame();
+	}
+
+	builder.saveState(state);
+	return true;
+}
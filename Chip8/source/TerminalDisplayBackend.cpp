@@ -0,0 +1,360 @@
+#include "Chip8/Emulator/TerminalDisplayBackend.hpp"
+#include "Chip8/Emulator/DirtyRegion.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <termios.h>
+#include <unistd.h>
+#define CHIP8_HAS_TERMIOS 1
+#else
+#define CHIP8_HAS_TERMIOS 0
+#endif
+
+// No glyph has this value, so cells marked with it are redrawn
+static const word INVALID_CELL = 0xFFFF;
+
+// How long a typed key is reported as held down
+static const std::chrono::milliseconds KEY_HOLD_TIME(150);
+
+#if CHIP8_HAS_TERMIOS
+static struct termios originalTerminalSettings;
+#endif
+
+TerminalDisplayBackend::TerminalDisplayBackend()
+	: m_cellType(TerminalCells::BRAILLE)
+	, m_displayWidth(64)
+	, m_displayHeight(32)
+	, m_planeCount(1)
+	, m_columns(0)
+	, m_rows(0)
+	, m_cellWidth(1)
+	, m_cellHeight(1)
+	, m_created(false)
+	, m_closeRequested(false)
+	, m_cells(nullptr)
+	, m_totalBytesWritten(0)
+{
+	memset(m_frame, 0, sizeof(m_frame));
+	memset(m_hexKeyPad, 0, sizeof(m_hexKeyPad));
+}
+
+TerminalDisplayBackend::~TerminalDisplayBackend()
+{
+	destroy();
+}
+
+bool TerminalDisplayBackend::create(TerminalCells cells)
+{
+	m_cellType = cells;
+	m_cellWidth = cells == TerminalCells::BRAILLE ? 2 : 1;
+	m_cellHeight = cells == TerminalCells::BRAILLE ? 4 : 2;
+	resetCells();
+
+#if CHIP8_HAS_TERMIOS
+	// Read keys one at a time without echo. VMIN = VTIME = 0 makes reads return immediately, O_NONBLOCK is avoided because
+	// stdin and stdout usually share the terminal, and it would make writes of large frames fail.
+	if (isatty(STDIN_FILENO))
+	{
+		tcgetattr(STDIN_FILENO, &originalTerminalSettings);
+
+		struct termios rawSettings = originalTerminalSettings;
+		rawSettings.c_lflag &= ~(ICANON | ECHO);
+		rawSettings.c_cc[VMIN] = 0;
+		rawSettings.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSANOW, &rawSettings);
+	}
+#endif
+
+	m_created = true;
+
+	// Clear the screen and hide the cursor, the default palette also sets the colors
+	m_output = "\x1b[2J\x1b[?25l";
+
+	// White pixels on a black background
+	const float ON_COLOR[3] = { 1.0f, 1.0f, 1.0f };
+	const float OFF_COLOR[3] = { 0.0f, 0.0f, 0.0f };
+	setPalette(ON_COLOR, OFF_COLOR);
+
+	writeOutput();
+
+	return true;
+}
+
+void TerminalDisplayBackend::destroy()
+{
+	if (!m_created)
+		return;
+
+	// Reset the colors, show the cursor again, and continue below the display
+	char restore[64];
+	snprintf(restore, sizeof(restore), "\x1b[0m\x1b[?25h\x1b[%i;1H\n", m_rows + 1);
+	m_output = restore;
+	writeOutput();
+
+#if CHIP8_HAS_TERMIOS
+	if (isatty(STDIN_FILENO))
+		tcsetattr(STDIN_FILENO, TCSANOW, &originalTerminalSettings);
+#endif
+
+	delete[] m_cells;
+	m_cells = nullptr;
+	m_created = false;
+}
+
+void TerminalDisplayBackend::setDisplaySize(int width, int height, int planeCount)
+{
+	m_planeCount = planeCount;
+
+	if (width == m_displayWidth && height == m_displayHeight)
+		return;
+
+	m_displayWidth = width;
+	m_displayHeight = height;
+	memset(m_frame, 0, sizeof(m_frame));
+
+	// Cells of the old size may be left outside of the new display, clearing fills them with the background color
+	m_output += "\x1b[2J";
+	resetCells();
+}
+
+size_t TerminalDisplayBackend::updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion)
+{
+	if (dirtyRegion.isEmpty())
+		return 0;
+
+	size_t planeWords = static_cast<size_t>(m_displayWidth / 64) * m_displayHeight;
+	memcpy(m_frame, graphicsMemory, planeWords * sizeof(qword));
+
+	for (int plane = 1; plane < m_planeCount; ++plane)
+	{
+		for (size_t i = 0; i < planeWords; ++i)
+			m_frame[i] |= graphicsMemory[plane * planeWords + i];
+	}
+
+	size_t previousSize = m_output.size();
+
+	// Column of the cursor after the last written cell, writing the next cell on the same row needs no cursor movement
+	int cursorRow = -1;
+	int cursorColumn = -1;
+
+	for (int i = 0; i < dirtyRegion.getRectCount(); ++i)
+	{
+		const DirtyRect & rect = dirtyRegion.getRect(i);
+
+		int firstRow = rect.y / m_cellHeight;
+		int lastRow = (rect.y + rect.height - 1) / m_cellHeight;
+		int firstColumn = rect.x / m_cellWidth;
+		int lastColumn = (rect.x + rect.width - 1) / m_cellWidth;
+
+		for (int row = firstRow; row <= lastRow; ++row)
+		{
+			for (int column = firstColumn; column <= lastColumn; ++column)
+			{
+				word cell = getCell(column, row);
+				word & shownCell = m_cells[row * m_columns + column];
+
+				if (cell == shownCell)
+					continue;
+
+				shownCell = cell;
+
+				if (row != cursorRow || column != cursorColumn)
+				{
+					char move[32];
+					snprintf(move, sizeof(move), "\x1b[%i;%iH", row + 1, column + 1);
+					m_output += move;
+				}
+
+				appendCell(cell);
+
+				cursorRow = row;
+				cursorColumn = column + 1;
+			}
+		}
+	}
+
+	return m_output.size() - previousSize;
+}
+
+void TerminalDisplayBackend::present()
+{
+	writeOutput();
+}
+
+void TerminalDisplayBackend::pollEvents()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < 16; ++i)
+	{
+		if (m_hexKeyPad[i] != 0 && now >= m_keyReleaseTimes[i])
+			m_hexKeyPad[i] = 0;
+	}
+
+#if CHIP8_HAS_TERMIOS
+	char keys[32];
+	ssize_t count = read(STDIN_FILENO, keys, sizeof(keys));
+
+	for (ssize_t i = 0; i < count; ++i)
+	{
+		// Same layout as the GLFW window: 1234 / QWER / ASDF / ZXCV, escape quits
+		static const char LAYOUT[17] = "x123qweasdzc4rfv";
+		const char *found = strchr(LAYOUT, tolower(static_cast<unsigned char>(keys[i])));
+
+		if (keys[i] == 0x1B)
+			m_closeRequested = true;
+		else if (keys[i] != '\0' && found != nullptr)
+		{
+			int key = static_cast<int>(found - LAYOUT);
+			m_hexKeyPad[key] = 1;
+			m_keyReleaseTimes[key] = now + KEY_HOLD_TIME;
+		}
+	}
+#endif
+}
+
+bool TerminalDisplayBackend::shouldClose() const
+{
+	return m_closeRequested;
+}
+
+const byte *TerminalDisplayBackend::getHexKeyPad() const
+{
+	return m_hexKeyPad;
+}
+
+int TerminalDisplayBackend::getRefreshRate() const
+{
+	// Terminals over ssh do not benefit from more updates than the emulated frame rate
+	return 60;
+}
+
+void TerminalDisplayBackend::setVerticalSync(bool)
+{
+}
+
+void TerminalDisplayBackend::setPalette(const float *onColor, const float *offColor)
+{
+	int on[3];
+	int off[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		on[i] = static_cast<int>(std::max(0.0f, std::min(1.0f, onColor[i])) * 255.0f + 0.5f);
+		off[i] = static_cast<int>(std::max(0.0f, std::min(1.0f, offColor[i])) * 255.0f + 0.5f);
+	}
+
+	// Glyphs are drawn in the "on" color on an "off" background, so colors are set once instead of per cell
+	char colors[64];
+	snprintf(colors, sizeof(colors), "\x1b[38;2;%i;%i;%im\x1b[48;2;%i;%i;%im", on[0], on[1], on[2], off[0], off[1], off[2]);
+	m_output += colors;
+
+	// Every cell has to be drawn again in the new colors
+	for (int i = 0; i < m_columns * m_rows; ++i)
+		m_cells[i] = INVALID_CELL;
+
+	DirtyRegion everything;
+	everything.addAll(static_cast<byte>(m_displayWidth), static_cast<byte>(m_displayHeight));
+	qword frame[MAX_DISPLAY_WORDS];
+	memcpy(frame, m_frame, sizeof(frame));
+	updatePixels(frame, everything);
+}
+
+const char *TerminalDisplayBackend::getName() const
+{
+	return m_cellType == TerminalCells::BRAILLE ? "terminal (braille)" : "terminal (half blocks)";
+}
+
+size_t TerminalDisplayBackend::getTotalBytesWritten() const
+{
+	return m_totalBytesWritten;
+}
+
+word TerminalDisplayBackend::getCell(int column, int row) const
+{
+	int x = column * m_cellWidth;
+	int y = row * m_cellHeight;
+
+	// Pixel (x, y) of the display
+	const int rowWords = m_displayWidth / 64;
+	auto pixel = [this, rowWords](int x, int y) -> word
+	{
+		return static_cast<word>((m_frame[y * rowWords + x / 64] >> (63 - x % 64)) & 1);
+	};
+
+	if (m_cellType == TerminalCells::HALF_BLOCKS)
+		return pixel(x, y) | (pixel(x, y + 1) << 1);
+
+	// Braille dots are numbered down the left column first, the bottom row was added later and comes last
+	return pixel(x, y) | (pixel(x, y + 1) << 1) | (pixel(x, y + 2) << 2) |
+		(pixel(x + 1, y) << 3) | (pixel(x + 1, y + 1) << 4) | (pixel(x + 1, y + 2) << 5) |
+		(pixel(x, y + 3) << 6) | (pixel(x + 1, y + 3) << 7);
+}
+
+void TerminalDisplayBackend::appendCell(word cell)
+{
+	unsigned int codePoint = 0;
+
+	if (m_cellType == TerminalCells::HALF_BLOCKS)
+	{
+		// Space, upper half block, lower half block, full block
+		const unsigned int HALF_BLOCKS[4] = { 0x20, 0x2580, 0x2584, 0x2588 };
+		codePoint = HALF_BLOCKS[cell & 3];
+	}
+	else
+		codePoint = 0x2800 + cell;
+
+	if (codePoint < 0x80)
+	{
+		m_output += static_cast<char>(codePoint);
+		return;
+	}
+
+	// All other glyphs are three byte UTF-8 sequences
+	m_output += static_cast<char>(0xE0 | (codePoint >> 12));
+	m_output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+	m_output += static_cast<char>(0x80 | (codePoint & 0x3F));
+}
+
+void TerminalDisplayBackend::writeOutput()
+{
+	if (m_output.empty())
+		return;
+
+	// Messages printed by the emulator must not end up in the middle of a frame
+	fflush(stdout);
+
+#if CHIP8_HAS_TERMIOS
+	// One system call per frame, partial writes only happen when the terminal cannot keep up
+	size_t written = 0;
+	while (written < m_output.size())
+	{
+		ssize_t result = write(STDOUT_FILENO, m_output.data() + written, m_output.size() - written);
+		if (result <= 0)
+			break;
+
+		written += static_cast<size_t>(result);
+	}
+#else
+	fwrite(m_output.data(), 1, m_output.size(), stdout);
+	fflush(stdout);
+#endif
+
+	m_totalBytesWritten += m_output.size();
+	m_output.clear();
+}
+
+void TerminalDisplayBackend::resetCells()
+{
+	m_columns = m_displayWidth / m_cellWidth;
+	m_rows = m_displayHeight / m_cellHeight;
+
+	delete[] m_cells;
+	m_cells = new word[m_columns * m_rows];
+	for (int i = 0; i < m_columns * m_rows; ++i)
+		m_cells[i] = INVALID_CELL;
+}
@@ -74,6 +74,11 @@ void Window::quit() const
 	glfwSetWindowShouldClose(m_windowHandle, GLFW_TRUE);
 }
 
+bool Window::shouldClose() const
+{
+	return glfwWindowShouldClose(m_windowHandle) == GLFW_TRUE;
+}
+
 void Window::pollKeyboard() const
 {
 	glfwPollEvents();
@@ -84,6 +89,11 @@ void Window::display() const
 	glfwSwapBuffers(m_windowHandle);
 }
 
+void Window::setVerticalSync(bool enabled) const
+{
+	glfwSwapInterval(enabled ? 1 : 0);
+}
+
 int Window::getWidth() const
 {
 	return m_windowWidth;
@@ -94,6 +104,17 @@ int Window::getHeight() const
 	return m_windowHeight;
 }
 
+int Window::getRefreshRate() const
+{
+	const GLFWvidmode *videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+
+	// Assume a regular 60Hz display when the monitor cannot be queried
+	if (videoMode == nullptr || videoMode->refreshRate <= 0)
+		return 60;
+
+	return videoMode->refreshRate;
+}
+
 void Window::getFramebufferDimensions(int & widthStorage, int & heightStorage) const
 {
 	glfwGetFramebufferSize(m_windowHandle, &widthStorage, &heightStorage);
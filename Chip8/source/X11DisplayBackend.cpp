@@ -0,0 +1,491 @@
+#include "Chip8/Emulator/X11DisplayBackend.hpp"
+#include "Chip8/Emulator/DirtyRegion.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/Scaler.hpp"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XShm.h>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Resolution the window is created for
+static const int DISPLAY_WIDTH = 64;
+static const int DISPLAY_HEIGHT = 32;
+
+struct X11DisplayBackend::X11State
+{
+	Display *display;
+	Window window;
+	GC graphicsContext;
+	Atom deleteWindowAtom;
+	Visual *visual;
+
+	XImage *image;
+	XShmSegmentInfo segment;
+	bool sharedMemory;
+	int completionEvent;
+	bool putPending;
+};
+
+// XShmAttach fails asynchronously on remote displays, the error handler records that instead of exiting
+static bool attachFailed = false;
+
+static int attachErrorHandler(Display *, XErrorEvent *)
+{
+	attachFailed = true;
+	return 0;
+}
+
+static int maskShift(unsigned long mask)
+{
+	int shift = 0;
+	while (mask != 0 && (mask & 1) == 0)
+	{
+		mask >>= 1;
+		++shift;
+	}
+
+	return shift;
+}
+
+X11DisplayBackend::X11DisplayBackend()
+	: m_state(nullptr)
+	, m_closeRequested(false)
+	, m_displayWidth(DISPLAY_WIDTH)
+	, m_displayHeight(DISPLAY_HEIGHT)
+	, m_planeCount(1)
+	, m_scale(1)
+	, m_originX(0)
+	, m_originY(0)
+	, m_onPixel(0xFFFFFF)
+	, m_offPixel(0x000000)
+	, m_dirtyTop(0)
+	, m_dirtyBottom(0)
+{
+	memset(m_hexKeyPad, 0, sizeof(m_hexKeyPad));
+	memset(m_frame, 0, sizeof(m_frame));
+}
+
+X11DisplayBackend::~X11DisplayBackend()
+{
+	destroy();
+}
+
+bool X11DisplayBackend::create(const char *title, int width, int height)
+{
+	Display *display = XOpenDisplay(nullptr);
+	if (display == nullptr)
+	{
+		printf("Failed to open the X display.\n");
+		return false;
+	}
+
+	int screen = DefaultScreen(display);
+
+	// The scaler writes 32-bit pixels, so only 24 / 32-bit TrueColor visuals are supported
+	XVisualInfo visualInfo;
+	if (!XMatchVisualInfo(display, screen, 24, TrueColor, &visualInfo))
+	{
+		printf("The X display has no 24-bit TrueColor visual.\n");
+		XCloseDisplay(display);
+		return false;
+	}
+
+	m_state = new X11State();
+	m_state->display = display;
+	m_state->visual = visualInfo.visual;
+	m_state->image = nullptr;
+	m_state->sharedMemory = false;
+	m_state->completionEvent = 0;
+	m_state->putPending = false;
+
+	m_displayWidth = DISPLAY_WIDTH;
+	m_displayHeight = DISPLAY_HEIGHT;
+	m_scale = std::max(1, std::min(width / DISPLAY_WIDTH, height / DISPLAY_HEIGHT));
+	m_originX = 0;
+	m_originY = 0;
+	width = DISPLAY_WIDTH * m_scale;
+	height = DISPLAY_HEIGHT * m_scale;
+
+	XSetWindowAttributes attributes;
+	attributes.colormap = XCreateColormap(display, RootWindow(display, screen), visualInfo.visual, AllocNone);
+	attributes.background_pixel = 0;
+	attributes.border_pixel = 0;
+	attributes.event_mask = KeyPressMask | KeyReleaseMask | ExposureMask | StructureNotifyMask;
+
+	m_state->window = XCreateWindow(display, RootWindow(display, screen), 0, 0, width, height, 0, visualInfo.depth, InputOutput,
+		visualInfo.visual, CWColormap | CWBackPixel | CWBorderPixel | CWEventMask, &attributes);
+
+	XStoreName(display, m_state->window, title);
+
+	// Fixed size, just like the GLFW window
+	XSizeHints *sizeHints = XAllocSizeHints();
+	sizeHints->flags = PMinSize | PMaxSize;
+	sizeHints->min_width = sizeHints->max_width = width;
+	sizeHints->min_height = sizeHints->max_height = height;
+	XSetWMNormalHints(display, m_state->window, sizeHints);
+	XFree(sizeHints);
+
+	m_state->deleteWindowAtom = XInternAtom(display, "WM_DELETE_WINDOW", False);
+	XSetWMProtocols(display, m_state->window, &m_state->deleteWindowAtom, 1);
+
+	m_state->graphicsContext = XCreateGC(display, m_state->window, 0, nullptr);
+
+	// Shared memory only works when the X server runs on the same machine
+	if (XShmQueryExtension(display))
+	{
+		XImage *image = XShmCreateImage(display, visualInfo.visual, visualInfo.depth, ZPixmap, nullptr, &m_state->segment, width, height);
+
+		if (image != nullptr)
+		{
+			m_state->segment.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+			m_state->segment.shmaddr = m_state->segment.shmid >= 0 ? static_cast<char *>(shmat(m_state->segment.shmid, nullptr, 0)) : reinterpret_cast<char *>(-1);
+			m_state->segment.readOnly = False;
+
+			if (m_state->segment.shmaddr != reinterpret_cast<char *>(-1))
+			{
+				image->data = m_state->segment.shmaddr;
+
+				attachFailed = false;
+				XErrorHandler previousHandler = XSetErrorHandler(attachErrorHandler);
+				XShmAttach(display, &m_state->segment);
+				XSync(display, False);
+				XSetErrorHandler(previousHandler);
+
+				// The segment is freed automatically once both processes detached, even when the emulator crashes
+				shmctl(m_state->segment.shmid, IPC_RMID, nullptr);
+
+				if (!attachFailed)
+				{
+					m_state->image = image;
+					m_state->sharedMemory = true;
+					m_state->completionEvent = XShmGetEventBase(display) + ShmCompletion;
+				}
+				else
+					shmdt(m_state->segment.shmaddr);
+			}
+			else if (m_state->segment.shmid >= 0)
+				shmctl(m_state->segment.shmid, IPC_RMID, nullptr);
+
+			if (!m_state->sharedMemory)
+			{
+				image->data = nullptr;
+				XDestroyImage(image);
+			}
+		}
+	}
+
+	if (!m_state->sharedMemory)
+	{
+		printf("MIT-SHM is not available, falling back to XPutImage.\n");
+
+		m_state->image = XCreateImage(display, visualInfo.visual, visualInfo.depth, ZPixmap, 0, nullptr, width, height, 32, 0);
+		if (m_state->image != nullptr)
+			m_state->image->data = static_cast<char *>(malloc(m_state->image->bytes_per_line * height));
+	}
+
+	if (m_state->image == nullptr || m_state->image->bits_per_pixel != 32)
+	{
+		printf("Failed to create a 32-bit X image.\n");
+		destroy();
+		return false;
+	}
+
+	XMapWindow(display, m_state->window);
+	XFlush(display);
+
+	// White pixels on a black background
+	const float ON_COLOR[3] = { 1.0f, 1.0f, 1.0f };
+	const float OFF_COLOR[3] = { 0.0f, 0.0f, 0.0f };
+	setPalette(ON_COLOR, OFF_COLOR);
+
+	return true;
+}
+
+void X11DisplayBackend::destroy()
+{
+	if (m_state == nullptr)
+		return;
+
+	Display *display = m_state->display;
+
+	if (m_state->image != nullptr)
+	{
+		if (m_state->sharedMemory)
+		{
+			waitForCompletion();
+			XShmDetach(display, &m_state->segment);
+			XSync(display, False);
+			shmdt(m_state->segment.shmaddr);
+			m_state->image->data = nullptr;
+		}
+
+		// Also frees the pixels of a regular image
+		XDestroyImage(m_state->image);
+	}
+
+	XFreeGC(display, m_state->graphicsContext);
+	XDestroyWindow(display, m_state->window);
+	XCloseDisplay(display);
+
+	delete m_state;
+	m_state = nullptr;
+}
+
+void X11DisplayBackend::setDisplaySize(int width, int height, int planeCount)
+{
+	m_planeCount = planeCount;
+
+	if (width == m_displayWidth && height == m_displayHeight)
+		return;
+
+	// The window keeps its size, the display is centered in it at the largest whole scale that fits
+	XImage *image = m_state->image;
+	m_displayWidth = width;
+	m_displayHeight = height;
+	m_scale = std::max(1, std::min(image->width / width, image->height / height));
+	m_originX = std::max(0, (image->width - width * m_scale) / 2);
+	m_originY = std::max(0, (image->height - height * m_scale) / 2);
+
+	memset(m_frame, 0, sizeof(m_frame));
+	redraw();
+}
+
+size_t X11DisplayBackend::updatePixels(const qword *graphicsMemory, const DirtyRegion & dirtyRegion)
+{
+	if (dirtyRegion.isEmpty())
+		return 0;
+
+	// The X server may still be reading the previous frame out of shared memory
+	waitForCompletion();
+
+	int top = m_displayHeight;
+	int bottom = 0;
+
+	for (int i = 0; i < dirtyRegion.getRectCount(); ++i)
+	{
+		const DirtyRect & rect = dirtyRegion.getRect(i);
+		top = std::min(top, static_cast<int>(rect.y));
+		bottom = std::max(bottom, rect.y + rect.height);
+	}
+
+	int rowWords = m_displayWidth / 64;
+	size_t planeWords = static_cast<size_t>(rowWords) * m_displayHeight;
+
+	// The image has one color for switched on pixels, so the planes are combined
+	for (int i = top * rowWords; i < bottom * rowWords; ++i)
+	{
+		qword pixels = graphicsMemory[i];
+		for (int plane = 1; plane < m_planeCount; ++plane)
+			pixels |= graphicsMemory[plane * planeWords + i];
+
+		m_frame[i] = pixels;
+	}
+
+	// Scaling whole rows keeps the inner loop simple, a row is at most 128 pixels wide
+	XImage *image = m_state->image;
+	size_t pitch = image->bytes_per_line / sizeof(unsigned int);
+	scaleBitPackedRows(m_frame, rowWords, top, bottom - top, m_scale, m_onPixel, m_offPixel,
+		reinterpret_cast<unsigned int *>(image->data) + m_originY * pitch + m_originX, pitch);
+
+	if (m_dirtyTop == m_dirtyBottom)
+	{
+		m_dirtyTop = top;
+		m_dirtyBottom = bottom;
+	}
+	else
+	{
+		m_dirtyTop = std::min(m_dirtyTop, top);
+		m_dirtyBottom = std::max(m_dirtyBottom, bottom);
+	}
+
+	return static_cast<size_t>(bottom - top) * m_scale * image->bytes_per_line;
+}
+
+void X11DisplayBackend::present()
+{
+	if (m_dirtyTop == m_dirtyBottom)
+		return;
+
+	XImage *image = m_state->image;
+	int y = m_originY + m_dirtyTop * m_scale;
+	int height = (m_dirtyBottom - m_dirtyTop) * m_scale;
+
+	// The complete display also includes the border around it
+	if (m_dirtyTop == 0 && m_dirtyBottom == m_displayHeight)
+	{
+		y = 0;
+		height = image->height;
+	}
+
+	if (m_state->sharedMemory)
+	{
+		// Ask for a completion event, the image must not be written to before the server has read it
+		XShmPutImage(m_state->display, m_state->window, m_state->graphicsContext, image, 0, y, 0, y, image->width, height, True);
+		m_state->putPending = true;
+	}
+	else
+		XPutImage(m_state->display, m_state->window, m_state->graphicsContext, image, 0, y, 0, y, image->width, height);
+
+	XFlush(m_state->display);
+
+	m_dirtyTop = 0;
+	m_dirtyBottom = 0;
+}
+
+void X11DisplayBackend::pollEvents()
+{
+	Display *display = m_state->display;
+
+	while (XPending(display) > 0)
+	{
+		XEvent event;
+		XNextEvent(display, &event);
+
+		switch (event.type)
+		{
+		case KeyPress:
+		case KeyRelease:
+		{
+			byte state = event.type == KeyPress ? 1 : 0;
+
+			// Same layout as the GLFW window: 1234 / QWER / ASDF / ZXCV
+			switch (XLookupKeysym(&event.xkey, 0))
+			{
+			case XK_1: m_hexKeyPad[0x1] = state; break;
+			case XK_2: m_hexKeyPad[0x2] = state; break;
+			case XK_3: m_hexKeyPad[0x3] = state; break;
+			case XK_4: m_hexKeyPad[0xC] = state; break;
+			case XK_q: m_hexKeyPad[0x4] = state; break;
+			case XK_w: m_hexKeyPad[0x5] = state; break;
+			case XK_e: m_hexKeyPad[0x6] = state; break;
+			case XK_r: m_hexKeyPad[0xD] = state; break;
+			case XK_a: m_hexKeyPad[0x7] = state; break;
+			case XK_s: m_hexKeyPad[0x8] = state; break;
+			case XK_d: m_hexKeyPad[0x9] = state; break;
+			case XK_f: m_hexKeyPad[0xE] = state; break;
+			case XK_z: m_hexKeyPad[0xA] = state; break;
+			case XK_x: m_hexKeyPad[0x0] = state; break;
+			case XK_c: m_hexKeyPad[0xB] = state; break;
+			case XK_v: m_hexKeyPad[0xF] = state; break;
+			default: break;
+			}
+
+			break;
+		}
+
+		case Expose:
+			// Everything has to be shown again after the window was uncovered
+			m_dirtyTop = 0;
+			m_dirtyBottom = m_displayHeight;
+			present();
+			break;
+
+		case ClientMessage:
+			if (static_cast<Atom>(event.xclient.data.l[0]) == m_state->deleteWindowAtom)
+				m_closeRequested = true;
+			break;
+
+		default:
+			if (event.type == m_state->completionEvent)
+				m_state->putPending = false;
+			break;
+		}
+	}
+}
+
+bool X11DisplayBackend::shouldClose() const
+{
+	return m_closeRequested;
+}
+
+const byte *X11DisplayBackend::getHexKeyPad() const
+{
+	return m_hexKeyPad;
+}
+
+int X11DisplayBackend::getRefreshRate() const
+{
+	// Plain X11 has no portable way to query the refresh rate
+	return 60;
+}
+
+void X11DisplayBackend::setVerticalSync(bool)
+{
+	// XPutImage is never synchronized with the refresh, the presenter still limits how often it is called
+}
+
+void X11DisplayBackend::setPalette(const float *onColor, const float *offColor)
+{
+	m_onPixel = toPixel(onColor);
+	m_offPixel = toPixel(offColor);
+
+	// Redraw the complete image in the new colors
+	redraw();
+}
+
+const char *X11DisplayBackend::getName() const
+{
+	return m_state != nullptr && m_state->sharedMemory ? "X11 (MIT-SHM)" : "X11";
+}
+
+bool X11DisplayBackend::isUsingSharedMemory() const
+{
+	return m_state != nullptr && m_state->sharedMemory;
+}
+
+void X11DisplayBackend::waitForCompletion()
+{
+	if (!m_state->putPending)
+		return;
+
+	// Blocks until the completion event arrives, other events stay in the queue for pollEvents()
+	XEvent event;
+	XIfEvent(m_state->display, &event, [](Display *, XEvent *candidate, XPointer argument) -> Bool
+	{
+		return candidate->type == *reinterpret_cast<int *>(argument) ? True : False;
+	}, reinterpret_cast<XPointer>(&m_state->completionEvent));
+
+	m_state->putPending = false;
+}
+
+void X11DisplayBackend::redraw()
+{
+	waitForCompletion();
+
+	XImage *image = m_state->image;
+	size_t pitch = image->bytes_per_line / sizeof(unsigned int);
+	unsigned int *pixels = reinterpret_cast<unsigned int *>(image->data);
+
+	for (int y = 0; y < image->height; ++y)
+		std::fill(pixels + y * pitch, pixels + y * pitch + image->width, m_offPixel);
+
+	scaleBitPackedRows(m_frame, m_displayWidth / 64, 0, m_displayHeight, m_scale, m_onPixel, m_offPixel,
+		pixels + m_originY * pitch + m_originX, pitch);
+
+	m_dirtyTop = 0;
+	m_dirtyBottom = m_displayHeight;
+}
+
+unsigned int X11DisplayBackend::toPixel(const float *color) const
+{
+	const unsigned long masks[3] = { m_state->visual->red_mask, m_state->visual->green_mask, m_state->visual->blue_mask };
+
+	unsigned int pixel = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		unsigned long maximum = masks[i] >> maskShift(masks[i]);
+		unsigned long value = static_cast<unsigned long>(std::max(0.0f, std::min(1.0f, color[i])) * maximum + 0.5f);
+		pixel |= static_cast<unsigned int>(value << maskShift(masks[i]));
+	}
+
+	return pixel;
+}
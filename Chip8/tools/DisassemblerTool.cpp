@@ -0,0 +1,289 @@
+#include "Chip8/Utility/ControlFlowGraph.hpp"
+#include "Chip8/Utility/Coverage.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/Disassembler.hpp"
+#include "Chip8/Utility/Hash.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Disassembles a ROM, or prints its control flow graph as a list of basic blocks or in Graphviz dot format. The batch
+// mode writes a listing for every ROM below a directory, in the same layout below the output directory.
+// Usage: Chip8Disassembler rom.ch8 [--coverage file.cov]
+//        Chip8Disassembler rom.ch8 --blocks
+//        Chip8Disassembler rom.ch8 --dot > cfg.dot
+//        Chip8Disassembler --batch roms --output listings [--cache directory] [--threads count]
+
+// Part of the names of cached listings, increase it whenever the listing format changes so old entries are not reused
+static const int LISTING_FORMAT_VERSION = 1;
+
+struct BatchSettings
+{
+	std::filesystem::path romDirectory;
+	std::filesystem::path outputDirectory;
+	std::filesystem::path cacheDirectory;	// Empty when listings are not cached
+	unsigned int threadCount;
+};
+
+struct BatchStatistics
+{
+	std::atomic<long> disassembled{ 0 };
+	std::atomic<long> cached{ 0 };
+	std::atomic<long> failed{ 0 };
+};
+
+// Places the ROM at 0x200 after the memory reserved for the interpreter, where it is loaded
+static bool readRom(const std::filesystem::path & path, std::vector<byte> & memory)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	memory.assign(0x200, 0);
+	memory.insert(memory.end(), std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static bool readText(const std::filesystem::path & path, std::string & text)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// The whole text is written with one call
+static bool writeText(const std::filesystem::path & path, const std::string & text)
+{
+	FILE *filePtr = fopen(path.string().c_str(), "wb");
+	if (filePtr == nullptr)
+		return false;
+
+	bool success = fwrite(text.data(), 1, text.size(), filePtr) == text.size();
+	return fclose(filePtr) == 0 && success;
+}
+
+// Cache entries are written under a temporary name first, so a worker never reads a listing that is half written
+// when the same ROM is stored under two names
+static void storeInCache(const std::filesystem::path & cachePath, const std::string & listing, unsigned int worker)
+{
+	std::filesystem::path temporaryPath = cachePath;
+	temporaryPath += ".tmp" + std::to_string(worker);
+
+	std::error_code error;
+	if (writeText(temporaryPath, listing))
+		std::filesystem::rename(temporaryPath, cachePath, error);
+	else
+		std::filesystem::remove(temporaryPath, error);
+}
+
+// Each worker takes the next ROM from the shared list and keeps its own memory image and listing buffer, so they are
+// only allocated while they grow
+static void disassembleRoms(const BatchSettings & settings, const std::vector<std::filesystem::path> & roms,
+	std::atomic<size_t> & nextRom, BatchStatistics & statistics, unsigned int worker)
+{
+	Chip8Disassembler disassembler;
+	std::vector<byte> memory;
+	std::string listing;
+
+	for (size_t index = nextRom++; index < roms.size(); index = nextRom++)
+	{
+		const std::filesystem::path & romPath = roms[index];
+
+		std::filesystem::path listingPath = settings.outputDirectory / std::filesystem::relative(romPath, settings.romDirectory);
+		listingPath.replace_extension(".lst");
+
+		if (!readRom(romPath, memory) || memory.size() >= 0x10000)
+		{
+			fprintf(stderr, "Failed to read %s.\n", romPath.string().c_str());
+			++statistics.failed;
+			continue;
+		}
+
+		word romSize = static_cast<word>(memory.size() - 0x200);
+		listing.clear();
+
+		std::filesystem::path cachePath;
+		if (!settings.cacheDirectory.empty())
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "%016llX-%i.lst", hashBytes(memory.data() + 0x200, romSize), LISTING_FORMAT_VERSION);
+			cachePath = settings.cacheDirectory / name;
+		}
+
+		if (!cachePath.empty() && readText(cachePath, listing))
+		{
+			++statistics.cached;
+		}
+		else
+		{
+			disassembler.formatListing(0x200, romSize, memory.data(), nullptr, listing);
+			++statistics.disassembled;
+
+			if (!cachePath.empty())
+				storeInCache(cachePath, listing, worker);
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(listingPath.parent_path(), error);
+
+		if (!writeText(listingPath, listing))
+		{
+			fprintf(stderr, "Failed to write %s.\n", listingPath.string().c_str());
+			++statistics.failed;
+		}
+	}
+}
+
+static int disassembleBatch(const BatchSettings & settings)
+{
+	std::vector<std::filesystem::path> roms;
+
+	std::error_code error;
+	for (const auto & item : std::filesystem::recursive_directory_iterator(settings.romDirectory, error))
+	{
+		if (item.is_regular_file() && item.path().extension() == ".ch8")
+			roms.push_back(item.path());
+	}
+
+	if (error)
+	{
+		printf("Failed to read %s: %s\n", settings.romDirectory.string().c_str(), error.message().c_str());
+		return -1;
+	}
+
+	if (!settings.cacheDirectory.empty() && !std::filesystem::create_directories(settings.cacheDirectory, error) && error)
+	{
+		printf("Failed to create %s: %s\n", settings.cacheDirectory.string().c_str(), error.message().c_str());
+		return -1;
+	}
+
+	// The largest ROMs are started first, so no worker is left with a long one at the end
+	std::sort(roms.begin(), roms.end(), [](const std::filesystem::path & a, const std::filesystem::path & b)
+	{
+		std::error_code sizeError;
+		return std::filesystem::file_size(a, sizeError) > std::filesystem::file_size(b, sizeError);
+	});
+
+	unsigned int threadCount = std::max(1u, std::min<unsigned int>(settings.threadCount, static_cast<unsigned int>(roms.size())));
+
+	std::atomic<size_t> nextRom{ 0 };
+	BatchStatistics statistics;
+
+	std::vector<std::thread> workers;
+	for (unsigned int worker = 0; worker < threadCount; ++worker)
+		workers.emplace_back(disassembleRoms, std::cref(settings), std::cref(roms), std::ref(nextRom), std::ref(statistics), worker);
+
+	for (std::thread & worker : workers)
+		worker.join();
+
+	fprintf(stderr, "%zu ROMs: %li disassembled, %li from the cache, %li failed, %u threads.\n", roms.size(),
+		statistics.disassembled.load(), statistics.cached.load(), statistics.failed.load(), threadCount);
+
+	return statistics.failed == 0 ? 0 : -1;
+}
+
+int main(int argc, char const *argv[])
+{
+	const char *romPath = nullptr;
+	const char *coveragePath = nullptr;
+	bool printBlocks = false;
+	bool printDot = false;
+	bool validArguments = true;
+
+	BatchSettings batchSettings;
+	batchSettings.threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--coverage") == 0 && i + 1 < argc)
+			coveragePath = argv[++i];
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+			batchSettings.romDirectory = argv[++i];
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			batchSettings.outputDirectory = argv[++i];
+		else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+			batchSettings.cacheDirectory = argv[++i];
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			batchSettings.threadCount = static_cast<unsigned int>(std::max(1, atoi(argv[++i])));
+		else if (strcmp(argv[i], "--blocks") == 0)
+			printBlocks = true;
+		else if (strcmp(argv[i], "--dot") == 0)
+			printDot = true;
+		else if (argv[i][0] != '-' && romPath == nullptr)
+			romPath = argv[i];
+		else
+			validArguments = false;
+	}
+
+	bool batch = !batchSettings.romDirectory.empty();
+	if (batch && (romPath != nullptr || batchSettings.outputDirectory.empty()))
+		validArguments = false;
+
+	if (!validArguments || (romPath == nullptr && !batch))
+	{
+		printf("Usage: %s rom.ch8 [--coverage file.cov]\n", argv[0]);
+		printf("       %s rom.ch8 --blocks\n", argv[0]);
+		printf("       %s rom.ch8 --dot\n", argv[0]);
+		printf("       %s --batch roms --output listings [--cache directory] [--threads count]\n", argv[0]);
+		return -1;
+	}
+
+	if (batch)
+		return disassembleBatch(batchSettings);
+
+	std::ifstream file(romPath, std::ios::binary);
+	if (!file)
+	{
+		printf("Failed to open %s.\n", romPath);
+		return -1;
+	}
+
+	// The ROM is placed at 0x200, where the interpreter loads it
+	std::vector<byte> memory(0x200);
+	memory.insert(memory.end(), std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	// The end address 0x200 + size has to fit into 16 bits
+	if (memory.size() >= 0x10000)
+	{
+		printf("%s does not fit into the 64 KB address space.\n", romPath);
+		return -1;
+	}
+
+	word romSize = static_cast<word>(memory.size() - 0x200);
+
+	if (printBlocks || printDot)
+	{
+		Chip8ControlFlowGraph controlFlowGraph;
+		controlFlowGraph.build(memory.data() + 0x200, romSize, 0x200);
+
+		if (printDot)
+			controlFlowGraph.printDot(stdout);
+		else
+			controlFlowGraph.print(stdout);
+
+		return 0;
+	}
+
+	Chip8Coverage coverage;
+	if (coveragePath != nullptr && !coverage.mergeFromFile(coveragePath))
+	{
+		printf("Failed to load the coverage file %s.\n", coveragePath);
+		return -1;
+	}
+
+	Chip8Disassembler disassembler;
+	disassembler.disassemble(0x200, romSize, memory.data(), coveragePath != nullptr ? &coverage : nullptr);
+
+	return 0;
+}
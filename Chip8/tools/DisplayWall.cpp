@@ -0,0 +1,128 @@
+#include "Chip8/Emulator/DisplayWall.hpp"
+#include "Chip8/Emulator/HeadlessRunner.hpp"
+#include "Chip8/Emulator/Window.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/RomLibrary.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Runs many ROMs at once and shows all of their displays in a grid, using random input so the games keep moving.
+// The ROMs are taken from the given directories and repeated until there are enough instances.
+// Usage: Chip8DisplayWall [directories...] [--instances N] [--columns N] [--cycles-per-frame N] [--seed N]
+struct WallSettings
+{
+	std::vector<std::string> directories;
+	int instances = 64;
+	int columns = 0;
+	int cyclesPerFrame = 10;
+	unsigned int seed = 1;
+};
+
+int main(int argc, char const *argv[])
+{
+	WallSettings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+			settings.instances = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc)
+			settings.columns = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--cycles-per-frame") == 0 && i + 1 < argc)
+			settings.cyclesPerFrame = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			settings.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (argv[i][0] == '-')
+		{
+			printf("Usage: %s [directories...] [--instances N] [--columns N] [--cycles-per-frame N] [--seed N]\n", argv[0]);
+			return -1;
+		}
+		else
+			settings.directories.push_back(argv[i]);
+	}
+
+	if (settings.directories.empty())
+		settings.directories = { "roms/games", "roms/demos" };
+
+	std::vector<std::string> roms = Chip8RomLibrary::findRoms(settings.directories);
+	if (roms.empty())
+	{
+		printf("No ROMs found.\n");
+		return -1;
+	}
+
+	// Every instance gets its own seed, so copies of the same ROM do not run in lockstep
+	std::vector<std::unique_ptr<HeadlessRunner>> runners;
+	for (int i = 0; i < settings.instances; ++i)
+	{
+		std::unique_ptr<HeadlessRunner> runner(new HeadlessRunner());
+		runner->setCyclesPerFrame(settings.cyclesPerFrame);
+		runner->setSeed(settings.seed + i);
+		runner->setRandomInput(true);
+
+		const std::string & path = roms[i % roms.size()];
+		if (!runner->loadGame(path.c_str()))
+		{
+			printf("Failed to load %s.\n", path.c_str());
+			return -1;
+		}
+
+		runners.push_back(std::move(runner));
+	}
+
+	Window window;
+	DisplayWall wall;
+
+	if (!window.create("Chip8 display wall", 1280, 720, 3, 3))
+		return -1;
+
+	if (!wall.initialize(window, settings.instances, settings.columns))
+		return -1;
+
+	window.setVerticalSync(true);
+
+	printf("Running %i instances in a %ix%i grid.\n", wall.getInstanceCount(), wall.getColumns(), wall.getRows());
+
+	std::chrono::high_resolution_clock::time_point lastFrame = std::chrono::high_resolution_clock::now();
+	const std::chrono::duration<float> FRAME_DURATION(1.0f / 60.0f);
+
+	long frames = 0;
+	size_t uploadedBytes = 0;
+
+	while (!window.shouldClose())
+	{
+		window.pollKeyboard();
+
+		std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+		if (now - lastFrame < FRAME_DURATION)
+			continue;
+
+		lastFrame = now;
+
+		for (int i = 0; i < settings.instances; ++i)
+		{
+			runners[i]->runFrame();
+			wall.publish(i, runners[i]->getProcessor());
+		}
+
+		uploadedBytes += wall.update();
+		wall.draw();
+		window.display();
+
+		++frames;
+	}
+
+	printf("Drew %li frames, uploaded %li tiles (%.1f per frame, %zu bytes in total).\n",
+		frames, wall.getUploadedTileCount(), frames > 0 ? static_cast<double>(wall.getUploadedTileCount()) / frames : 0.0, uploadedBytes);
+
+	window.quit();
+
+	return 0;
+}
@@ -0,0 +1,259 @@
+#include "Chip8/Emulator/FrameCapture.hpp"
+#include "Chip8/Emulator/HeadlessRunner.hpp"
+#include "Chip8/Emulator/Quirks.hpp"
+#include "Chip8/Emulator/SnapshotCache.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/FrameStream.hpp"
+#include "Chip8/Utility/RomAnalyzer.hpp"
+#include "Chip8/Utility/RomLibrary.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Records gameplay of every ROM in the given directories without a window. Every emulated frame is captured, either as
+// a Y4M video per ROM, as a folder of numbered PNG files per ROM, or as a frame stream per ROM for Chip8Stream.
+// Usage: Chip8Recorder [directories...] [--frames N] [--format y4m|png|stream] [--scale N] [--threads N] [--queue N] [--drop]
+//                      [--keyframe-interval N] [--output folder] [--cycles-per-frame N] [--seed N] [--input script.txt] [--palette RRGGBB RRGGBB]
+//                      [--quirks auto|vip|chip48|schip|xochip] [--rom-database path] [--warm-start folder]
+// With automatic quirks every ROM is recorded with the profile and speed of its database entry or of the heuristics, an
+// explicit --cycles-per-frame overrides the speed. With --warm-start the recordings skip the boot and intro sequences
+// and start at the first frame that checks the keys, from snapshots kept in the folder.
+struct RecorderSettings
+{
+	std::vector<std::string> directories;
+	std::string outputFolder = "captures";
+	long frames = 1800;
+	int cyclesPerFrame = 0;		// Zero picks the recommended speed of the quirk profile
+	unsigned int seed = 1;
+	QuirkProfile quirkProfile = QuirkProfile::SUPER_CHIP;
+	bool detectQuirks = true;
+	const char *romDatabasePath = "roms/RomDatabase.tsv";
+	const char *inputScript = nullptr;
+	const char *snapshotFolder = nullptr;
+	long warmStartLimit = 600;	// ROMs that never check the keys start at this frame
+	bool frameStream = false;
+	int keyframeInterval = 600;
+	CaptureSettings capture;
+};
+
+// Frame streams are cheap to encode, so they are written on the emulation thread without the capture pipeline
+static bool recordStream(HeadlessRunner & runner, const std::string & name, const RecorderSettings & settings)
+{
+	std::string outputPath = (std::filesystem::path(settings.outputFolder) / name).string() + ".c8fs";
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Hires ROMs switch the display mode on their first instruction, so the display size is known after the first frame
+	runner.runFrame();
+
+	const Chip8Processor & processor = runner.getProcessor();
+
+	FrameStreamWriter writer;
+	if (!writer.open(outputPath.c_str(), processor.getDisplayWidth(), processor.getDisplayHeight(), settings.keyframeInterval))
+		return false;
+
+	// Later display mode switches start a keyframe of the new size
+	writer.writeFrame(processor.getGraphicsMemory(), processor.getDisplayWidth(), processor.getDisplayHeight());
+
+	for (long frame = 1; frame < settings.frames; ++frame)
+	{
+		runner.runFrame();
+		writer.writeFrame(processor.getGraphicsMemory(), processor.getDisplayWidth(), processor.getDisplayHeight());
+	}
+
+	long frames = writer.getFrameCount();
+	if (!writer.close())
+		return false;
+
+	double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	fprintf(stderr, "%-60s %6li frames written, %8lli bytes (%5.1f per frame), total %7.1f ms\n",
+		name.c_str(), frames, writer.getBytesWritten(), static_cast<double>(writer.getBytesWritten()) / frames, totalTime * 1e3);
+
+	return true;
+}
+
+static bool recordRom(const std::string & path, const RecorderSettings & settings, const Chip8RomDatabase & database,
+	SnapshotCache *snapshots)
+{
+	HeadlessRunner runner;
+	runner.setSeed(settings.seed);
+
+	if (!runner.loadGame(path.c_str()))
+		return false;
+
+	QuirkProfile quirkProfile = settings.quirkProfile;
+	int cyclesPerFrame = Chip8RomAnalyzer::getRecommendedCyclesPerFrame(quirkProfile);
+
+	if (settings.detectQuirks)
+	{
+		Chip8RomAnalysis analysis = runner.analyzeGame(&database);
+		quirkProfile = analysis.quirkProfile;
+		cyclesPerFrame = analysis.cyclesPerFrame;
+	}
+
+	runner.setQuirkProfile(quirkProfile);
+	runner.setCyclesPerFrame(settings.cyclesPerFrame > 0 ? settings.cyclesPerFrame : cyclesPerFrame);
+
+	if (settings.inputScript != nullptr)
+	{
+		if (!runner.loadInputScript(settings.inputScript))
+			return false;
+	}
+	else
+		runner.setRandomInput(true);
+
+	if (snapshots != nullptr && !snapshots->warmStart(runner, SnapshotCheckpoint::FIRST_KEY_POLL, settings.warmStartLimit))
+		return false;
+
+	std::string name = std::filesystem::path(path).stem().string();
+
+	if (settings.frameStream)
+		return recordStream(runner, name, settings);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Hires ROMs switch the display mode on their first instruction, so the display size is known after the first frame
+	runner.runFrame();
+
+	const Chip8Processor & processor = runner.getProcessor();
+
+	CaptureSettings captureSettings = settings.capture;
+	captureSettings.outputPath = (std::filesystem::path(settings.outputFolder) / name).string();
+	captureSettings.displayWidth = processor.getDisplayWidth();
+	captureSettings.displayHeight = processor.getDisplayHeight();
+
+	if (captureSettings.format == CaptureFormat::Y4M)
+		captureSettings.outputPath += ".y4m";
+
+	FrameCapture capture;
+	if (!capture.start(captureSettings))
+		return false;
+
+	capture.submit(processor.getGraphicsMemory(), processor.getDisplayWidth(), processor.getDisplayHeight());
+
+	for (long frame = 1; frame < settings.frames; ++frame)
+	{
+		runner.runFrame();
+
+		// The frames recorded so far are kept, the recording of this ROM fails
+		if (!capture.acceptsDisplaySize(processor.getDisplayWidth(), processor.getDisplayHeight()))
+		{
+			capture.finish();
+			fprintf(stderr, "%s switches the display to %ix%i at frame %li, a Y4M video cannot change its size. Use --format png or stream.\n",
+				name.c_str(), processor.getDisplayWidth(), processor.getDisplayHeight(), frame);
+			return false;
+		}
+
+		capture.submit(processor.getGraphicsMemory(), processor.getDisplayWidth(), processor.getDisplayHeight());
+	}
+
+	double emulationTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	capture.finish();
+
+	double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	fprintf(stderr, "%-60s %6li frames written, %5li dropped, emulation %7.1f ms, total %7.1f ms\n",
+		name.c_str(), capture.getWrittenFrameCount(), capture.getDroppedFrameCount(), emulationTime * 1e3, totalTime * 1e3);
+
+	return true;
+}
+
+int main(int argc, char const *argv[])
+{
+	RecorderSettings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			settings.frames = std::max(1L, atol(argv[++i]));
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+		{
+			++i;
+			settings.frameStream = strcmp(argv[i], "stream") == 0;
+			settings.capture.format = strcmp(argv[i], "png") == 0 ? CaptureFormat::PNG_SEQUENCE : CaptureFormat::Y4M;
+		}
+		else if (strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc)
+			settings.keyframeInterval = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+			settings.capture.scale = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			settings.capture.encoderThreads = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc)
+			settings.capture.queueCapacity = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--drop") == 0)
+			settings.capture.backpressure = CaptureBackpressure::DROP;
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			settings.outputFolder = argv[++i];
+		else if (strcmp(argv[i], "--cycles-per-frame") == 0 && i + 1 < argc)
+			settings.cyclesPerFrame = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			settings.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+			settings.inputScript = argv[++i];
+		else if (strcmp(argv[i], "--palette") == 0 && i + 2 < argc)
+		{
+			settings.capture.onColor = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 16));
+			settings.capture.offColor = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 16));
+		}
+		else if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc && strcmp(argv[i + 1], "auto") == 0)
+		{
+			settings.detectQuirks = true;
+			++i;
+		}
+		else if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc && parseQuirkProfile(argv[i + 1], settings.quirkProfile))
+		{
+			settings.detectQuirks = false;
+			++i;
+		}
+		else if (strcmp(argv[i], "--rom-database") == 0 && i + 1 < argc)
+			settings.romDatabasePath = argv[++i];
+		else if (strcmp(argv[i], "--warm-start") == 0 && i + 1 < argc)
+			settings.snapshotFolder = argv[++i];
+		else if (argv[i][0] == '-')
+		{
+			printf("Usage: %s [directories...] [--frames N] [--format y4m|png|stream] [--scale N] [--threads N] [--queue N] [--drop]\n", argv[0]);
+			printf("       [--keyframe-interval N] [--output folder] [--cycles-per-frame N] [--seed N] [--input script.txt] [--palette RRGGBB RRGGBB]\n");
+			printf("       [--quirks auto|vip|chip48|schip|xochip] [--rom-database path] [--warm-start folder]\n");
+			return -1;
+		}
+		else
+			settings.directories.push_back(argv[i]);
+	}
+
+	if (settings.directories.empty())
+		settings.directories = { "roms/games", "roms/demos", "roms/programs" };
+
+	std::error_code error;
+	std::filesystem::create_directories(settings.outputFolder, error);
+
+	Chip8RomDatabase database;
+	if (settings.detectQuirks && !database.load(settings.romDatabasePath))
+		fprintf(stderr, "Failed to load the ROM database %s, picking quirks with the heuristics only.\n", settings.romDatabasePath);
+
+	SnapshotCache snapshots;
+	if (settings.snapshotFolder != nullptr && !snapshots.open(settings.snapshotFolder))
+		return -1;
+
+	int failures = 0;
+	for (const std::string & path : Chip8RomLibrary::findRoms(settings.directories))
+	{
+		if (!recordRom(path, settings, database, settings.snapshotFolder != nullptr ? &snapshots : nullptr))
+		{
+			fprintf(stderr, "Failed to record %s.\n", path.c_str());
+			++failures;
+		}
+	}
+
+	if (settings.snapshotFolder != nullptr)
+		fprintf(stderr, "Warm starts: %li from snapshots, %li snapshots built.\n", snapshots.getHitCount(), snapshots.getBuildCount());
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,286 @@
+#include "Chip8/Emulator/Quirks.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/RomAnalyzer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Builds the ROM database from the ROMs in the given directories and the .txt files next to them, or prints what the
+// analyzer decides for single ROMs. Entries with the source "manual" are kept when the database is rebuilt, so
+// corrections made by hand survive.
+// Usage: Chip8RomDatabase build [directories...] [--output roms/RomDatabase.tsv]
+//        Chip8RomDatabase analyze rom.ch8 [...] [--database roms/RomDatabase.tsv]
+static bool readFile(const std::string & path, std::vector<byte> & data)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static std::string readLowerCaseText(const std::filesystem::path & path)
+{
+	std::ifstream file(path);
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+	return text;
+}
+
+// Whole words only, so "vip" does not match "vipers"
+static bool containsWord(const std::string & text, const char *word)
+{
+	size_t length = strlen(word);
+
+	for (size_t position = text.find(word); position != std::string::npos; position = text.find(word, position + 1))
+	{
+		bool startsWord = position == 0 || !isalnum(static_cast<unsigned char>(text[position - 1]));
+		bool endsWord = position + length == text.size() || !isalnum(static_cast<unsigned char>(text[position + length]));
+
+		if (startsWord && endsWord)
+			return true;
+	}
+
+	return false;
+}
+
+static bool findProfileInMetadata(const std::string & text, QuirkProfile & profile)
+{
+	const struct
+	{
+		const char *word;
+		QuirkProfile profile;
+	} KEYWORDS[] =
+	{
+		{ "xo-chip", QuirkProfile::XO_CHIP },
+		{ "octo", QuirkProfile::XO_CHIP },
+		{ "superchip", QuirkProfile::SUPER_CHIP },
+		{ "superchip8", QuirkProfile::SUPER_CHIP },
+		{ "super chip", QuirkProfile::SUPER_CHIP },
+		{ "schip", QuirkProfile::SUPER_CHIP },
+		{ "chip-48", QuirkProfile::CHIP48 },
+		{ "chip48", QuirkProfile::CHIP48 },
+		{ "hp48", QuirkProfile::CHIP48 },
+		{ "hp-48", QuirkProfile::CHIP48 },
+		{ "cosmac", QuirkProfile::COSMAC_VIP },
+		{ "vip", QuirkProfile::COSMAC_VIP },
+	};
+
+	for (const auto & keyword : KEYWORDS)
+	{
+		if (containsWord(text, keyword.word))
+		{
+			profile = keyword.profile;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// The ROM names carry the year of release, e.g. "Breakout [Carmelo Cortez, 1979]"
+static int findYear(const std::string & name)
+{
+	int year = 0;
+
+	for (size_t i = 0; i + 4 <= name.size(); ++i)
+	{
+		if (!isdigit(static_cast<unsigned char>(name[i])) || (i > 0 && isdigit(static_cast<unsigned char>(name[i - 1]))))
+			continue;
+
+		if (i + 4 < name.size() && isdigit(static_cast<unsigned char>(name[i + 4])))
+			continue;
+
+		int value = atoi(name.substr(i, 4).c_str());
+		if (value >= 1970 && value <= 2099)
+			year = value;
+	}
+
+	return year;
+}
+
+static Chip8RomDatabaseEntry classify(const std::filesystem::path & path, const byte *rom, size_t size)
+{
+	Chip8RomAnalysis analysis = Chip8RomAnalyzer::analyze(rom, size);
+
+	Chip8RomDatabaseEntry entry;
+	entry.hash = analysis.hash;
+	entry.name = path.stem().string();
+	entry.quirkProfile = analysis.quirkProfile;
+	entry.source = "analysis";
+
+	std::filesystem::path metadataPath = path;
+	metadataPath.replace_extension(".txt");
+
+	int year = findYear(entry.name);
+	QuirkProfile profile;
+
+	if (std::filesystem::exists(metadataPath) && findProfileInMetadata(readLowerCaseText(metadataPath), profile))
+	{
+		entry.quirkProfile = profile;
+		entry.source = "metadata";
+	}
+	else if (path.parent_path().filename() == "hires")
+	{
+		entry.quirkProfile = QuirkProfile::COSMAC_VIP;
+		entry.source = "directory";
+	}
+	else if (year != 0 && year < 1985)
+	{
+		entry.quirkProfile = QuirkProfile::COSMAC_VIP;
+		entry.source = "year";
+	}
+	else if (year >= 1990 && year < 1995 && !analysis.shiftsVy && !analysis.reliesOnIndexIncrement)
+	{
+		// The HP48 years, SUPER-CHIP programs are recognized by their instructions below
+		entry.quirkProfile = QuirkProfile::CHIP48;
+		entry.source = "year";
+	}
+
+	// The instructions a program uses are a stronger hint than any of the above
+	if (analysis.usesXoChip && entry.quirkProfile != QuirkProfile::XO_CHIP)
+	{
+		entry.quirkProfile = QuirkProfile::XO_CHIP;
+		entry.source = "analysis";
+	}
+	else if (analysis.usesSuperChip && entry.quirkProfile != QuirkProfile::SUPER_CHIP && entry.quirkProfile != QuirkProfile::XO_CHIP)
+	{
+		entry.quirkProfile = QuirkProfile::SUPER_CHIP;
+		entry.source = "analysis";
+	}
+	else if (analysis.usesVipHires && entry.quirkProfile != QuirkProfile::COSMAC_VIP)
+	{
+		// Only the VIP interpreter has the two-page hires mode, "Hires" in a name usually means SUPER-CHIP instead
+		entry.quirkProfile = QuirkProfile::COSMAC_VIP;
+		entry.source = "analysis";
+	}
+
+	entry.cyclesPerFrame = Chip8RomAnalyzer::getRecommendedCyclesPerFrame(entry.quirkProfile);
+	return entry;
+}
+
+static int build(const std::vector<std::string> & directories, const char *outputPath)
+{
+	Chip8RomDatabase previous;
+	previous.load(outputPath);
+
+	Chip8RomDatabase database;
+	long romCount = 0;
+
+	for (const std::string & directory : directories)
+	{
+		std::error_code error;
+		for (const auto & item : std::filesystem::recursive_directory_iterator(directory, error))
+		{
+			if (!item.is_regular_file() || item.path().extension() != ".ch8")
+				continue;
+
+			std::vector<byte> rom;
+			if (!readFile(item.path().string(), rom))
+			{
+				fprintf(stderr, "Failed to read %s.\n", item.path().string().c_str());
+				continue;
+			}
+
+			Chip8RomDatabaseEntry entry = classify(item.path(), rom.data(), rom.size());
+
+			const Chip8RomDatabaseEntry *manualEntry = previous.find(entry.hash);
+			if (manualEntry != nullptr && manualEntry->source == "manual")
+				entry = *manualEntry;
+
+			fprintf(stderr, "%016llX %-7s %4i %-9s %s\n", entry.hash, getQuirkProfileName(entry.quirkProfile), entry.cyclesPerFrame,
+				entry.source.c_str(), entry.name.c_str());
+
+			database.add(entry);
+			++romCount;
+		}
+
+		if (error)
+			fprintf(stderr, "Failed to read %s: %s\n", directory.c_str(), error.message().c_str());
+	}
+
+	if (!database.save(outputPath))
+	{
+		printf("Failed to write %s.\n", outputPath);
+		return -1;
+	}
+
+	// Identical ROMs under different names share one entry
+	fprintf(stderr, "%li ROMs, %zu entries written to %s.\n", romCount, database.getEntryCount(), outputPath);
+	return 0;
+}
+
+static int analyze(const std::vector<std::string> & paths, const char *databasePath)
+{
+	Chip8RomDatabase database;
+	if (!database.load(databasePath))
+		printf("No database at %s, only the heuristics are used.\n", databasePath);
+
+	for (const std::string & path : paths)
+	{
+		std::vector<byte> rom;
+		if (!readFile(path, rom))
+		{
+			printf("Failed to read %s.\n", path.c_str());
+			continue;
+		}
+
+		Chip8RomAnalysis analysis = Chip8RomAnalyzer::analyze(rom.data(), rom.size(), &database);
+
+		printf("%s\n", path.c_str());
+		printf("  hash %016llX, %s profile at %i cycles per frame (%s)\n", analysis.hash, getQuirkProfileName(analysis.quirkProfile),
+			analysis.cyclesPerFrame, analysis.fromDatabase ? "database" : "heuristics");
+		printf("  %li of %zu bytes reachable%s%s%s%s%s%s%s\n", analysis.reachableBytes, rom.size(),
+			analysis.usesVipHires ? ", VIP hires" : "",
+			analysis.usesSuperChip ? ", SUPER-CHIP instructions" : "",
+			analysis.usesXoChip ? ", XO-CHIP instructions" : "",
+			analysis.shiftsVy ? ", shifts Vy" : "",
+			analysis.reliesOnIndexIncrement ? ", relies on I increments" : "",
+			analysis.reliesOnUnchangedIndex ? ", relies on unchanged I" : "",
+			analysis.jumpsWithOffset ? ", jumps with an offset" : "");
+	}
+
+	return 0;
+}
+
+int main(int argc, char const *argv[])
+{
+	const char *databasePath = "roms/RomDatabase.tsv";
+	std::vector<std::string> paths;
+
+	bool validCommand = argc >= 2 && (strcmp(argv[1], "build") == 0 || strcmp(argv[1], "analyze") == 0);
+
+	for (int i = 2; validCommand && i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--output") == 0 || strcmp(argv[i], "--database") == 0) && i + 1 < argc)
+			databasePath = argv[++i];
+		else if (argv[i][0] == '-')
+			validCommand = false;
+		else
+			paths.push_back(argv[i]);
+	}
+
+	if (!validCommand || (strcmp(argv[1], "analyze") == 0 && paths.empty()))
+	{
+		printf("Usage: %s build [directories...] [--output roms/RomDatabase.tsv]\n", argv[0]);
+		printf("       %s analyze rom.ch8 [...] [--database roms/RomDatabase.tsv]\n", argv[0]);
+		return -1;
+	}
+
+	if (strcmp(argv[1], "analyze") == 0)
+		return analyze(paths, databasePath);
+
+	if (paths.empty())
+		paths = { "roms/games", "roms/demos", "roms/programs", "roms/hires" };
+
+	return build(paths, databasePath);
+}
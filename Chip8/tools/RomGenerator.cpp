@@ -0,0 +1,501 @@
+#include "Chip8/Utility/Assembler.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/Hash.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Generates synthetic benchmark ROMs with a controlled OpCode mix. Next to every ROM a .txt file lists the expected
+// final state once the program reaches its halt loop (a jump to itself). Registers that depend on interpreter quirks
+// (VF after logic operations, I after Fx55 / Fx65) are deliberately left out of the expected state.
+// Usage: Chip8RomGenerator <alu|drw|scroll|call|memstream|selfmod|all> [--outer N] [--inner N] [--height N] [--depth N]
+//                          [--registers N] [--output path]
+struct GeneratorSettings
+{
+	int outer = 50;		// Outer loop iterations (1..255)
+	int inner = 200;	// Inner loop iterations (1..255)
+	int height = 8;		// Sprite height for the DRW workload (1..15)
+	int depth = 8;		// Call depth for the CALL / RET workload (1..15)
+	int registers = 8;	// Highest register index + 1 for the Fx55 / Fx65 workload (1..13)
+
+	long iterations() const { return static_cast<long>(outer) * inner; }
+};
+
+class ExpectedState
+{
+public:
+	void add(const char *key, long value)
+	{
+		char line[128];
+		snprintf(line, sizeof(line), "%s %li\n", key, value);
+		m_text += line;
+	}
+
+	void addHex(const char *key, unsigned long long value)
+	{
+		char line[128];
+		snprintf(line, sizeof(line), "%s 0x%02llX\n", key, value);
+		m_text += line;
+	}
+
+	void addRegister(byte index, byte value)
+	{
+		char key[8];
+		snprintf(key, sizeof(key), "V%X", index);
+		addHex(key, value);
+	}
+
+	void addMemory(word address, byte value)
+	{
+		char key[32];
+		snprintf(key, sizeof(key), "memory[0x%03X]", address);
+		addHex(key, value);
+	}
+
+	bool save(const char *path) const
+	{
+		FILE *filePtr = fopen(path, "w");
+
+		if (filePtr == nullptr)
+			return false;
+
+		fputs(m_text.c_str(), filePtr);
+		fclose(filePtr);
+		return true;
+	}
+
+private:
+	std::string m_text;
+};
+
+// The loop counters live in VD (outer) and VE (inner), so workloads may use V0 to VC and VF
+struct Loops
+{
+	word outerLoop;
+	word innerLoop;
+};
+
+static Loops beginLoops(Chip8Assembler & assembler, const GeneratorSettings & settings)
+{
+	Loops loops;
+
+	assembler.LD(0xD, static_cast<byte>(settings.outer));
+	loops.outerLoop = assembler.here();
+	assembler.LD(0xE, static_cast<byte>(settings.inner));
+	loops.innerLoop = assembler.here();
+
+	return loops;
+}
+
+static word endLoops(Chip8Assembler & assembler, const Loops & loops)
+{
+	// Decrement the inner counter (7EFF does not touch VF) and jump back until it reaches zero
+	assembler.ADD(0xE, 0xFF);
+	assembler.SE(0xE, 0x00);
+	assembler.JP(loops.innerLoop);
+
+	assembler.ADD(0xD, 0xFF);
+	assembler.SE(0xD, 0x00);
+	assembler.JP(loops.outerLoop);
+
+	// Halt by jumping to the same address forever
+	word halt = assembler.here();
+	assembler.JP(halt);
+
+	return halt;
+}
+
+static void addCommonState(ExpectedState & expected, const char *workload, const GeneratorSettings & settings, word halt)
+{
+	char text[64];
+	snprintf(text, sizeof(text), "workload_%s", workload);
+	expected.add(text, 1);
+	expected.add("iterations", settings.iterations());
+	expected.addHex("PC", halt);
+	expected.addRegister(0xD, 0);
+	expected.addRegister(0xE, 0);
+}
+
+// Pure 8xy* arithmetic and logic
+static word generateAlu(Chip8Assembler & assembler, ExpectedState & expected, const GeneratorSettings & settings)
+{
+	byte v[16] = { 0x01, 0x03, 0x10, 0x5A, 0xFF, 0x80, 0x07, 0xC3 };
+
+	for (byte x = 0; x < 8; ++x)
+		assembler.LD(x, v[x]);
+
+	Loops loops = beginLoops(assembler, settings);
+	assembler.ALU(0x0, 0x1, 0x4);	// ADD V0, V1
+	assembler.ALU(0x2, 0x0, 0x1);	// OR V2, V0
+	assembler.ALU(0x3, 0x1, 0x3);	// XOR V3, V1
+	assembler.ALU(0x4, 0x2, 0x2);	// AND V4, V2
+	assembler.ALU(0x5, 0x1, 0x5);	// SUB V5, V1
+	assembler.ALU(0x6, 0x0, 0x7);	// SUBN V6, V0
+	assembler.ALU(0x7, 0x7, 0x6);	// SHR V7 (x == y, so both shift quirks agree)
+	assembler.ALU(0x4, 0x4, 0xE);	// SHL V4 (x == y)
+	assembler.ADD(0x1, 0x03);		// ADD V1, 3
+	assembler.ALU(0x7, 0x0, 0x4);	// ADD V7, V0
+	word halt = endLoops(assembler, loops);
+
+	// Reference results, VF is overwritten by every flag-setting instruction and therefore not reported
+	for (long i = 0; i < settings.iterations(); ++i)
+	{
+		v[0] = static_cast<byte>(v[0] + v[1]);
+		v[2] |= v[0];
+		v[3] ^= v[1];
+		v[4] &= v[2];
+		v[5] = static_cast<byte>(v[5] - v[1]);
+		v[6] = static_cast<byte>(v[0] - v[6]);
+		v[7] >>= 1;
+		v[4] = static_cast<byte>(v[4] << 1);
+		v[1] = static_cast<byte>(v[1] + 3);
+		v[7] = static_cast<byte>(v[7] + v[0]);
+	}
+
+	addCommonState(expected, "alu", settings, halt);
+	for (byte x = 0; x < 8; ++x)
+		expected.addRegister(x, v[x]);
+
+	return halt;
+}
+
+// Sprite storm, every sprite stays fully on screen so clipping and wrapping quirks agree
+static word generateDrw(Chip8Assembler & assembler, ExpectedState & expected, const GeneratorSettings & settings)
+{
+	byte height = static_cast<byte>(settings.height);
+	byte lastRow = static_cast<byte>(32 - height);
+
+	assembler.LD(0x0, 0x00);
+	assembler.LD(0x1, 0x00);
+	assembler.LD(0x2, 0x38);
+	word loadSprite = assembler.here();
+	assembler.LDI(0x000);	// Patched once the sprite data address is known
+
+	Loops loops = beginLoops(assembler, settings);
+	assembler.DRW(0x0, 0x1, height);
+	assembler.ADD(0x0, 0x08);		// Next column, limited to 0..56 by the AND below
+	assembler.ALU(0x0, 0x2, 0x2);	// AND V0, V2
+	assembler.ADD(0x1, 0x01);		// Next row, back to zero once the sprite would leave the screen
+	assembler.SNE(0x1, static_cast<byte>(lastRow + 1));
+	assembler.LD(0x1, 0x00);
+	word halt = endLoops(assembler, loops);
+
+	word spriteAddress = assembler.here();
+	assembler.patch(loadSprite, 0xA000 | spriteAddress);
+
+	byte sprite[15];
+	for (byte i = 0; i < height; ++i)
+	{
+		sprite[i] = static_cast<byte>(0x81 | (i << 1) | (i << 4));
+		assembler.emitByte(sprite[i]);
+	}
+
+	// Reference framebuffer, one byte per pixel
+	byte framebuffer[64 * 32] = {};
+	byte x = 0;
+	byte y = 0;
+	for (long i = 0; i < settings.iterations(); ++i)
+	{
+		for (byte row = 0; row < height; ++row)
+		{
+			for (byte column = 0; column < 8; ++column)
+			{
+				if ((sprite[row] & (0x80 >> column)) != 0)
+					framebuffer[(y + row) * 64 + x + column] ^= 1;
+			}
+		}
+
+		x = (x + 8) & 0x38;
+		y = (y + 1 == lastRow + 1) ? 0 : y + 1;
+	}
+
+	long pixels = 0;
+	for (byte pixel : framebuffer)
+		pixels += pixel;
+
+	addCommonState(expected, "drw", settings, halt);
+	expected.addRegister(0x0, x);
+	expected.addRegister(0x1, y);
+	expected.addHex("I", spriteAddress);
+	expected.add("pixels", pixels);
+	expected.addHex("framebuffer_hash", hashBytes(framebuffer, sizeof(framebuffer)));
+
+	return halt;
+}
+
+// SUPER-CHIP 128x64 display: a 16x16 sprite followed by scrolling right, down, and left every iteration. The sprite
+// stays fully on screen so clipping and wrapping quirks agree.
+static word generateScroll(Chip8Assembler & assembler, ExpectedState & expected, const GeneratorSettings & settings)
+{
+	assembler.HIGH();
+	assembler.LD(0x0, 0x00);
+	assembler.LD(0x1, 0x00);
+	assembler.LD(0x2, 0x6F);
+	assembler.LD(0x3, 0x2F);
+	word loadSprite = assembler.here();
+	assembler.LDI(0x000);	// Patched once the sprite data address is known
+
+	Loops loops = beginLoops(assembler, settings);
+	assembler.DRW(0x0, 0x1, 0);
+	assembler.SCR();
+	assembler.SCD(1);
+	assembler.SCL();
+	assembler.ADD(0x0, 0x0D);		// Next column, limited to 0..111 by the AND below
+	assembler.ALU(0x0, 0x2, 0x2);	// AND V0, V2
+	assembler.ADD(0x1, 0x05);		// Next row, limited to 0..47
+	assembler.ALU(0x1, 0x3, 0x2);	// AND V1, V3
+	word halt = endLoops(assembler, loops);
+
+	word spriteAddress = assembler.here();
+	assembler.patch(loadSprite, 0xA000 | spriteAddress);
+
+	word sprite[16];
+	for (byte i = 0; i < 16; ++i)
+	{
+		sprite[i] = static_cast<word>(0x8001 | (i << 1) | (i << 6) | (i << 11));
+		assembler.emitByte(static_cast<byte>(sprite[i] >> 8));
+		assembler.emitByte(static_cast<byte>(sprite[i] & 0xFF));
+	}
+
+	// Reference framebuffer, one byte per pixel, scrolls shift in blank pixels
+	const int WIDTH = 128;
+	const int HEIGHT = 64;
+	std::vector<byte> framebuffer(WIDTH * HEIGHT, 0);
+	byte x = 0;
+	byte y = 0;
+	for (long i = 0; i < settings.iterations(); ++i)
+	{
+		for (int row = 0; row < 16; ++row)
+		{
+			for (int column = 0; column < 16; ++column)
+			{
+				if ((sprite[row] & (0x8000 >> column)) != 0)
+					framebuffer[(y + row) * WIDTH + x + column] ^= 1;
+			}
+		}
+
+		for (int row = 0; row < HEIGHT; ++row)
+		{
+			byte *line = &framebuffer[row * WIDTH];
+			std::copy_backward(line, line + WIDTH - 4, line + WIDTH);
+			std::fill(line, line + 4, 0);
+		}
+
+		std::copy_backward(framebuffer.begin(), framebuffer.end() - WIDTH, framebuffer.end());
+		std::fill(framebuffer.begin(), framebuffer.begin() + WIDTH, 0);
+
+		for (int row = 0; row < HEIGHT; ++row)
+		{
+			byte *line = &framebuffer[row * WIDTH];
+			std::copy(line + 4, line + WIDTH, line);
+			std::fill(line + WIDTH - 4, line + WIDTH, 0);
+		}
+
+		x = (x + 0x0D) & 0x6F;
+		y = (y + 0x05) & 0x2F;
+	}
+
+	long pixels = 0;
+	for (byte pixel : framebuffer)
+		pixels += pixel;
+
+	addCommonState(expected, "scroll", settings, halt);
+	expected.addRegister(0x0, x);
+	expected.addRegister(0x1, y);
+	expected.addHex("I", spriteAddress);
+	expected.add("pixels", pixels);
+	expected.addHex("framebuffer_hash", hashBytes(framebuffer.data(), framebuffer.size()));
+
+	return halt;
+}
+
+// Nested subroutine calls, each level increments V0 on the way in and V1 on the way out
+static word generateCall(Chip8Assembler & assembler, ExpectedState & expected, const GeneratorSettings & settings)
+{
+	assembler.LD(0x0, 0x00);
+	assembler.LD(0x1, 0x00);
+
+	Loops loops = beginLoops(assembler, settings);
+	word firstCall = assembler.here();
+	assembler.CALL(0x000);	// Patched once the first subroutine address is known
+	word halt = endLoops(assembler, loops);
+
+	std::vector<word> callSites;
+	for (int level = 0; level < settings.depth; ++level)
+	{
+		if (level == 0)
+			assembler.patch(firstCall, 0x2000 | assembler.here());
+		else
+			assembler.patch(callSites.back(), 0x2000 | assembler.here());
+
+		assembler.ADD(0x0, 0x01);
+
+		if (level + 1 < settings.depth)
+		{
+			callSites.push_back(assembler.here());
+			assembler.CALL(0x000);
+		}
+
+		assembler.ADD(0x1, 0x01);
+		assembler.RET();
+	}
+
+	byte calls = static_cast<byte>(settings.iterations() * settings.depth);
+
+	addCommonState(expected, "call", settings, halt);
+	expected.addRegister(0x0, calls);
+	expected.addRegister(0x1, calls);
+
+	return halt;
+}
+
+// Fx55 / Fx65 streaming of V0..Vx through a buffer, I is reloaded before every access so I increment quirks agree
+static word generateMemoryStream(Chip8Assembler & assembler, ExpectedState & expected, const GeneratorSettings & settings)
+{
+	const word BUFFER_ADDRESS = 0xE00;
+	byte lastRegister = static_cast<byte>(settings.registers - 1);
+
+	byte v[16] = {};
+	for (byte x = 0; x <= lastRegister; ++x)
+	{
+		v[x] = static_cast<byte>(x * 0x11);
+		assembler.LD(x, v[x]);
+	}
+
+	Loops loops = beginLoops(assembler, settings);
+	assembler.ADD(0x0, 0x01);
+	assembler.LDI(BUFFER_ADDRESS);
+	assembler.STORE(lastRegister);
+	assembler.LDI(BUFFER_ADDRESS);
+	assembler.LOAD(lastRegister);
+	word halt = endLoops(assembler, loops);
+
+	v[0] = static_cast<byte>(v[0] + settings.iterations());
+
+	addCommonState(expected, "memstream", settings, halt);
+	for (byte x = 0; x <= lastRegister; ++x)
+	{
+		expected.addRegister(x, v[x]);
+		expected.addMemory(BUFFER_ADDRESS + x, v[x]);
+	}
+
+	return halt;
+}
+
+// Self-modifying code, every iteration increments the immediate operand of the first instruction in the loop
+static word generateSelfModifying(Chip8Assembler & assembler, ExpectedState & expected, const GeneratorSettings & settings)
+{
+	Loops loops = beginLoops(assembler, settings);
+	word modifiedInstruction = assembler.here();
+	assembler.LD(0x1, 0x00);			// The "00" is rewritten at runtime
+	assembler.LDI(modifiedInstruction + 1);
+	assembler.LOAD(0x0);
+	assembler.ADD(0x0, 0x01);
+	assembler.LDI(modifiedInstruction + 1);	// Reloaded, so I increment quirks agree
+	assembler.STORE(0x0);
+	word halt = endLoops(assembler, loops);
+
+	byte total = static_cast<byte>(settings.iterations());
+
+	addCommonState(expected, "selfmod", settings, halt);
+	expected.addRegister(0x0, total);
+	expected.addRegister(0x1, static_cast<byte>(total - 1));
+	expected.addMemory(modifiedInstruction + 1, total);
+
+	return halt;
+}
+
+static bool generate(const std::string & workload, const GeneratorSettings & settings, const std::string & outputPath)
+{
+	Chip8Assembler assembler;
+	ExpectedState expected;
+
+	if (workload == "alu")
+		generateAlu(assembler, expected, settings);
+	else if (workload == "drw")
+		generateDrw(assembler, expected, settings);
+	else if (workload == "scroll")
+		generateScroll(assembler, expected, settings);
+	else if (workload == "call")
+		generateCall(assembler, expected, settings);
+	else if (workload == "memstream")
+		generateMemoryStream(assembler, expected, settings);
+	else if (workload == "selfmod")
+		generateSelfModifying(assembler, expected, settings);
+	else
+	{
+		printf("Unknown workload %s.\n", workload.c_str());
+		return false;
+	}
+
+	std::string romPath = outputPath + ".ch8";
+	std::string expectedPath = outputPath + ".txt";
+
+	if (!assembler.save(romPath.c_str()) || !expected.save(expectedPath.c_str()))
+	{
+		printf("Failed to write %s.\n", romPath.c_str());
+		return false;
+	}
+
+	printf("Generated %s (%zu bytes).\n", romPath.c_str(), assembler.getBytes().size());
+	return true;
+}
+
+int main(int argc, char const *argv[])
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <alu|drw|scroll|call|memstream|selfmod|all> [--outer N] [--inner N] [--height N] [--depth N]\n", argv[0]);
+		printf("       [--registers N] [--output path without extension]\n");
+		return -1;
+	}
+
+	std::string workload = argv[1];
+	std::string outputPath;
+	GeneratorSettings settings;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--outer") == 0 && i + 1 < argc)
+			settings.outer = std::min(255, std::max(1, atoi(argv[++i])));
+		else if (strcmp(argv[i], "--inner") == 0 && i + 1 < argc)
+			settings.inner = std::min(255, std::max(1, atoi(argv[++i])));
+		else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+			settings.height = std::min(15, std::max(1, atoi(argv[++i])));
+		else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+			settings.depth = std::min(15, std::max(1, atoi(argv[++i])));
+		else if (strcmp(argv[i], "--registers") == 0 && i + 1 < argc)
+			settings.registers = std::min(13, std::max(1, atoi(argv[++i])));
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			outputPath = argv[++i];
+		else
+		{
+			printf("Unknown argument %s.\n", argv[i]);
+			return -1;
+		}
+	}
+
+	// "all" generates the standard suite with the current settings into the output directory
+	if (workload == "all")
+	{
+		std::string directory = outputPath.empty() ? "." : outputPath;
+		const char *workloads[] = { "alu", "drw", "scroll", "call", "memstream", "selfmod" };
+
+		for (const char *name : workloads)
+		{
+			if (!generate(name, settings, directory + "/synthetic_" + name))
+				return -1;
+		}
+
+		return 0;
+	}
+
+	if (outputPath.empty())
+		outputPath = "synthetic_" + workload;
+
+	return generate(workload, settings, outputPath) ? 0 : -1;
+}
@@ -0,0 +1,76 @@
+#include "Chip8/Emulator/HeadlessRunner.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/RomLibrary.hpp"
+
+#include <chrono>
+#include <cstring>
+
+// Lists the ROM library, scanning the directory only when the index is missing or belongs to another directory. With
+// --check every ROM is mapped and loaded into a processor, which finds files that changed since the index was written.
+// Usage: Chip8RomLibrary [directory] [--index RomLibrary.idx] [--rescan] [--check]
+int main(int argc, char const *argv[])
+{
+	const char *directory = "roms";
+	const char *indexPath = "RomLibrary.idx";
+	bool rescan = false;
+	bool check = false;
+	bool validArguments = true;
+	bool hasDirectory = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--index") == 0 && i + 1 < argc)
+			indexPath = argv[++i];
+		else if (strcmp(argv[i], "--rescan") == 0)
+			rescan = true;
+		else if (strcmp(argv[i], "--check") == 0)
+			check = true;
+		else if (argv[i][0] != '-' && !hasDirectory)
+		{
+			directory = argv[i];
+			hasDirectory = true;
+		}
+		else
+			validArguments = false;
+	}
+
+	if (!validArguments)
+	{
+		printf("Usage: %s [directory] [--index RomLibrary.idx] [--rescan] [--check]\n", argv[0]);
+		return -1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	Chip8RomLibrary library;
+	bool opened = rescan ? library.scan(directory) && library.saveIndex(indexPath) : library.open(directory, indexPath);
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (!opened)
+	{
+		printf("Failed to open the ROM library in %s.\n", directory);
+		return -1;
+	}
+
+	long failed = 0;
+	for (const Chip8RomLibraryEntry & entry : library.getEntries())
+	{
+		printf("%016llX %6lli %4i %-40s %-24s %s\n", entry.hash, entry.size, entry.year, entry.title.c_str(), entry.author.c_str(),
+			entry.description.c_str());
+
+		if (!check)
+			continue;
+
+		Chip8RomMapping mapping;
+		HeadlessRunner runner;
+		if (!library.map(entry, mapping) || !runner.loadGame(mapping.getData(), mapping.getSize()))
+		{
+			printf("  %s changed or does not fit into memory.\n", entry.path.c_str());
+			++failed;
+		}
+	}
+
+	fprintf(stderr, "%zu ROMs opened in %.2f ms.\n", library.getEntries().size(), milliseconds);
+	return failed == 0 ? 0 : -1;
+}
@@ -0,0 +1,175 @@
+#include "Chip8/Emulator/DirtyRegion.hpp"
+#include "Chip8/Emulator/TerminalDisplayBackend.hpp"
+#include "Chip8/Utility/DataTypes.hpp"
+#include "Chip8/Utility/FrameStream.hpp"
+#include "Chip8/Utility/ImageWriter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Inspects and replays frame streams written by Chip8 --record and Chip8Recorder --format stream.
+// Usage: Chip8Stream info stream.c8fs
+//        Chip8Stream extract stream.c8fs frame output.png [--scale N]
+//        Chip8Stream play stream.c8fs [--from frame] [--braille]
+static int printInfo(FrameStreamReader & reader)
+{
+	printf("%ix%i pixels, %li frames (%.1f seconds), keyframe every %i frames%s.\n",
+		reader.getWidth(), reader.getHeight(), reader.getFrameCount(), reader.getFrameCount() / 60.0,
+		reader.getKeyframeInterval(), reader.wasIndexRebuilt() ? ", index rebuilt because the recording was not closed" : "");
+
+	// Every display size change starts a keyframe
+	int width = reader.getWidth();
+	int height = reader.getHeight();
+
+	for (const FrameStreamKeyframe & keyframe : reader.getKeyframes())
+	{
+		if (keyframe.width == width && keyframe.height == height)
+			continue;
+
+		width = keyframe.width;
+		height = keyframe.height;
+		printf("Frame %li switches the display to %ix%i pixels.\n", keyframe.frame, width, height);
+	}
+
+	return 0;
+}
+
+static int extractFrame(FrameStreamReader & reader, long frame, const char *outputPath, int scale)
+{
+	std::vector<qword> graphicsMemory(reader.getMaxWordCount());
+
+	if (!reader.readFrame(frame, graphicsMemory.data()))
+	{
+		printf("Frame %li is not in the stream (%li frames).\n", frame, reader.getFrameCount());
+		return -1;
+	}
+
+	std::vector<byte> png;
+	encodePng(graphicsMemory.data(), reader.getWidth(), reader.getHeight(), scale, 0xFFFFFF, 0x000000, png);
+
+	FILE *filePtr = fopen(outputPath, "wb");
+	if (filePtr == nullptr)
+	{
+		printf("Failed to create %s.\n", outputPath);
+		return -1;
+	}
+
+	bool success = fwrite(png.data(), 1, png.size(), filePtr) == png.size();
+	success = fclose(filePtr) == 0 && success;
+
+	if (!success)
+	{
+		printf("Failed to write %s.\n", outputPath);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int play(FrameStreamReader & reader, long firstFrame, TerminalCells cells)
+{
+	TerminalDisplayBackend backend;
+	if (!backend.create(cells))
+	{
+		printf("Failed to set up the terminal.\n");
+		return -1;
+	}
+
+	std::vector<qword> graphicsMemory(reader.getMaxWordCount());
+
+	// The whole display is redrawn, the terminal backend only sends the cells that changed
+	DirtyRegion dirtyRegion;
+	int width = 0;
+	int height = 0;
+
+	const std::chrono::duration<double> FRAME_DURATION(1.0 / 60.0);
+	std::chrono::steady_clock::time_point nextFrame = std::chrono::steady_clock::now();
+
+	// Frames are read sequentially, so every frame only decodes its own delta
+	for (long frame = firstFrame; frame < reader.getFrameCount() && !backend.shouldClose(); ++frame)
+	{
+		if (!reader.readFrame(frame, graphicsMemory.data()))
+			break;
+
+		if (reader.getWidth() != width || reader.getHeight() != height)
+		{
+			width = reader.getWidth();
+			height = reader.getHeight();
+			backend.setDisplaySize(width, height, 1);
+
+			dirtyRegion.clear();
+			dirtyRegion.addAll(static_cast<byte>(width), static_cast<byte>(height));
+		}
+
+		backend.updatePixels(graphicsMemory.data(), dirtyRegion);
+		backend.present();
+		backend.pollEvents();
+
+		nextFrame += std::chrono::duration_cast<std::chrono::steady_clock::duration>(FRAME_DURATION);
+		std::this_thread::sleep_until(nextFrame);
+	}
+
+	backend.destroy();
+
+	return 0;
+}
+
+static int printUsage(const char *name)
+{
+	printf("Usage: %s info stream.c8fs\n", name);
+	printf("       %s extract stream.c8fs frame output.png [--scale N]\n", name);
+	printf("       %s play stream.c8fs [--from frame] [--braille]\n", name);
+	return -1;
+}
+
+int main(int argc, char const *argv[])
+{
+	if (argc < 3)
+		return printUsage(argv[0]);
+
+	const char *command = argv[1];
+	const char *streamPath = argv[2];
+
+	FrameStreamReader reader;
+	if (!reader.open(streamPath))
+	{
+		printf("Failed to read the frame stream %s.\n", streamPath);
+		return -1;
+	}
+
+	if (strcmp(command, "info") == 0)
+		return printInfo(reader);
+
+	if (strcmp(command, "extract") == 0 && argc >= 5)
+	{
+		int scale = 4;
+		for (int i = 5; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+				scale = std::max(1, atoi(argv[++i]));
+		}
+
+		return extractFrame(reader, atol(argv[3]), argv[4], scale);
+	}
+
+	if (strcmp(command, "play") == 0)
+	{
+		long firstFrame = 0;
+		TerminalCells cells = TerminalCells::HALF_BLOCKS;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "--from") == 0 && i + 1 < argc)
+				firstFrame = std::max(0L, atol(argv[++i]));
+			else if (strcmp(argv[i], "--braille") == 0)
+				cells = TerminalCells::BRAILLE;
+		}
+
+		return play(reader, firstFrame, cells);
+	}
+
+	return printUsage(argv[0]);
+}